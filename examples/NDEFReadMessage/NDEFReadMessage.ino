@@ -27,6 +27,11 @@ void displayRecordInfo(NdefRecord record);
 Electroniccats_PN7150 nfc(PN7150_IRQ, PN7150_VEN, PN7150_ADDR);
 NdefMessage message;
 
+// Messages up to 500 bytes fit in the buffer of the library, this one reads tags up to 2 KB. A #define of
+// RW_MAX_NDEF_FILE_SIZE or PN7150_MAX_DATA_SIZE here does not reach the library, use PlatformIO build_flags:
+//   build_flags = -DRW_MAX_NDEF_FILE_SIZE=2048 -DPN7150_MAX_DATA_SIZE=2100
+uint8_t ndefBuffer[2048];
+
 void setup() {
   Serial.begin(9600);
   while (!Serial)
@@ -35,6 +40,7 @@ void setup() {
 
   // Register a callback function to be called when an NDEF message is received
   nfc.setReadMsgCallback(messageReceivedCallback);
+  nfc.setNdefBuffer(ndefBuffer, sizeof(ndefBuffer));
 
   Serial.println("Initializing...");
 
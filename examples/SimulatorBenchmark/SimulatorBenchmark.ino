@@ -0,0 +1,126 @@
+/**
+ * Example to measure the time the library spends detecting and reading tags, without a PN7150.
+ * The controller and the tags are simulated, so the numbers are the overhead of the driver alone
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+
+#define ITERATIONS 20
+
+// Function prototypes
+void ndefReceived(unsigned char *message, unsigned short messageLength);
+void benchmark(const char *name, NciVirtualTag *tag);
+
+NciSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);  // The simulator replaces the I2C bus, no pins are used
+
+// URI record "https://www.electroniccats.com"
+const uint8_t ndefMessage[] = {0xD1, 0x01, 0x13, 0x55, 0x02, 'e', 'l', 'e', 'c', 't', 'r', 'o', 'n', 'i', 'c', 'c', 'a', 't', 's', '.', 'c', 'o', 'm'};
+
+uint8_t t2tMemory[144];  // NTAG213
+uint8_t t4tMemory[256];
+uint8_t mifareMemory[1024];  // MIFARE Classic 1K
+uint8_t t3tMemory[256];
+uint8_t iso15693Memory[128];
+
+NciVirtualTag t2t = {PROT_T2T, {0x04, 0x3C, 0x9A, 0x12, 0x6B, 0x51, 0x80}, 7, t2tMemory, sizeof(t2tMemory), 0};
+NciVirtualTag t4t = {PROT_ISODEP, {0x04, 0x51, 0x2E, 0x6A, 0x93, 0x1F, 0x80}, 7, t4tMemory, sizeof(t4tMemory), 0};
+NciVirtualTag mifare = {PROT_MIFARE, {0xB3, 0x2F, 0x61, 0x0A}, 4, mifareMemory, sizeof(mifareMemory), 0};
+NciVirtualTag t3t = {PROT_T3T, {0x01, 0x2E, 0x45, 0x7C, 0x1B, 0x2D, 0x3F, 0x00}, 8, t3tMemory, sizeof(t3tMemory), 0};
+NciVirtualTag iso15693 = {PROT_ISO15693, {0x5A, 0x3B, 0x12, 0x00, 0x01, 0x04, 0xE0, 0xE0}, 8, iso15693Memory, sizeof(iso15693Memory), 0};
+
+volatile unsigned short receivedLength;
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial)
+    ;
+  Serial.println("Benchmark the PN7150 library with a simulated controller");
+
+  NciSimulator::formatTag(&t2t, ndefMessage, sizeof(ndefMessage));
+  NciSimulator::formatTag(&t4t, ndefMessage, sizeof(ndefMessage));
+  NciSimulator::formatTag(&mifare, ndefMessage, sizeof(ndefMessage));
+  NciSimulator::formatTag(&t3t, ndefMessage, sizeof(ndefMessage));
+  NciSimulator::formatTag(&iso15693, ndefMessage, sizeof(ndefMessage));
+
+  // Called by every NDEF reader (T2T, T3T, T4T, MIFARE) with the raw message
+  RW_NDEF_RegisterPullCallback((void *)ndefReceived);
+
+  if (nfc.begin()) {
+    Serial.println("Error initializing PN7150");
+    while (true)
+      ;
+  }
+  nfc.setReaderWriterMode();
+
+  benchmark("T2T", &t2t);
+  benchmark("T4T", &t4t);
+  benchmark("MIFARE", &mifare);
+  benchmark("T3T", &t3t);
+  benchmark("ISO15693", &iso15693);
+
+  Serial.print("Dropped frames: ");
+  Serial.println(simulator.getDroppedFrames());
+}
+
+void loop() {
+}
+
+void ndefReceived(unsigned char *message, unsigned short messageLength) {
+  (void)message;
+  receivedLength = messageLength;
+}
+
+/// @brief Put the tag in the field, time its detection and the reading of its NDEF message, then take it away
+void benchmark(const char *name, NciVirtualTag *tag) {
+  unsigned long detectTime = 0;
+  unsigned long readTime = 0;
+  unsigned long start;
+  uint8_t reads = 0;
+
+  for (uint8_t i = 0; i < ITERATIONS; i++) {
+    simulator.addTag(tag);
+
+    start = micros();
+    if (!nfc.isTagDetected()) {
+      Serial.print(name);
+      Serial.println(": not detected");
+      simulator.removeAllTags();
+      return;
+    }
+    detectTime += micros() - start;
+
+    // There is no NDEF reader for ISO15693 tags
+    if (nfc.remoteDevice.getProtocol() != nfc.protocol.ISO15693) {
+      receivedLength = 0;
+      start = micros();
+      nfc.readNdefMessage();
+      readTime += micros() - start;
+      if (receivedLength == sizeof(ndefMessage))
+        reads++;
+    }
+
+    simulator.removeAllTags();
+    nfc.reset();
+  }
+
+  Serial.print(name);
+  Serial.print(": detection ");
+  Serial.print(detectTime / ITERATIONS);
+  Serial.print(" us, NDEF read ");
+  Serial.print(readTime / ITERATIONS);
+  Serial.print(" us, ");
+  Serial.print(reads);
+  Serial.print("/");
+  Serial.print(ITERATIONS);
+  Serial.println(" messages read");
+}
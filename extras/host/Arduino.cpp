@@ -0,0 +1,185 @@
+/**
+ * Library to build the PN7150 driver on a desktop host, the few Arduino core functions it uses
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Arduino.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include "Wire.h"
+
+HostSerial Serial;
+TwoWire Wire;
+
+static unsigned long long monotonicMicros() {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long long)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+static const unsigned long long startMicros = monotonicMicros();
+
+unsigned long millis() {
+  return (unsigned long)((monotonicMicros() - startMicros) / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)(monotonicMicros() - startMicros);
+}
+
+void delay(unsigned long ms) {
+  usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  usleep(us);
+}
+
+void yield() {
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  (void)pin;
+  (void)value;
+}
+
+int digitalRead(uint8_t pin) {
+  (void)pin;
+  return LOW;
+}
+
+void attachInterrupt(int interruptNumber, void (*handler)(void), int mode) {
+  (void)interruptNumber;
+  (void)handler;
+  (void)mode;
+}
+
+void detachInterrupt(int interruptNumber) {
+  (void)interruptNumber;
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+static std::string signedText(long long value, unsigned long long bits, int base) {
+  char text[24];
+
+  if (base == HEX)
+    snprintf(text, sizeof(text), "%llx", bits);  // two's complement, as on the boards
+  else
+    snprintf(text, sizeof(text), "%lld", value);
+  return text;
+}
+
+static std::string unsignedText(unsigned long long value, int base) {
+  char text[24];
+
+  snprintf(text, sizeof(text), (base == HEX) ? "%llx" : "%llu", value);
+  return text;
+}
+
+String::String(int value, int base) : _value(signedText(value, (unsigned int)value, base)) {}
+
+String::String(unsigned int value, int base) : _value(unsignedText(value, base)) {}
+
+String::String(long value, int base) : _value(signedText(value, (unsigned long)value, base)) {}
+
+String::String(unsigned long value, int base) : _value(unsignedText(value, base)) {}
+
+String::String(unsigned char value, int base) : _value(unsignedText(value, base)) {}
+
+String String::substring(unsigned int from) const {
+  return (from < _value.size()) ? String(_value.substr(from)) : String();
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if ((from >= _value.size()) || (to <= from))
+    return String();
+  return String(_value.substr(from, to - from));
+}
+
+void String::toUpperCase() {
+  for (size_t i = 0; i < _value.size(); i++)
+    _value[i] = toupper((unsigned char)_value[i]);
+}
+
+void String::trim() {
+  size_t first = _value.find_first_not_of(" \t\r\n");
+  size_t last = _value.find_last_not_of(" \t\r\n");
+
+  if (first == std::string::npos)
+    _value.clear();
+  else
+    _value = _value.substr(first, last - first + 1);
+}
+
+String &String::operator+=(const String &other) {
+  _value += other._value;
+  return *this;
+}
+
+String &String::operator+=(const char *other) {
+  if (other != NULL)
+    _value += other;
+  return *this;
+}
+
+String &String::operator+=(char other) {
+  _value += other;
+  return *this;
+}
+
+String operator+(const String &left, const String &right) {
+  return String(left._value + right._value);
+}
+
+void HostSerial::print(const String &value) {
+  fputs(value.c_str(), stdout);
+}
+
+void HostSerial::print(const char *value) {
+  fputs(value, stdout);
+}
+
+void HostSerial::print(char value) {
+  fputc(value, stdout);
+}
+
+void HostSerial::print(int value, int base) {
+  print(String(value, base));
+}
+
+void HostSerial::print(unsigned int value, int base) {
+  print(String(value, base));
+}
+
+void HostSerial::print(long value, int base) {
+  print(String(value, base));
+}
+
+void HostSerial::print(unsigned long value, int base) {
+  print(String(value, base));
+}
+
+void HostSerial::println() {
+  fputc('\n', stdout);
+}
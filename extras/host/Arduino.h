@@ -0,0 +1,123 @@
+/**
+ * Library to build the PN7150 driver on a desktop host, the few Arduino core functions it uses
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define NOT_AN_INTERRUPT -1
+#define DEC 10
+#define HEX 16
+
+/* Time is taken from the host clock, delay() sleeps */
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+/* There are no pins, reads are LOW and interrupts are never raised */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+inline int digitalPinToInterrupt(uint8_t pin) {
+  (void)pin;
+  return NOT_AN_INTERRUPT;
+}
+void attachInterrupt(int interruptNumber, void (*handler)(void), int mode);
+void detachInterrupt(int interruptNumber);
+void noInterrupts();
+void interrupts();
+
+/*
+ * Arduino String on top of std::string, only what the library uses
+ */
+class String {
+ private:
+  std::string _value;
+
+ public:
+  String() {}
+  String(const char *value) : _value(value != NULL ? value : "") {}
+  String(const std::string &value) : _value(value) {}
+  explicit String(char value) : _value(1, value) {}
+  String(int value, int base = DEC);
+  String(unsigned int value, int base = DEC);
+  String(long value, int base = DEC);
+  String(unsigned long value, int base = DEC);
+  String(unsigned char value, int base = DEC);
+
+  unsigned int length() const { return _value.size(); }
+  const char *c_str() const { return _value.c_str(); }
+  bool startsWith(const String &prefix) const { return _value.compare(0, prefix._value.size(), prefix._value) == 0; }
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  void toUpperCase();
+  void trim();
+  char operator[](unsigned int index) const { return index < _value.size() ? _value[index] : 0; }
+  String &operator+=(const String &other);
+  String &operator+=(const char *other);
+  String &operator+=(char other);
+  bool operator==(const String &other) const { return _value == other._value; }
+  bool operator!=(const String &other) const { return _value != other._value; }
+  friend String operator+(const String &left, const String &right);
+};
+
+/*
+ * Serial writes to the standard output
+ */
+class HostSerial {
+ public:
+  void begin(unsigned long baud) { (void)baud; }
+  operator bool() const { return true; }
+  void print(const String &value);
+  void print(const char *value);
+  void print(char value);
+  void print(int value, int base = DEC);
+  void print(unsigned int value, int base = DEC);
+  void print(long value, int base = DEC);
+  void print(unsigned long value, int base = DEC);
+  void println();
+  template <typename T>
+  void println(T value) {
+    print(value);
+    println();
+  }
+  template <typename T>
+  void println(T value, int base) {
+    print(value, base);
+    println();
+  }
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * Library to build the PN7150 driver on a desktop host, a Wire bus with no device on it
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef Wire_h
+#define Wire_h
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+/*
+ * Every address is NACKed and nothing is ever read, the driver is tested through
+ * NciSimulator instead of TwoWireTransport
+ */
+class TwoWire {
+ public:
+  void begin() {}
+  void setClock(uint32_t frequency) { (void)frequency; }
+  void beginTransmission(uint8_t address) { (void)address; }
+  uint8_t endTransmission(bool sendStop = true) {
+    (void)sendStop;
+    return 2;
+  }
+  size_t write(uint8_t value) {
+    (void)value;
+    return 1;
+  }
+  size_t write(const uint8_t *data, size_t length) {
+    (void)data;
+    return length;
+  }
+  uint8_t requestFrom(uint8_t address, uint8_t quantity) {
+    (void)address;
+    (void)quantity;
+    return 0;
+  }
+  int available() { return 0; }
+  int read() { return -1; }
+  size_t readBytes(uint8_t *buffer, size_t length) {
+    (void)buffer;
+    (void)length;
+    return 0;
+  }
+};
+
+extern TwoWire Wire;
+
+#endif
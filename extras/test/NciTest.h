@@ -0,0 +1,136 @@
+/**
+ * Library to check the PN7150 driver against the simulated controller on a desktop host
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciTest_H
+#define NciTest_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "NciSimulator.h"
+
+static int nciTestFailures = 0;
+
+#define CHECK(condition)                                                      \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);    \
+      nciTestFailures++;                                                      \
+    }                                                                         \
+  } while (0)
+
+#define CHECK_EQUAL(expected, actual)                                                                        \
+  do {                                                                                                       \
+    long long expectedValue = (long long)(expected);                                                         \
+    long long actualValue = (long long)(actual);                                                             \
+    if (expectedValue != actualValue) {                                                                      \
+      printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actualValue, expectedValue); \
+      nciTestFailures++;                                                                                     \
+    }                                                                                                        \
+  } while (0)
+
+#define CHECK_BYTES(expected, actual, length)                                                \
+  do {                                                                                       \
+    if (memcmp((expected), (actual), (length)) != 0) {                                       \
+      printf("%s:%d: %s differs from %s\n", __FILE__, __LINE__, #actual, #expected);         \
+      nciTestFailures++;                                                                     \
+    }                                                                                        \
+  } while (0)
+
+/// @brief Exit code of the test program, 0 when every check passed
+static inline int nciTestResult(const char *name) {
+  printf("%s: %s (%d failed checks)\n", name, nciTestFailures ? "FAILED" : "passed", nciTestFailures);
+  return nciTestFailures ? 1 : 0;
+}
+
+/*
+ * Simulated controller that keeps a copy of every frame exchanged with the driver
+ */
+class RecordingSimulator : public NciSimulator {
+ public:
+  struct Frame {
+    bool written;  // true from the driver to the controller
+    std::vector<uint8_t> bytes;
+  };
+  std::vector<Frame> frames;
+
+  uint8_t writeFrame(const uint8_t *frame, uint16_t length) {
+    record(true, frame, length);
+    return NciSimulator::writeFrame(frame, length);
+  }
+
+  uint16_t readFrame(uint8_t *frame) {
+    uint16_t length;
+
+    if (!held.empty()) {
+      length = held.size();
+      memcpy(frame, held.data(), length);
+      held.clear();
+    } else {
+      length = NciSimulator::readFrame(frame);
+      if ((length > 0) && !injected.empty() && ((frame[0] & 0xE0) == 0x40)) {
+        held.assign(frame, frame + length);  // the response comes after the notification
+        length = injected.size();
+        memcpy(frame, injected.data(), length);
+      }
+    }
+    if (length > 0)
+      record(false, frame, length);
+    return length;
+  }
+
+  bool isIrqActive() {
+    return !held.empty() || NciSimulator::isIrqActive();
+  }
+
+  /// @brief Deliver this notification before every response, until called with a length of 0
+  void notifyBeforeResponses(const uint8_t *frame, uint16_t length) {
+    injected.assign(frame, frame + length);
+  }
+
+  /// @brief Payloads of the data packets sent in one direction, in order
+  std::vector<std::vector<uint8_t> > dataPayloads(bool written) const {
+    std::vector<std::vector<uint8_t> > payloads;
+    for (size_t i = 0; i < frames.size(); i++) {
+      const std::vector<uint8_t> &bytes = frames[i].bytes;
+      if ((frames[i].written == written) && ((bytes[0] & 0xE0) == 0x00))
+        payloads.push_back(std::vector<uint8_t>(bytes.begin() + 3, bytes.end()));
+    }
+    return payloads;
+  }
+
+  /// @brief Number of control frames with this header sent in one direction
+  unsigned countControl(bool written, uint8_t header, uint8_t oid) const {
+    unsigned count = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+      if ((frames[i].written == written) && (frames[i].bytes[0] == header) && (frames[i].bytes[1] == oid))
+        count++;
+    }
+    return count;
+  }
+
+ private:
+  std::vector<uint8_t> injected;
+  std::vector<uint8_t> held;
+
+  void record(bool written, const uint8_t *frame, uint16_t length) {
+    Frame copy;
+    copy.written = written;
+    copy.bytes.assign(frame, frame + length);
+    frames.push_back(copy);
+  }
+};
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Card emulation: the APDUs of a simulated phone reading the emulated Type 4 Tag
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+#include "NciTest.h"
+
+RecordingSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);
+
+uint8_t received[512];
+
+const uint8_t selectApp[] = {0x00, 0xA4, 0x04, 0x00, 0x07, 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, 0x00};
+const uint8_t selectCC[] = {0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE1, 0x03};
+const uint8_t readCC[] = {0x00, 0xB0, 0x00, 0x00, 0x0F};
+const uint8_t readLength[] = {0x00, 0xB0, 0x00, 0x00, 0x02};
+
+bool sentCalled;
+
+void messageSent() {
+  sentCalled = true;
+}
+
+bool endsWithOk(const std::vector<uint8_t> &rapdu) {
+  return (rapdu.size() >= 2) && (rapdu[rapdu.size() - 2] == 0x90) && (rapdu[rapdu.size() - 1] == 0x00);
+}
+
+int main() {
+  RfIntf_t rfInterface;
+  NdefMessage message;
+
+  message.begin();
+  message.addTextRecord("Hello");
+  message.addUriRecord("https://www.electroniccats.com");
+  nfc.setSendMsgCallback(messageSent);
+
+  CHECK_EQUAL(SUCCESS, nfc.begin());
+  CHECK(nfc.setEmulationMode());
+  CHECK(simulator.addReader(received, sizeof(received)));
+
+  memset(&rfInterface, 0, sizeof(rfInterface));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+  CHECK_EQUAL(PROT_ISODEP, rfInterface.Protocol);
+  CHECK_EQUAL(INTF_ISODEP, rfInterface.Interface);
+  CHECK_EQUAL(MODE_LISTEN, rfInterface.ModeTech & MODE_MASK);
+
+  simulator.frames.clear();
+  sentCalled = false;
+  nfc.ProcessCardMode(rfInterface);
+
+  /* The reader got the whole message */
+  CHECK(sentCalled);
+  CHECK_EQUAL(message.getContentLength(), simulator.getReaderMessageLength());
+  CHECK_BYTES(message.getContent(), received, message.getContentLength());
+
+  /* One answer per command, in order, all successful */
+  std::vector<std::vector<uint8_t> > capdus = simulator.dataPayloads(false);
+  std::vector<std::vector<uint8_t> > rapdus = simulator.dataPayloads(true);
+  CHECK_EQUAL(capdus.size(), rapdus.size());
+  CHECK(rapdus.size() >= 6);
+  if ((rapdus.size() >= 6) && (capdus.size() == rapdus.size())) {
+    CHECK_EQUAL(sizeof(selectApp), capdus[0].size());
+    CHECK_BYTES(selectApp, capdus[0].data(), sizeof(selectApp));
+    CHECK_BYTES(selectCC, capdus[1].data(), sizeof(selectCC));
+    CHECK_BYTES(readCC, capdus[2].data(), sizeof(readCC));
+    CHECK_BYTES(readLength, capdus[4].data(), sizeof(readLength));
+  }
+  for (size_t i = 0; i < rapdus.size(); i++)
+    CHECK(endsWithOk(rapdus[i]));
+
+  /* CC file: version 2.0, NDEF file E104 */
+  if (rapdus.size() >= 6) {
+    CHECK_EQUAL(15 + 2, rapdus[2].size());
+    CHECK_EQUAL(0x20, rapdus[2][2]);
+    CHECK_EQUAL(0xE1, rapdus[2][9]);
+    CHECK_EQUAL(0x04, rapdus[2][10]);
+    CHECK_EQUAL(2 + 2, rapdus[4].size());
+    CHECK_EQUAL(message.getContentLength(), (rapdus[4][0] << 8) | rapdus[4][1]);
+  }
+
+  CHECK_EQUAL(0, simulator.countControl(false, 0x60, 0x07));  // CORE_GENERIC_ERROR_NTF
+  CHECK_EQUAL(0, simulator.getDroppedFrames());
+  return nciTestResult("test_card_mode");
+}
@@ -0,0 +1,104 @@
+/**
+ * Discovery of the simulated tags: the activation notification is decoded for every protocol
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+#include "NciTest.h"
+
+RecordingSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);
+
+const uint8_t ndefMessage[] = {0xD1, 0x01, 0x04, 0x54, 0x02, 'e', 'n', 'a'};
+
+uint8_t t2tMemory[144];
+uint8_t t4tMemory[256];
+uint8_t mifareMemory[1024];
+uint8_t t3tMemory[256];
+uint8_t iso15693Memory[128];
+
+NciVirtualTag t2t = {PROT_T2T, {0x04, 0x3C, 0x9A, 0x12, 0x6B, 0x51, 0x80}, 7, t2tMemory, sizeof(t2tMemory), 0, NULL};
+NciVirtualTag t4t = {PROT_ISODEP, {0x04, 0x51, 0x2E, 0x6A, 0x93, 0x1F, 0x80}, 7, t4tMemory, sizeof(t4tMemory), 0, NULL};
+NciVirtualTag mifare = {PROT_MIFARE, {0xB3, 0x2F, 0x61, 0x0A}, 4, mifareMemory, sizeof(mifareMemory), 0, NULL};
+NciVirtualTag t3t = {PROT_T3T, {0x01, 0x2E, 0x45, 0x7C, 0x1B, 0x2D, 0x3F, 0x00}, 8, t3tMemory, sizeof(t3tMemory), 0, NULL};
+NciVirtualTag iso15693 = {PROT_ISO15693, {0x5A, 0x3B, 0x12, 0x00, 0x01, 0x04, 0xE0, 0xE0}, 8, iso15693Memory, sizeof(iso15693Memory), 0, NULL};
+
+/// @brief Put the tag alone in the field and check what WaitForDiscoveryNotification() reports for it
+void checkActivation(NciVirtualTag *tag, uint8_t interface, uint8_t modeTech) {
+  RfIntf_t rfInterface;
+
+  printf("protocol 0x%02X\n", tag->protocol);
+  CHECK(NciSimulator::formatTag(tag, ndefMessage, sizeof(ndefMessage)));
+  CHECK(simulator.addTag(tag));
+
+  memset(&rfInterface, 0, sizeof(rfInterface));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+  CHECK_EQUAL(tag->protocol, rfInterface.Protocol);
+  CHECK_EQUAL(interface, rfInterface.Interface);
+  CHECK_EQUAL(modeTech, rfInterface.ModeTech);
+  CHECK(!rfInterface.MoreTags);
+  CHECK_EQUAL(tag->protocol, nfc.remoteDevice.getProtocol());
+  CHECK_EQUAL(interface, nfc.remoteDevice.getInterface());
+
+  switch (tag->protocol) {
+    case PROT_T2T:
+    case PROT_ISODEP:
+    case PROT_MIFARE:
+      CHECK_EQUAL(tag->uidLength, rfInterface.Info.NFC_APP.NfcIdLen);
+      CHECK_BYTES(tag->uid, rfInterface.Info.NFC_APP.NfcId, tag->uidLength);
+      break;
+    case PROT_T3T:
+      CHECK_BYTES(tag->uid, &rfInterface.Info.NFC_FPP.SensRes[1], 8);  // NFCID2 follows the response code
+      break;
+    case PROT_ISO15693:
+      for (uint8_t i = 0; i < 8; i++)
+        CHECK_EQUAL(tag->uid[i], rfInterface.Info.NFC_VPP.ID[7 - i]);  // the driver gives the UID MSB first
+      break;
+  }
+
+  simulator.removeAllTags();
+  CHECK(nfc.reset());
+}
+
+int main() {
+  RfIntf_t rfInterface;
+
+  CHECK_EQUAL(SUCCESS, nfc.begin());
+  CHECK(nfc.setReaderWriterMode());
+
+  /* Nothing in the field, the wait ends with the timeout */
+  unsigned long start = millis();
+  CHECK_EQUAL(ERROR, nfc.WaitForDiscoveryNotification(&rfInterface, 100));
+  CHECK(millis() - start >= 100);
+
+  checkActivation(&t2t, INTF_FRAME, MODE_POLL | TECH_PASSIVE_NFCA);
+  checkActivation(&t4t, INTF_ISODEP, MODE_POLL | TECH_PASSIVE_NFCA);
+  checkActivation(&mifare, INTF_TAGCMD, MODE_POLL | TECH_PASSIVE_NFCA);
+  checkActivation(&t3t, INTF_FRAME, MODE_POLL | TECH_PASSIVE_NFCF);
+  checkActivation(&iso15693, INTF_FRAME, MODE_POLL | TECH_PASSIVE_15693);
+
+  /* Two tags found by the same discovery: the driver is told there are more and selects the first one */
+  CHECK_EQUAL(SUCCESS, nfc.stopDiscovery());
+  CHECK(NciSimulator::formatTag(&t2t, ndefMessage, sizeof(ndefMessage)));
+  CHECK(NciSimulator::formatTag(&t4t, ndefMessage, sizeof(ndefMessage)));
+  CHECK(simulator.addTag(&t2t));
+  CHECK(simulator.addTag(&t4t));
+  CHECK_EQUAL(SUCCESS, nfc.startDiscovery());
+  memset(&rfInterface, 0, sizeof(rfInterface));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+  CHECK(rfInterface.MoreTags);
+  CHECK_EQUAL(PROT_T2T, rfInterface.Protocol);
+  CHECK_EQUAL(1, simulator.countControl(true, 0x21, 0x04));  // RF_DISCOVER_SELECT_CMD
+  simulator.removeAllTags();
+
+  CHECK_EQUAL(0, simulator.getDroppedFrames());
+  return nciTestResult("test_discovery");
+}
@@ -0,0 +1,64 @@
+/**
+ * Notifications arriving between a command and its response are not taken for the response
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+#include "NciTest.h"
+
+RecordingSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);
+
+const uint8_t ndefMessage[] = {0xD1, 0x01, 0x04, 0x54, 0x02, 'e', 'n', 'a'};
+const uint8_t genericError[] = {0x60, 0x07, 0x01, 0xA1};    // CORE_GENERIC_ERROR_NTF, target activation failed
+const uint8_t interfaceError[] = {0x60, 0x08, 0x02, 0xB3, 0x00};  // CORE_INTERFACE_ERROR_NTF, timeout on the RF connection
+
+uint8_t t4tMemory[256];
+NciVirtualTag t4t = {PROT_ISODEP, {0x04, 0x51, 0x2E, 0x6A, 0x93, 0x1F, 0x80}, 7, t4tMemory, sizeof(t4tMemory), 0, NULL};
+
+unsigned pullCount;
+
+void ndefPulled(unsigned char *message, unsigned short messageLength) {
+  (void)message;
+  (void)messageLength;
+  pullCount++;
+}
+
+int main() {
+  RfIntf_t rfInterface;
+
+  RW_NDEF_RegisterPullCallback((void *)ndefPulled);
+
+  /* Every response of the initialization comes after an error notification */
+  simulator.notifyBeforeResponses(genericError, sizeof(genericError));
+  CHECK_EQUAL(SUCCESS, nfc.begin());
+  CHECK_EQUAL(0xA1, nfc.getLastError());
+  CHECK(nfc.setReaderWriterMode());
+
+  /* Discovery, activation and NDEF read still work, and so do the stop and restart of the discovery */
+  simulator.notifyBeforeResponses(interfaceError, sizeof(interfaceError));
+  CHECK(NciSimulator::formatTag(&t4t, ndefMessage, sizeof(ndefMessage)));
+  CHECK(simulator.addTag(&t4t));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+  CHECK_EQUAL(PROT_ISODEP, rfInterface.Protocol);
+  nfc.readNdef(rfInterface);
+  CHECK_EQUAL(1, pullCount);
+  CHECK_EQUAL(SUCCESS, nfc.readerReActivate());
+  simulator.removeAllTags();
+  CHECK(nfc.reset());
+  CHECK_EQUAL(0xB3, nfc.getLastError());
+
+  /* Sent once, the error before its response was not taken for a failure */
+  CHECK_EQUAL(1, simulator.countControl(true, 0x21, 0x00));  // RF_DISCOVER_MAP_CMD
+
+  CHECK_EQUAL(0, simulator.getDroppedFrames());
+  return nciTestResult("test_notifications");
+}
@@ -0,0 +1,101 @@
+/**
+ * NDEF messages read from the simulated tags come back byte for byte
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+#include "NciTest.h"
+
+RecordingSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);
+
+uint8_t t2tMemory[540];  // NTAG215
+uint8_t t4tMemory[512];
+uint8_t mifareMemory[1024];
+uint8_t t3tMemory[512];
+
+NciVirtualTag t2t = {PROT_T2T, {0x04, 0x3C, 0x9A, 0x12, 0x6B, 0x51, 0x80}, 7, t2tMemory, sizeof(t2tMemory), 0, NULL};
+NciVirtualTag t4t = {PROT_ISODEP, {0x04, 0x51, 0x2E, 0x6A, 0x93, 0x1F, 0x80}, 7, t4tMemory, sizeof(t4tMemory), 0, NULL};
+NciVirtualTag mifare = {PROT_MIFARE, {0xB3, 0x2F, 0x61, 0x0A}, 4, mifareMemory, sizeof(mifareMemory), 0, NULL};
+NciVirtualTag t3t = {PROT_T3T, {0x01, 0x2E, 0x45, 0x7C, 0x1B, 0x2D, 0x3F, 0x00}, 8, t3tMemory, sizeof(t3tMemory), 0, NULL};
+
+uint8_t pulled[RW_MAX_NDEF_FILE_SIZE];
+unsigned short pulledLength;
+unsigned pullCount;
+
+void ndefPulled(unsigned char *message, unsigned short messageLength) {
+  pullCount++;
+  pulledLength = messageLength;
+  if (messageLength <= sizeof(pulled))
+    memcpy(pulled, message, messageLength);
+}
+
+/// @brief Short record of a URI, then a text record long enough to take several reads on every tag
+uint16_t buildMessage(uint8_t *message, uint8_t seed) {
+  const uint8_t uri[] = {0x91, 0x01, 0x0A, 0x55, 0x02, 'c', 'a', 't', 's', '.', 'c', 'o', 'm', 0x00};
+  uint16_t length = sizeof(uri) - 1;
+  uint8_t textLength = 180;
+
+  memcpy(message, uri, length);
+  message[length++] = 0x51;  // ME, SR, text
+  message[length++] = 0x01;
+  message[length++] = textLength + 3;
+  message[length++] = 'T';
+  message[length++] = 0x02;
+  message[length++] = 'e';
+  message[length++] = 'n';
+  for (uint8_t i = 0; i < textLength; i++)
+    message[length++] = 'a' + (i + seed) % 26;
+  return length;
+}
+
+/// @brief Detect the tag, read its message and compare it with what was written on it
+void checkRead(NciVirtualTag *tag, uint8_t seed) {
+  uint8_t message[256];
+  uint16_t messageLength = buildMessage(message, seed);
+  RfIntf_t rfInterface;
+
+  printf("protocol 0x%02X\n", tag->protocol);
+  CHECK(NciSimulator::formatTag(tag, message, messageLength));
+  CHECK(simulator.addTag(tag));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+  CHECK_EQUAL(tag->protocol, rfInterface.Protocol);
+
+  pullCount = 0;
+  pulledLength = 0;
+  memset(pulled, 0, sizeof(pulled));
+  nfc.readNdef(rfInterface);
+  CHECK_EQUAL(1, pullCount);
+  CHECK_EQUAL(messageLength, pulledLength);
+  CHECK_BYTES(message, pulled, messageLength);
+
+  simulator.removeAllTags();
+  CHECK(nfc.reset());
+}
+
+int main() {
+  RW_NDEF_RegisterPullCallback((void *)ndefPulled);
+
+  CHECK_EQUAL(SUCCESS, nfc.begin());
+  CHECK(nfc.setReaderWriterMode());
+
+  checkRead(&t2t, 0);
+  checkRead(&t4t, 1);
+  checkRead(&mifare, 2);
+  checkRead(&t3t, 3);
+
+  /* The same tag with another message: nothing of the first read is kept */
+  checkRead(&t2t, 4);
+  checkRead(&t4t, 5);
+
+  CHECK_EQUAL(0, simulator.getDroppedFrames());
+  return nciTestResult("test_read_ndef");
+}
@@ -0,0 +1,213 @@
+/**
+ * Type 2 Tags: READ fallback without GET_VERSION, FAST_READ across sectors and differential writes
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+#include "NciTest.h"
+
+RecordingSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);
+
+const uint8_t ntag216Version[8] = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, 0x13, 0x03};
+
+uint8_t ntagMemory[888];
+uint8_t ultralightMemory[888];
+uint8_t sectorsMemory[2048];
+
+NciVirtualTag ntag = {PROT_T2T, {0x04, 0x3C, 0x9A, 0x12, 0x6B, 0x51, 0x80}, 7, ntagMemory, sizeof(ntagMemory), 0, ntag216Version};
+NciVirtualTag ultralight = {PROT_T2T, {0x04, 0x7E, 0x21, 0x5A, 0x0C, 0x33, 0x80}, 7, ultralightMemory, sizeof(ultralightMemory), 0, NULL};  // no GET_VERSION
+NciVirtualTag sectors = {PROT_T2T, {0x04, 0x19, 0x6D, 0x42, 0x8E, 0x05, 0x80}, 7, sectorsMemory, sizeof(sectorsMemory), 0, ntag216Version};
+
+uint8_t message[1500];
+uint8_t pulled[RW_MAX_NDEF_FILE_SIZE];
+unsigned short pulledLength;
+int pushedLength;
+
+void ndefPulled(unsigned char *data, unsigned short dataLength) {
+  pulledLength = dataLength;
+  if (dataLength <= sizeof(pulled))
+    memcpy(pulled, data, dataLength);
+}
+
+void ndefPushed(unsigned char *data, unsigned short dataLength) {
+  (void)data;
+  pushedLength = dataLength;
+}
+
+/// @brief Text record with a long payload
+void buildMessage(uint16_t length) {
+  for (uint16_t i = 0; i < length; i++)
+    message[i] = 'a' + i % 26;
+  message[0] = 0xC1;  // MB, ME, long record, well known
+  message[1] = 0x01;
+  message[2] = 0x00;
+  message[3] = 0x00;
+  message[4] = (length - 7) >> 8;
+  message[5] = (length - 7) & 0xFF;
+  message[6] = 'T';
+}
+
+/// @brief Format the tag with the first length bytes of message, put it alone in the field and activate it
+void present(NciVirtualTag *tag, uint16_t length) {
+  RfIntf_t rfInterface;
+
+  simulator.removeAllTags();
+  CHECK(nfc.reset());
+  buildMessage(length);
+  CHECK(NciSimulator::formatTag(tag, message, length));
+  CHECK(simulator.addTag(tag));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+  simulator.frames.clear();
+}
+
+void checkRead(uint16_t length) {
+  pulledLength = 0;
+  nfc.readNdefMessage();
+  CHECK_EQUAL(length, pulledLength);
+  CHECK_BYTES(message, pulled, length);
+}
+
+/// @brief Commands of the given code sent to the tag
+std::vector<std::vector<uint8_t> > commands(uint8_t code) {
+  std::vector<std::vector<uint8_t> > all = simulator.dataPayloads(true);
+  std::vector<std::vector<uint8_t> > found;
+
+  for (size_t i = 0; i < all.size(); i++) {
+    if (!all[i].empty() && (all[i][0] == code))
+      found.push_back(all[i]);
+  }
+  return found;
+}
+
+/// @brief Tag without GET_VERSION: it goes back to IDLE, is activated again and read with READ
+void checkVersionFallback() {
+  size_t version = 0;
+  size_t deactivate = 0;
+  size_t select = 0;
+
+  printf("GET_VERSION fallback\n");
+  present(&ultralight, 480);
+  checkRead(480);
+
+  CHECK_EQUAL(1, commands(0x60).size());  // GET_VERSION
+  CHECK_EQUAL(0, commands(0x3A).size());  // FAST_READ
+  CHECK(commands(0x30).size() >= 480 / 16);
+
+  /* The activation comes between GET_VERSION and the next READ */
+  for (size_t i = 0; i < simulator.frames.size(); i++) {
+    const std::vector<uint8_t> &bytes = simulator.frames[i].bytes;
+    if (!simulator.frames[i].written)
+      continue;
+    if ((bytes[0] == 0x00) && (bytes.size() == 4) && (bytes[3] == 0x60))
+      version = i;
+    else if ((bytes[0] == 0x21) && (bytes[1] == 0x06) && (deactivate == 0))
+      deactivate = i;
+    else if ((bytes[0] == 0x21) && (bytes[1] == 0x04) && (select == 0))
+      select = i;
+  }
+  CHECK(version != 0);
+  CHECK(deactivate > version);
+  CHECK(select > deactivate);
+
+  /* Read again: the tag is not asked twice in the same activation */
+  simulator.frames.clear();
+  checkRead(480);
+  CHECK_EQUAL(0, commands(0x3A).size());
+}
+
+/// @brief A message over two sectors, each FAST_READ stays in one
+void checkSectorBoundary() {
+  std::vector<std::vector<uint8_t> > payloads;
+  uint8_t sector = 0;
+  bool selecting = false;
+  unsigned fastReads[2] = {0, 0};
+
+  printf("FAST_READ across sectors\n");
+  present(&sectors, 1500);
+  checkRead(1500);
+
+  payloads = simulator.dataPayloads(true);
+  for (size_t i = 0; i < payloads.size(); i++) {
+    const std::vector<uint8_t> &cmd = payloads[i];
+    if (selecting) {
+      CHECK_EQUAL(4, cmd.size());
+      sector = cmd[0];
+      selecting = false;
+    } else if ((cmd.size() == 2) && (cmd[0] == 0xC2) && (cmd[1] == 0xFF)) {
+      selecting = true;
+    } else if ((cmd.size() == 3) && (cmd[0] == 0x3A)) {
+      CHECK(cmd[1] <= cmd[2]);
+      CHECK(sector < 2);
+      if (sector < 2)
+        fastReads[sector]++;
+    }
+  }
+  CHECK(fastReads[0] > 0);
+  CHECK(fastReads[1] > 0);
+  CHECK_EQUAL(2, commands(0x30).size());  // CC and first data, the rest with FAST_READ
+}
+
+/// @brief One byte changed in the middle of the message: the NDEF TLV length is cleared first, the page with the
+/// byte is written, then the length is restored
+void checkDifferentialWrite() {
+  const uint16_t length = 480;
+  const uint16_t changed = 240;
+  const uint8_t tlvPage = 4;  // 03 FF 01 E0, the message follows
+  const uint8_t changedPage = (16 + 4 + changed) / 4;
+  std::vector<std::vector<uint8_t> > writes;
+  uint8_t header[4];
+
+  printf("differential write\n");
+  present(&ntag, length);
+  checkRead(length);
+  memcpy(header, &ntagMemory[tlvPage * 4], sizeof(header));
+
+  message[changed]++;
+  simulator.frames.clear();
+  nfc.setDifferentialWrite(true);
+  pushedLength = -1;
+  CHECK(RW_NDEF_SetMessage(message, length, (void *)ndefPushed));
+  nfc.writeNdefMessage();
+  nfc.setDifferentialWrite(false);
+  CHECK_EQUAL(length, pushedLength);
+
+  writes = commands(0xA2);  // WRITE
+  CHECK_EQUAL(3, writes.size());
+  if (writes.size() == 3) {
+    CHECK_EQUAL(tlvPage, writes[0][1]);
+    CHECK_EQUAL(0x03, writes[0][2]);
+    CHECK_EQUAL(0x00, writes[0][3]);  // L = 0
+    CHECK_EQUAL(changedPage, writes[1][1]);
+    CHECK_BYTES(&message[changedPage * 4 - 20], &writes[1][2], 4);
+    CHECK_EQUAL(tlvPage, writes[2][1]);
+    CHECK_BYTES(header, &writes[2][2], 4);
+  }
+  CHECK_BYTES(message, &ntagMemory[20], length);
+
+  simulator.frames.clear();
+  checkRead(length);
+}
+
+int main() {
+  RW_NDEF_RegisterPullCallback((void *)ndefPulled);
+
+  CHECK_EQUAL(SUCCESS, nfc.begin());
+  CHECK(nfc.setReaderWriterMode());
+
+  checkVersionFallback();
+  checkSectorBoundary();
+  checkDifferentialWrite();
+
+  simulator.removeAllTags();
+  CHECK_EQUAL(0, simulator.getDroppedFrames());
+  return nciTestResult("test_type2_tag");
+}
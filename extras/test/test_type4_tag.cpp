@@ -0,0 +1,164 @@
+/**
+ * Type 4 Tags: NDEF file larger than 255 bytes, read into the buffer of the sketch and written with 16-bit offsets
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "Electroniccats_PN7150.h"
+#include "NciTest.h"
+
+RecordingSimulator simulator;
+Electroniccats_PN7150 nfc(&simulator);
+
+uint8_t t4tMemory[1024];
+NciVirtualTag t4t = {PROT_ISODEP, {0x04, 0x51, 0x2E, 0x6A, 0x93, 0x1F, 0x80}, 7, t4tMemory, sizeof(t4tMemory), 0, NULL};
+
+const uint16_t messageLength = 700;
+uint8_t message[messageLength];
+uint8_t ndefBuffer[1024];  // the library buffer holds RW_MAX_NDEF_FILE_SIZE (500) bytes
+uint8_t pulled[sizeof(ndefBuffer)];
+unsigned short pulledLength;
+int pushedLength;
+
+void ndefPulled(unsigned char *data, unsigned short dataLength) {
+  pulledLength = dataLength;
+  if (dataLength <= sizeof(pulled))
+    memcpy(pulled, data, dataLength);
+}
+
+void ndefPushed(unsigned char *data, unsigned short dataLength) {
+  (void)data;
+  pushedLength = dataLength;
+}
+
+/// @brief Text record with a long payload, seed changes its content
+void buildMessage(uint8_t seed) {
+  for (uint16_t i = 0; i < messageLength; i++)
+    message[i] = 'a' + (i + seed) % 26;
+  message[0] = 0xC1;  // MB, ME, long record, well known
+  message[1] = 0x01;
+  message[2] = 0x00;
+  message[3] = 0x00;
+  message[4] = (messageLength - 7) >> 8;
+  message[5] = (messageLength - 7) & 0xFF;
+  message[6] = 'T';
+}
+
+void checkRead() {
+  pulledLength = 0;
+  nfc.readNdefMessage();
+  CHECK_EQUAL(messageLength, pulledLength);
+  CHECK_BYTES(message, pulled, messageLength);
+}
+
+/// @brief READ BINARY or UPDATE BINARY sent to the tag, with their offset in the selected file
+std::vector<std::vector<uint8_t> > apdus(uint8_t ins) {
+  std::vector<std::vector<uint8_t> > all = simulator.dataPayloads(true);
+  std::vector<std::vector<uint8_t> > found;
+
+  for (size_t i = 0; i < all.size(); i++) {
+    if ((all[i].size() >= 5) && (all[i][0] == 0x00) && (all[i][1] == ins))
+      found.push_back(all[i]);
+  }
+  return found;
+}
+
+uint16_t offset(const std::vector<uint8_t> &apdu) {
+  return (apdu[2] << 8) | apdu[3];
+}
+
+/// @brief The NDEF file holds NLEN then the message
+void checkMemory() {
+  CHECK_EQUAL(messageLength >> 8, t4tMemory[0]);
+  CHECK_EQUAL(messageLength & 0xFF, t4tMemory[1]);
+  CHECK_BYTES(message, &t4tMemory[2], messageLength);
+}
+
+int main() {
+  RfIntf_t rfInterface;
+  std::vector<std::vector<uint8_t> > reads;
+  std::vector<std::vector<uint8_t> > updates;
+  uint16_t next;
+
+  RW_NDEF_RegisterPullCallback((void *)ndefPulled);
+  nfc.setNdefBuffer(ndefBuffer, sizeof(ndefBuffer));
+
+  CHECK_EQUAL(SUCCESS, nfc.begin());
+  CHECK(nfc.setReaderWriterMode());
+
+  buildMessage(0);
+  CHECK(NciSimulator::formatTag(&t4t, message, messageLength));
+  CHECK(simulator.addTag(&t4t));
+  CHECK_EQUAL(SUCCESS, nfc.WaitForDiscoveryNotification(&rfInterface, 1000));
+
+  /* Read: the NDEF file is read in order, up to its last byte */
+  printf("read\n");
+  simulator.frames.clear();
+  checkRead();
+  reads = apdus(0xB0);
+  CHECK(reads.size() > 2);
+  next = 2;  // after NLEN, read first on its own
+  for (size_t i = 2; i < reads.size(); i++) {  // CC file, then NLEN
+    CHECK_EQUAL(next, offset(reads[i]));
+    next = offset(reads[i]) + reads[i][4];
+  }
+  CHECK_EQUAL(2 + messageLength, next);
+  CHECK(offset(reads[reads.size() - 1]) > 0xFF);
+
+  /* Full write: the message is written from its start, NLEN last */
+  printf("write\n");
+  buildMessage(7);
+  simulator.frames.clear();
+  pushedLength = -1;
+  CHECK(RW_NDEF_SetMessage(message, messageLength, (void *)ndefPushed));
+  nfc.writeNdefMessage();
+  CHECK_EQUAL(messageLength, pushedLength);
+  updates = apdus(0xD6);
+  CHECK(updates.size() > 2);
+  next = 2;
+  for (size_t i = 1; i + 1 < updates.size(); i++) {  // NLEN cleared, then the message
+    CHECK_EQUAL(next, offset(updates[i]));
+    next = offset(updates[i]) + updates[i][4];
+  }
+  CHECK_EQUAL(2 + messageLength, next);
+  CHECK_EQUAL(0, offset(updates[updates.size() - 1]));
+  checkMemory();
+  checkRead();
+
+  /* Differential write: only the changed byte past offset 255 is written, between the two NLEN updates */
+  printf("differential write\n");
+  message[600]++;
+  simulator.frames.clear();
+  nfc.setDifferentialWrite(true);
+  CHECK(RW_NDEF_SetMessage(message, messageLength, (void *)ndefPushed));
+  nfc.writeNdefMessage();
+  updates = apdus(0xD6);
+  CHECK_EQUAL(3, updates.size());
+  if (updates.size() == 3) {
+    CHECK_EQUAL(0, offset(updates[0]));
+    CHECK_EQUAL(2 + 600, offset(updates[1]));
+    CHECK_EQUAL(0, offset(updates[2]));
+  }
+  checkMemory();
+  checkRead();
+
+  /* Back to the library buffer: the message is neither read nor written */
+  printf("library buffer\n");
+  nfc.setDifferentialWrite(false);
+  nfc.setNdefBuffer(NULL, 0);
+  pulledLength = 1;
+  nfc.readNdefMessage();
+  CHECK_EQUAL(0, pulledLength);
+  CHECK(!RW_NDEF_SetMessage(message, messageLength, (void *)ndefPushed));
+
+  simulator.removeAllTags();
+  CHECK_EQUAL(0, simulator.getDroppedFrames());
+  return nciTestResult("test_type4_tag");
+}
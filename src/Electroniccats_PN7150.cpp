@@ -17,21 +17,29 @@
 
 #include "Electroniccats_PN7150.h"
 
-uint8_t gNextTag_Protocol = PROT_UNDETERMINED;
+#define SETTINGS_FINGERPRINT_SEED 2166136261UL  // FNV-1a offset basis
+#define SETTINGS_FINGERPRINT_PRIME 16777619UL
 
-uint8_t NCIStartDiscovery_length = 0;
-uint8_t NCIStartDiscovery[30];
+/* FNV-1a of the settings blobs configureSettings() sends, the PN7150 keeps it with them to tell if they must be sent again */
+static uint32_t fingerprintSettings(uint32_t hash, const uint8_t *data, uint16_t length) {
+  while (length-- > 0) {
+    hash ^= *data++;
+    hash *= SETTINGS_FINGERPRINT_PRIME;
+  }
+  return hash;
+}
 
-unsigned char DiscoveryTechnologiesCE[] = {  // Emulation
-    MODE_LISTEN | MODE_POLL};
+/* Discovery loop of each mode, technologies polled or listened to */
+typedef NciDiscover<MODE_LISTEN | MODE_POLL> NCIDiscoverCE;  // Emulation
 
-unsigned char DiscoveryTechnologiesRW[] = {  // Read & Write
+typedef NciDiscover<  // Read & Write
     MODE_POLL | TECH_PASSIVE_NFCA,
     MODE_POLL | TECH_PASSIVE_NFCF,
     MODE_POLL | TECH_PASSIVE_NFCB,
-    MODE_POLL | TECH_PASSIVE_15693};
+    MODE_POLL | TECH_PASSIVE_15693>
+    NCIDiscoverRW;
 
-unsigned char DiscoveryTechnologiesP2P[] = {  // P2P
+typedef NciDiscover<  // P2P
     MODE_POLL | TECH_PASSIVE_NFCA,
     MODE_POLL | TECH_PASSIVE_NFCF,
 
@@ -43,27 +51,195 @@ unsigned char DiscoveryTechnologiesP2P[] = {  // P2P
 
     MODE_LISTEN | TECH_PASSIVE_NFCF,
     MODE_LISTEN | TECH_ACTIVE_NFCA,
-    MODE_LISTEN | TECH_ACTIVE_NFCF};
+    MODE_LISTEN | TECH_ACTIVE_NFCF>
+    NCIDiscoverP2P;
+
+const uint8_t *NCIStartDiscovery = NCIDiscoverRW::data;  // RF_DISCOVER_CMD of the mode, sent again to restart the discovery loop
+uint8_t NCIStartDiscovery_length = NCIDiscoverRW::length;
+
+/* Interface of each protocol, the mode is 1 for poll, 2 for listen, 3 for both */
+typedef NciDiscoverMap<NciMapping<PROT_ISODEP, 0x02, INTF_ISODEP> > DM_CARDEMU;  // Emulation mode
+
+typedef NciDiscoverMap<  // RW Mode
+    NciMapping<PROT_T1T, 0x01, INTF_FRAME>,
+    NciMapping<PROT_T2T, 0x01, INTF_FRAME>,
+    NciMapping<PROT_T3T, 0x01, INTF_FRAME>,
+    NciMapping<PROT_ISODEP, 0x01, INTF_ISODEP>,
+    NciMapping<PROT_MIFARE, 0x01, INTF_TAGCMD> >
+    DM_RW;
+
+typedef NciDiscoverMap<NciMapping<PROT_NFCDEP, 0x03, INTF_NFCDEP> > DM_P2P;  // P2P Support
+
+/* Listen mode routing: protocol based entry, to the host, switched on */
+typedef NciRouting<NciRoute<0x01, 0x00, 0x01, PROT_ISODEP> > R_CARDEMU;
+typedef NciRouting<NciRoute<0x01, 0x00, 0x01, PROT_NFCDEP> > R_P2P;
+
+typedef NciCommand<0x0F, 0x02> NCIPropAct;  // Proprietary interface activation
+
+typedef NciParam<0x32, 0x20> NFCA_SELRSP_CARDEMU;  // LA_SEL_INFO: ISO-DEP
+typedef NciParam<0x32, 0x40> NFCA_SELRSP_P2P;      // LA_SEL_INFO: NFC-DEP
+typedef NciParam<0x29, 0x46, 0x66, 0x6D, 0x01, 0x01, 0x11, 0x03, 0x02, 0x00, 0x01, 0x04, 0x01, 0xFA> NFC_ATR_REQ_GEN_BYTES;  // PN_ATR_REQ_GEN_BYTES
+typedef NciParam<0x61, 0x46, 0x66, 0x6D, 0x01, 0x01, 0x11, 0x03, 0x02, 0x00, 0x01, 0x04, 0x01, 0xFA> NFC_ATR_RES_GEN_BYTES;  // LN_ATR_RES_GEN_BYTES
+
+#if NXP_CORE_CONF
+/* NCI standard dedicated settings
+ * Refer to NFC Forum NCI standard for more details
+ */
+typedef NciSetConfig<NciParam<0x00, 0x00, 0x01> > NxpNci_CORE_CONF;  // TOTAL_DURATION
+#endif
+
+#if NXP_CORE_CONF_EXTN
+/* NXP-NCI extension dedicated setting
+ * Refer to NFC controller User Manual for more details
+ */
+typedef NciSetConfig<
+    NciParam<0xA040, 0x00>, /* TAG_DETECTOR_CFG */
+    NciParam<0xA041, NCI_LPCD_DEFAULT_THRESHOLD>, /* TAG_DETECTOR_THRESHOLD_CFG */
+    NciParam<0xA043, NCI_LPCD_DEFAULT_FALLBACK>   /* TAG_DETECTOR_FALLBACK_CNT_CFG */
+    >
+    NxpNci_CORE_CONF_EXTN;
+#endif
+
+#if NXP_CORE_STANDBY
+/* NXP-NCI standby enable setting
+ * Refer to NFC controller User Manual for more details
+ */
+typedef NciCommand<0x0F, 0x00, NciBytes<0x01> > NxpNci_CORE_STANDBY; /* last byte indicates enable/disable */
+#endif
+
+#if NXP_TVDD_CONF
+/* NXP-NCI TVDD configuration
+ * Refer to NFC controller Hardware Design Guide document for more details
+ */
+/* RF configuration related to 1st generation of NXP-NCI controller (e.g PN7120) */
+typedef NciSetConfig<NciParam<0xA013, 0x00> > NxpNci_TVDD_CONF_1stGen;
+
+/* RF configuration related to 2nd generation of NXP-NCI controller (e.g PN7150)*/
+#if (NXP_TVDD_CONF == 1)
+/* CFG1: Vbat is used to generate the VDD(TX) through TXLDO */
+typedef NciSetConfig<NciParam<0xA00E, 0x02, 0x09, 0x00> > NxpNci_TVDD_CONF_2ndGen;
+#else
+/* CFG2: external 5V is used to generate the VDD(TX) through TXLDO */
+typedef NciSetConfig<NciParam<0xA00E, 0x06, 0x64, 0x00> > NxpNci_TVDD_CONF_2ndGen;
+#endif
+#endif
+
+#if NXP_RF_CONF
+/* NXP-NCI RF configuration
+ * Refer to NFC controller Antenna Design and Tuning Guidelines document for more details
+ */
+/* RF configuration related to 1st generation of NXP-NCI controller (e.g PN7120) */
+/* Following configuration is the default settings of PN7120 NFC Controller */
+typedef NciSetConfig<
+    NciParam<0xA00D, 0x06, 0x42, 0x01, 0x00, 0xF1, 0xFF>, /* RF_CLIF_CFG_TARGET          CLIF_ANA_TX_AMPLITUDE_REG */
+    NciParam<0xA00D, 0x06, 0x44, 0xA3, 0x90, 0x03, 0x00>, /* RF_CLIF_CFG_TARGET          CLIF_ANA_RX_REG */
+    NciParam<0xA00D, 0x34, 0x2D, 0xDC, 0x50, 0x0C, 0x00>, /* RF_CLIF_CFG_BR_106_I_RXA_P  CLIF_SIGPRO_RM_CONFIG1_REG */
+    NciParam<0xA00D, 0x06, 0x03, 0x00, 0x70>,             /* RF_CLIF_CFG_TARGET          CLIF_TRANSCEIVE_CONTROL_REG */
+    NciParam<0xA00D, 0x06, 0x16, 0x00>,                   /* RF_CLIF_CFG_TARGET          CLIF_TX_UNDERSHOOT_CONFIG_REG */
+    NciParam<0xA00D, 0x06, 0x15, 0x00>,                   /* RF_CLIF_CFG_TARGET          CLIF_TX_OVERSHOOT_CONFIG_REG */
+    NciParam<0xA00D, 0x32, 0x4A, 0x53, 0x07, 0x01, 0x1B>  /* RF_CLIF_CFG_BR_106_I_TXA    CLIF_ANA_TX_SHAPE_CONTROL_REG */
+    >
+    NxpNci_RF_CONF_1stGen;
+
+/* RF configuration related to 2nd generation of NXP-NCI controller (e.g PN7150)*/
+/* Following configuration relates to performance optimization of OM5578/PN7150 NFC Controller demo kit */
+typedef NciSetConfig<
+    NciParam<0xA00D, 0x04, 0x35, 0x90, 0x01, 0xF4, 0x01>, /* RF_CLIF_CFG_INITIATOR        CLIF_AGC_INPUT_REG */
+    NciParam<0xA00D, 0x06, 0x30, 0x01, 0x90, 0x03, 0x00>, /* RF_CLIF_CFG_TARGET           CLIF_SIGPRO_ADCBCM_THRESHOLD_REG */
+    NciParam<0xA00D, 0x06, 0x42, 0x02, 0x00, 0xFF, 0xFF>, /* RF_CLIF_CFG_TARGET           CLIF_ANA_TX_AMPLITUDE_REG */
+    NciParam<0xA00D, 0x20, 0x42, 0x88, 0x00, 0xFF, 0xFF>, /* RF_CLIF_CFG_TECHNO_I_TX15693 CLIF_ANA_TX_AMPLITUDE_REG */
+    NciParam<0xA00D, 0x22, 0x44, 0x23, 0x00>,             /* RF_CLIF_CFG_TECHNO_I_RX15693 CLIF_ANA_RX_REG */
+    NciParam<0xA00D, 0x22, 0x2D, 0x50, 0x34, 0x0C, 0x00>, /* RF_CLIF_CFG_TECHNO_I_RX15693 CLIF_SIGPRO_RM_CONFIG1_REG */
+    NciParam<0xA00D, 0x32, 0x42, 0xF8, 0x00, 0xFF, 0xFF>, /* RF_CLIF_CFG_BR_106_I_TXA     CLIF_ANA_TX_AMPLITUDE_REG */
+    NciParam<0xA00D, 0x34, 0x2D, 0x24, 0x37, 0x0C, 0x00>, /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_SIGPRO_RM_CONFIG1_REG */
+    NciParam<0xA00D, 0x34, 0x33, 0x86, 0x80, 0x00, 0x70>, /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_AGC_CONFIG0_REG */
+    NciParam<0xA00D, 0x34, 0x44, 0x22, 0x00>,             /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_ANA_RX_REG */
+    NciParam<0xA00D, 0x42, 0x2D, 0x15, 0x45, 0x0D, 0x00>, /* RF_CLIF_CFG_BR_848_I_RXA     CLIF_SIGPRO_RM_CONFIG1_REG */
+    NciParam<0xA00D, 0x46, 0x44, 0x22, 0x00>,             /* RF_CLIF_CFG_BR_106_I_RXB     CLIF_ANA_RX_REG */
+    NciParam<0xA00D, 0x46, 0x2D, 0x05, 0x59, 0x0E, 0x00>, /* RF_CLIF_CFG_BR_106_I_RXB     CLIF_SIGPRO_RM_CONFIG1_REG */
+    NciParam<0xA00D, 0x44, 0x42, 0x88, 0x00, 0xFF, 0xFF>, /* RF_CLIF_CFG_BR_106_I_TXB     CLIF_ANA_TX_AMPLITUDE_REG */
+    NciParam<0xA00D, 0x56, 0x2D, 0x05, 0x9F, 0x0C, 0x00>, /* RF_CLIF_CFG_BR_212_I_RXF_P   CLIF_SIGPRO_RM_CONFIG1_REG */
+    NciParam<0xA00D, 0x54, 0x42, 0x88, 0x00, 0xFF, 0xFF>, /* RF_CLIF_CFG_BR_212_I_TXF     CLIF_ANA_TX_AMPLITUDE_REG */
+    NciParam<0xA00D, 0x0A, 0x33, 0x80, 0x86, 0x00, 0x70>  /* RF_CLIF_CFG_I_ACTIVE         CLIF_AGC_CONFIG0_REG */
+    >
+    NxpNci_RF_CONF_2ndGen;
+#endif
+
+#if NXP_CLK_CONF
+/* NXP-NCI CLOCK configuration
+ * Refer to NFC controller Hardware Design Guide document for more details
+ */
+#if (NXP_CLK_CONF == 1)
+/* Xtal configuration */
+typedef NciSetConfig<NciParam<0xA003, 0x08> > NxpNci_CLK_CONF; /* CLOCK_SEL_CFG */
+#else
+/* PLL configuration */
+typedef NciSetConfig<
+    NciParam<0xA003, 0x11>, /* CLOCK_SEL_CFG */
+    NciParam<0xA004, 0x01>  /* CLOCK_TO_CFG */
+    >
+    NxpNci_CLK_CONF;
+#endif
+#endif
+
+#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
+typedef NciGetConfig<0xA014, 0xA040, 0xA041, 0xA043> NCIReadTS;  // with the tag detector settings, kept apart from the fingerprint
+typedef NciGetConfig<0xA00F> NCIReadTS_1stGen;
+#endif
 
 Electroniccats_PN7150::Electroniccats_PN7150(uint8_t IRQpin, uint8_t VENpin,
-                                             uint8_t I2Caddress, TwoWire *wire) : _IRQpin(IRQpin), _VENpin(VENpin), _I2Caddress(I2Caddress), _wire(wire) {
-  pinMode(_IRQpin, INPUT);
-  if (_VENpin != 255)
-    pinMode(_VENpin, OUTPUT);
+                                             uint8_t I2Caddress, TwoWire *wire) : _twoWireTransport(IRQpin, VENpin, I2Caddress, wire) {
+  this->_transport = &this->_twoWireTransport;
+  init();
+}
 
+Electroniccats_PN7150::Electroniccats_PN7150(NciTransport *transport) : _transport(transport) {
+  init();
+}
+
+void Electroniccats_PN7150::init() {
   this->_hasBeenInitialized = false;
+  this->_interruptMode = false;
+  this->_rxRing = NULL;
+  this->_irqPending = false;
+  this->_busLocked = false;
+  this->_trace = NULL;
+  this->_ndefCache = NULL;
+  this->_differentialWrite = false;
+  this->_events = NULL;
+  this->_frameCallback = NULL;
+  this->_frameCallbackContext = NULL;
+  this->_maxDataPayload = MaxPayloadSize;
+  this->_credits = 0;
+  this->_rfSettingsRestored = false;
+  this->rxFrameKind = NCI_FRAME_NONE;
+  this->_inventoryNext = 0;
+  this->_discoveryProfile = NCI_DISCOVERY_DEFAULT;
+  this->_lpcdConfig = 0x00;
+  this->_lpcdThreshold = NCI_LPCD_DEFAULT_THRESHOLD;
+  this->_lpcdFallback = NCI_LPCD_DEFAULT_FALLBACK;
+  this->_lpcdRequested = false;
+  this->_presenceState = NCI_PRESENCE_STOPPED;
+  this->_presenceCallback = NULL;
+  this->_presenceContext = NULL;
+  this->_presenceInterval = NCI_PRESENCE_INTERVAL;
+  this->_presenceSince = 0;
+  this->_reselecting = false;
+  this->_lastError = 0x00;
+  forgetControllerState();
+  _dispatcher.add(NCI_FRAME_RF_INTF_ACTIVATED, Electroniccats_PN7150::handleActivation, this);
+  _dispatcher.add(NCI_FRAME_RF_DEACTIVATE, Electroniccats_PN7150::handleDeactivation, this);
+  _dispatcher.add(NCI_FRAME_CORE_CONN_CREDITS, Electroniccats_PN7150::handleCredits, this);
+  _dispatcher.add(NCI_FRAME_NOTIFICATION, Electroniccats_PN7150::handleReset, this);
+  _dispatcher.add(NCI_FRAME_RF_DISCOVER, Electroniccats_PN7150::handleDiscovery, this);
+  _dispatcher.add(NCI_FRAME_CORE_GENERIC_ERROR, Electroniccats_PN7150::handleError, this);
+  _dispatcher.add(NCI_FRAME_CORE_INTERFACE_ERROR, Electroniccats_PN7150::handleError, this);
+  _dispatcher.add(NCI_FRAME_DATA, Electroniccats_PN7150::handleData, this);
+  _dispatcher.add(NCI_FRAME_ANY, Electroniccats_PN7150::handlePresence, this);
 }
 
 uint8_t Electroniccats_PN7150::begin() {
-  _wire->begin();
-  if (_VENpin != 255) {
-    digitalWrite(_VENpin, HIGH);
-    delay(1);
-    digitalWrite(_VENpin, LOW);
-    delay(1);
-    digitalWrite(_VENpin, HIGH);
-    delay(3);
-  }
+  resetController();
 
   if (connectNCI()) {
     return ERROR;
@@ -95,105 +271,593 @@ void Electroniccats_PN7150::setTimeOut(unsigned long theTimeOut) {
   timeOut = theTimeOut;
 }
 
+unsigned long Electroniccats_PN7150::remainingTime() const {
+  unsigned long elapsed = millis() - timeOutStartTime;
+  return (elapsed >= timeOut) ? 0 : timeOut - elapsed;
+}
+
+void Electroniccats_PN7150::resetController() {
+  forgetControllerState();
+  _transport->begin();
+  if (_transport->hasVen()) {
+    _transport->setVen(true);
+    delay(1);
+    _transport->setVen(false);
+    delay(1);
+    _transport->setVen(true);
+    delay(3);
+  }
+}
+
 uint8_t Electroniccats_PN7150::wakeupNCI() {  // the device has to wake up using a core reset
   uint8_t NCICoreReset[] = {0x20, 0x00, 0x01, 0x01};
-  uint16_t NbBytes = 0;
 
-  // Reset RF settings restauration flag
   (void)writeData(NCICoreReset, 4);
-  getMessage(15);
-  NbBytes = rxMessageLength;
-  if ((NbBytes == 0) || (rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x00)) {
+  if (!waitForMessage(0x40, 0x00, 15))
     return ERROR;
-  }
+  forgetControllerState();
+  /* CORE_GENERIC_ERROR_NTF may follow if the anti-tearing recovery was triggered, see handleError() */
   getMessage();
-  NbBytes = rxMessageLength;
-  if (NbBytes != 0) {
-    // NCI_PRINT_BUF("NCI << ", Answer, NbBytes);
-    //  Is CORE_GENERIC_ERROR_NTF ?
-    if ((rxBuffer[0] == 0x60) && (rxBuffer[1] == 0x07)) {
-      /* Is PN7150B0HN/C11004 Anti-tearing recovery procedure triggered ? */
-      // if ((rxBuffer[3] == 0xE6)) gRfSettingsRestored_flag = true;
-    } else {
-      return ERROR;
-    }
-  }
   return SUCCESS;
 }
 
 bool Electroniccats_PN7150::getMessage(uint16_t timeout) {  // check for message using timeout, 5 milisec as default
   setTimeOut(timeout);
   rxMessageLength = 0;
-  while (!isTimeOut()) {
-    rxMessageLength = readData(rxBuffer);
-    if (rxMessageLength)
-      break;
-    else if (timeout == 1337)
-      setTimeOut(timeout);
+  if (_rxRing != NULL) {
+    rxMessageLength = popFrame(rxBuffer);  // frames already queued are delivered first
+    if ((rxMessageLength == 0) && !this->_interruptMode)
+      _rxRing = NULL;  // left by disableInterruptMode(), now empty
   }
+
+  if ((rxMessageLength == 0) && this->_interruptMode) {
+    do {
+      if (this->_irqPending)  // only the ISR flag, the IRQ pin is not polled while waiting
+        processInterrupt();
+      rxMessageLength = popFrame(rxBuffer);
+      if (rxMessageLength)
+        break;
+      else if (timeout == 1337)
+        setTimeOut(timeout);
+      _transport->idle(remainingTime());
+    } while (!isTimeOut());
+  } else if (rxMessageLength == 0) {
+    while (!isTimeOut()) {
+      rxMessageLength = readData(rxBuffer);
+      if (rxMessageLength)
+        break;
+      else if (timeout == 1337)
+        setTimeOut(timeout);
+      _transport->waitForIrq(remainingTime());
+    }
+  }
+
+  rxFrameKind = NCI_FRAME_NONE;
+  if (rxMessageLength)
+    rxFrameKind = onFrameReceived(rxBuffer, rxMessageLength);
+#ifdef PN7150_METRICS
+  else {
+    _transport->lock();
+    _metrics.timedOut();
+    _transport->unlock();
+  }
+#endif
   return rxMessageLength;
 }
 
-bool Electroniccats_PN7150::hasMessage() const {
-  return (HIGH == digitalRead(_IRQpin));  // PN7150 indicates it has data by driving IRQ signal HIGH
+/// @brief Take the oldest frame of the receive ring, a transport thread waiting for room is woken up
+uint16_t Electroniccats_PN7150::popFrame(uint8_t *frame) {
+  uint16_t length = _rxRing->pop(frame);
+  if ((length > 0) && this->_interruptMode)
+    _transport->resumeIrqHandler();
+  return length;
 }
 
-uint8_t Electroniccats_PN7150::writeData(uint8_t txBuffer[], uint32_t txBufferLevel) const {
-  uint32_t nmbrBytesWritten = 0;
-  _wire->beginTransmission((uint8_t)_I2Caddress);                      // configura transmision
-  nmbrBytesWritten = _wire->write(txBuffer, (size_t)(txBufferLevel));  // carga en buffer
-#ifdef DEBUG2
-  Serial.println("[DEBUG] written bytes = 0x" + String(nmbrBytesWritten, HEX));
+/// @brief Wait for the control message with this header and OID, the response to the command just written or the
+/// notification it leads to. Frames received before it only go to the handlers, so that a notification is not
+/// taken for the response
+/// @return true if it came within timeout, it is then in rxBuffer
+bool Electroniccats_PN7150::waitForMessage(uint8_t header, uint8_t oid, uint16_t timeout) {
+  unsigned long start = millis();
+  unsigned long elapsed = 0;
+
+  do {
+    if (getMessage(timeout - elapsed) && (rxBuffer[0] == header) && ((rxBuffer[1] & 0x3F) == oid))
+      return true;
+    elapsed = millis() - start;
+  } while ((rxMessageLength != 0) && (elapsed < timeout));
+  rxMessageLength = 0;
+  rxFrameKind = NCI_FRAME_NONE;
+  return false;
+}
+
+/// @brief Decode a frame read by getMessage() or poll() and call the handlers registered for its kind
+NciFrameKind_t Electroniccats_PN7150::onFrameReceived(const uint8_t *frame, uint16_t length) {
+#ifdef PN7150_METRICS
+  _transport->lock();
+  _metrics.frameReceived(frame, micros());
+  _transport->unlock();
 #endif
-  if (nmbrBytesWritten == txBufferLevel) {
-    byte resultCode;
-    resultCode = _wire->endTransmission();  // envio de datos segun yo
-#ifdef DEBUG2
-    Serial.println("[DEBUG] write data code = 0x" + String(resultCode, HEX));
+  return _dispatcher.dispatch(frame, length);
+}
+
+/// @brief RF_INTF_ACTIVATED_NTF gives the max payload and the initial credits of the RF connection
+void Electroniccats_PN7150::handleActivation(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+
+  (void)kind;
+  if (length > 8) {
+    nfc->_maxDataPayload = (frame[7] != 0) ? frame[7] : MaxPayloadSize;
+    nfc->_credits = frame[8];
+  }
+  if ((length <= 9) || ((frame[6] & MODE_MASK) != MODE_POLL) || (length < 10 + frame[9]))
+    return;
+
+  /* The presence checks of a MIFARE Classic select it again */
+  if ((nfc->_events != NULL) && !nfc->_reselecting && (nfc->_presenceState != NCI_PRESENCE_SELECTING)) {
+    if (nfc->_inventory.find(frame[3]) == NCI_INVENTORY_NONE)
+      nfc->_events->addTag(NCI_EVENT_TAG_ARRIVED, micros(), frame[3], frame[5], frame[6], &frame[10], frame[9]);
+    nfc->_events->addTag(NCI_EVENT_TAG_ACTIVATED, micros(), frame[3], frame[5], frame[6], &frame[10], frame[9]);
+  }
+  /* A new activation, not the same tag selected again by the driver */
+  if (!nfc->_reselecting && (nfc->_presenceState != NCI_PRESENCE_SELECTING))
+    RW_NDEF_Activated();
+  /* Only tag in the field, or one of the inventory selected */
+  if (nfc->_inventory.add(frame[3], frame[5], frame[6], &frame[10], frame[9]))
+    nfc->_inventoryNext = 1;
+}
+
+/// @brief RF_DISCOVER_NTF, one of the tags in the field
+void Electroniccats_PN7150::handleDiscovery(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+
+  (void)kind;
+  if ((length <= 6) || (length < 7 + frame[6]))
+    return;
+
+  if ((nfc->_events != NULL) && (nfc->_inventory.find(frame[3]) == NCI_INVENTORY_NONE))
+    nfc->_events->addTag(NCI_EVENT_TAG_ARRIVED, micros(), frame[3], frame[4], frame[5], &frame[7], frame[6]);
+  nfc->_inventory.add(frame[3], frame[4], frame[5], &frame[7], frame[6]);
+}
+
+/// @brief No more data on the RF connection until the next activation
+void Electroniccats_PN7150::handleDeactivation(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  (void)kind;
+  (void)frame;
+  (void)length;
+  ((Electroniccats_PN7150 *)context)->_credits = 0;
+}
+
+/// @brief CORE_CONN_CREDITS_NTF, pairs of connection identifier and credits
+void Electroniccats_PN7150::handleCredits(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+
+  (void)kind;
+  for (uint8_t i = 0; (length > 3) && (i < frame[3]) && (5 + 2 * i < length); i++) {
+    uint16_t credits = nfc->_credits + frame[5 + 2 * i];
+    if ((frame[4 + 2 * i] == 0x00) && (nfc->_credits != NCI_CREDITS_UNLIMITED))
+      nfc->_credits = (credits < NCI_CREDITS_UNLIMITED) ? credits : NCI_CREDITS_UNLIMITED - 1;
+  }
+}
+
+/// @brief CORE_RESET_NTF, the PN7150 reset on its own and lost what it was configured with
+void Electroniccats_PN7150::handleReset(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  (void)kind;
+  if ((length >= 3) && (frame[0] == 0x60) && (frame[1] == 0x00))
+    ((Electroniccats_PN7150 *)context)->forgetControllerState();
+}
+
+/// @brief CORE_GENERIC_ERROR_NTF and CORE_INTERFACE_ERROR_NTF, whatever the driver was waiting for
+void Electroniccats_PN7150::handleError(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+
+  if (length < 4)
+    return;
+  nfc->_lastError = frame[3];
+  /* Is PN7150B0HN/C11004 Anti-tearing recovery procedure triggered ? */
+  if ((kind == NCI_FRAME_CORE_GENERIC_ERROR) && (frame[3] == 0xE6))
+    nfc->_rfSettingsRestored = true;
+}
+
+/// @brief Data packet of the remote device, a tag answering the application needs no presence probe
+void Electroniccats_PN7150::handleData(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+
+  (void)kind;
+  (void)frame;
+  (void)length;
+  if (nfc->_presenceState == NCI_PRESENCE_WAITING)
+    nfc->_presenceSince = millis();
+}
+
+/// @brief Send again every setting on the next mode switch, to be called if the PN7150 was configured without
+/// the library
+void Electroniccats_PN7150::forgetControllerState() {
+  this->_settingsApplied = false;
+  this->_rfIdle = false;
+  this->_propActivated = false;
+  this->_discoverMap = NULL;
+  this->_routing = NULL;
+  this->_selRes = NULL;
+  this->_p2pConfigured = false;
+  this->_totalDuration = 0;
+  this->_lpcdKnown = false;
+}
+
+/// @brief Call handler for every frame of the given kind read by the driver, NCI_FRAME_ANY for all of them.
+/// Handlers run inside getMessage() and poll(), they must not call the driver
+/// @return false if the handler table is full
+bool Electroniccats_PN7150::addFrameHandler(NciFrameKind_t kind, NciFrameHandler_t *handler, void *context) {
+  return _dispatcher.add(kind, handler, context);
+}
+
+bool Electroniccats_PN7150::removeFrameHandler(NciFrameKind_t kind, NciFrameHandler_t *handler) {
+  return _dispatcher.remove(kind, handler);
+}
+
+/// @brief Receive frames on IRQ edges instead of polling the IRQ pin and the bus. Frames are queued in the given
+/// ring and popped by getMessage(), the ring must outlive the interrupt mode
+/// @return true if the transport supports IRQ handlers, false otherwise or if there is no ring
+bool Electroniccats_PN7150::enableInterruptMode(NciRingBuffer *ring) {
+  if (this->_interruptMode)
+    return ring == _rxRing;
+  if ((ring == NULL) || ((_rxRing != NULL) && (ring != _rxRing) && !_rxRing->isEmpty()))
+    return false;  // the frames left in the previous ring have not been read yet
+
+  _rxRing = ring;
+  this->_irqPending = hasMessage();  // a frame may already be waiting, its edge is gone
+  this->_interruptMode = true;
+  if (!_transport->attachIrqHandler(Electroniccats_PN7150::interruptHandler, this)) {
+    this->_interruptMode = false;
+    if (_rxRing->isEmpty())
+      _rxRing = NULL;
+    return false;
+  }
+  return true;
+}
+
+void Electroniccats_PN7150::disableInterruptMode() {
+  if (!this->_interruptMode)
+    return;
+
+  _transport->detachIrqHandler();
+  this->_interruptMode = false;
+  this->_irqPending = false;
+}
+
+bool Electroniccats_PN7150::isInterruptModeEnabled() const {
+  return this->_interruptMode;
+}
+
+void PN7150_ISR_ATTR Electroniccats_PN7150::interruptHandler(void *context) {
+  ((Electroniccats_PN7150 *)context)->onInterrupt();
+}
+
+void PN7150_ISR_ATTR Electroniccats_PN7150::onInterrupt() {
+  this->_irqPending = true;
+  if (_transport->isIrqHandlerThreaded()) {
+    drainMessages();  // host thread, it is the only producer of the ring
+    return;
+  }
+#ifdef PN7150_DRAIN_IN_ISR
+  /* Only for cores whose I2C driver can run from an interrupt. If the main context
+     is using the bus the frames are fetched later by processInterrupt() */
+  if (!this->_busLocked)
+    drainMessages();
 #endif
-    return resultCode;
-  } else {
-    return 4;  // Could not properly copy data to I2C buffer, so treat as other error, see i2c_t3
+}
+
+/// @brief Move every frame the PN7150 has ready into the receive ring. Call it from loop() to keep the ring
+/// up to date without blocking, getMessage() also calls it while waiting
+void Electroniccats_PN7150::processInterrupt() {
+  if (_rxRing == NULL)
+    return;  // the interrupt mode has not been enabled
+  if (this->_interruptMode && _transport->isIrqHandlerThreaded())
+    return;  // the transport thread fills the ring
+  if (!this->_irqPending && !hasMessage())
+    return;
+
+  this->_busLocked = true;
+  drainMessages();
+  this->_busLocked = false;
+}
+
+void Electroniccats_PN7150::drainMessages() {
+  uint8_t *slot;
+
+  this->_irqPending = false;
+  while ((slot = _rxRing->reserve()) != NULL) {
+    uint32_t length = readData(slot);
+    if (length == 0)
+      return;
+    _rxRing->commit(length);
+  }
+
+  /* Ring is full, leave the remaining frames in the PN7150 until the next call */
+  this->_irqPending = hasMessage();
+}
+
+bool Electroniccats_PN7150::hasMessage() const {
+  return _transport->isIrqActive();  // PN7150 indicates it has data by driving IRQ signal HIGH
+}
+
+/// @brief Send data to the remote device on the static RF connection. Data longer than the max payload announced
+/// at activation is split in packets chained with the PBF bit, written back to back while credits are left
+/// @return true if every packet was written
+bool Electroniccats_PN7150::sendDataPacket(const uint8_t *data, uint16_t length) {
+  uint8_t Cmd[MAX_NCI_FRAME_SIZE];
+  uint8_t size;
+
+  do {
+    if (!waitForCredit(100))
+      return false;
+    size = (length > _maxDataPayload) ? _maxDataPayload : length;
+    Cmd[0] = (length > size) ? 0x10 : 0x00;
+    Cmd[1] = 0x00;
+    Cmd[2] = size;
+    memcpy(&Cmd[3], data, size);
+    if (writeData(Cmd, size + 3) != 0)
+      return false;
+    data += size;
+    length -= size;
+  } while (length > 0);
+  return true;
+}
+
+/// @brief Wait for CORE_CONN_CREDITS_NTF when every credit of the RF connection is used. Nothing else can come
+/// before the PN7150 has the whole data, except an error or the deactivation, which is left in rxBuffer
+bool Electroniccats_PN7150::waitForCredit(uint16_t timeout) {
+  while (this->_credits == 0) {
+    getMessage(timeout);
+    if (rxFrameKind != NCI_FRAME_CORE_CONN_CREDITS)
+      return false;
   }
+  return true;
+}
+
+/// @brief Credits left on the RF connection, data packets are only written when there is one
+/// @return NCI_CREDITS_UNLIMITED if the PN7150 does not use flow control
+uint8_t Electroniccats_PN7150::getCredits() const {
+  return this->_credits;
+}
+
+/// @brief Status of the last CORE_GENERIC_ERROR_NTF or CORE_INTERFACE_ERROR_NTF, 0x00 if there was none
+uint8_t Electroniccats_PN7150::getLastError() const {
+  return this->_lastError;
+}
+
+/// @brief Receive data from the remote device, chained packets are put back together in data. Credit
+/// notifications received meanwhile are skipped
+/// @return false on timeout, on a notification other than credits or if the data is longer than size
+bool Electroniccats_PN7150::receiveDataPacket(uint8_t *data, uint16_t size, uint16_t *length, uint16_t timeout) {
+  *length = 0;
+  do {
+    getMessage(timeout);
+  } while (rxFrameKind == NCI_FRAME_CORE_CONN_CREDITS);
+
+  if (rxFrameKind != NCI_FRAME_DATA)
+    return false;
+  return reassembleDataPacket(data, size, length, timeout);
+}
+
+/// @brief Put back together a chain of data packets, starting from the one already in rxBuffer
+bool Electroniccats_PN7150::reassembleDataPacket(uint8_t *data, uint16_t size, uint16_t *length, uint16_t timeout) {
+  bool fits = true;
+
+  *length = 0;
+  while (1) {
+    if (fits && ((uint32_t)*length + rxBuffer[2] <= size)) {
+      memcpy(&data[*length], &rxBuffer[3], rxBuffer[2]);
+      *length += rxBuffer[2];
+    } else {
+      fits = false;  // Keep reading the chain so that it does not end up in the next answer
+    }
+    if (!(rxBuffer[0] & 0x10))
+      return fits;
+
+    do {
+      getMessage(timeout);
+    } while (rxFrameKind == NCI_FRAME_CORE_CONN_CREDITS);
+    if (rxFrameKind != NCI_FRAME_DATA)
+      return false;
+  }
+}
+
+uint8_t Electroniccats_PN7150::writeData(const uint8_t txBuffer[], uint32_t txBufferLevel) const {
+  uint8_t resultCode;
+  _busLocked = true;  // before the trace is touched, an ISR draining the ring records into it too
+  _transport->lock();  // and so does a transport thread
+  if (_trace != NULL)
+    _trace->record(NCI_TRACE_TX, micros(), txBuffer, txBufferLevel);
+  /* Data packet on the RF connection, the PN7150 gives the credit back with CORE_CONN_CREDITS_NTF */
+  if ((txBuffer[0] & 0xEF) == 0x00 && (_credits != 0) && (_credits != NCI_CREDITS_UNLIMITED))
+    _credits--;
+  if ((txBuffer[0] == 0x21) && (txBuffer[1] == 0x03))  // RF_DISCOVER_CMD
+    _rfIdle = false;
+  /* The discovery starts again, RF_DISCOVER_CMD or RF_DEACTIVATE_CMD to discovery */
+  if ((txBuffer[0] == 0x21) && ((txBuffer[1] == 0x03) || ((txBuffer[1] == 0x06) && (txBuffer[3] == 0x03))))
+    _inventory.clear();
+#ifdef PN7150_METRICS
+  unsigned long start = micros();
+  resultCode = _transport->writeFrame(txBuffer, txBufferLevel);
+  _metrics.busWritten(micros() - start);
+  /* Data sent in card emulation answers the reader, nothing comes back for it */
+  if ((txBufferLevel == (uint32_t)txBuffer[2] + 3) && (((txBuffer[0] & 0xE0) == 0x20) ||
+                                                       (((txBuffer[0] & 0xE0) == 0x00) && !(remoteDevice.getModeTech() & MODE_LISTEN))))
+    _metrics.commandSent(txBuffer, micros());
+#else
+  resultCode = _transport->writeFrame(txBuffer, txBufferLevel);
+#endif
+  _transport->unlock();
+  _busLocked = false;
+  return resultCode;
 }
 
 uint32_t Electroniccats_PN7150::readData(uint8_t rxBuffer[]) const {
-  uint32_t bytesReceived;                                         // keeps track of how many bytes we actually received
-  if (hasMessage()) {                                             // only try to read something if the PN7150 indicates it has something
-    bytesReceived = _wire->requestFrom(_I2Caddress, (uint8_t)3);  // first reading the header, as this contains how long the payload will be
-// Imprimir datos de bytes received, tratar de extraer con funcion read
-// Leer e inyectar directo al buffer los siguientes 3
-#ifdef DEBUG2
-    Serial.println("[DEBUG] bytesReceived = 0x" + String(bytesReceived, HEX));
+#ifdef PN7150_METRICS
+  unsigned long start = micros();
+  uint32_t length = _transport->readFrame(rxBuffer);
+  unsigned long duration = micros() - start;
+#else
+  uint32_t length = _transport->readFrame(rxBuffer);
 #endif
-    rxBuffer[0] = _wire->read();
-    rxBuffer[1] = _wire->read();
-    rxBuffer[2] = _wire->read();
-#ifdef DEBUG2
-    for (int i = 0; i < 3; i++) {
-      Serial.println("[DEBUG] Byte[" + String(i) + "] = 0x" + String(rxBuffer[i], HEX));
-    }
+  if (length == 0)
+    return 0;
+
+  _transport->lock();  // called from the transport thread in interrupt mode
+#ifdef PN7150_METRICS
+  _metrics.busRead(duration);
 #endif
-    uint8_t payloadLength = rxBuffer[2];
-    if (payloadLength > 0) {
-      bytesReceived += _wire->requestFrom(_I2Caddress, (uint8_t)payloadLength);  // then reading the payload, if any
-#ifdef DEBUG2
-      Serial.println("[DEBUG] payload bytes = 0x" + String(bytesReceived - 3, HEX));
+  if (_trace != NULL)
+    _trace->record(NCI_TRACE_RX, micros(), rxBuffer, length);
+  _transport->unlock();
+  return length;
+}
+
+/// @brief Record every frame written and read in a binary trace, NULL stops the capture
+void Electroniccats_PN7150::setTrace(NciTrace *trace) {
+  this->_trace = trace;
+}
+
+NciTrace *Electroniccats_PN7150::getTrace() const {
+  return this->_trace;
+}
+
+/// @brief Keep the messages read, a tag read again only sends them back once its change indicator was checked.
+/// The indicator only covers the first bytes of the message (its length on a T4T), a hit is valid only if this
+/// reader is the only one writing the tag. NULL reads every tag in full
+void Electroniccats_PN7150::setNdefCache(NdefCache *cache) {
+  this->_ndefCache = cache;
+}
+
+NdefCache *Electroniccats_PN7150::getNdefCache() const {
+  return this->_ndefCache;
+}
+
+/// @brief Buffer the NDEF messages are read into, instead of the RW_MAX_NDEF_FILE_SIZE bytes of the library. It
+/// must outlive the reads, NULL goes back to the library buffer
+void Electroniccats_PN7150::setNdefBuffer(uint8_t *buffer, uint16_t size) {
+  RW_NDEF_SetBuffer(buffer, size);
+}
+
+/// @brief Compare the message written with the one on the tag and only write the T2T pages or T4T bytes which
+/// differ, the NDEF length last. Other tags are written in full
+void Electroniccats_PN7150::setDifferentialWrite(bool enable) {
+  this->_differentialWrite = enable;
+}
+
+bool Electroniccats_PN7150::getDifferentialWrite() const {
+  return this->_differentialWrite;
+}
+
+/// @brief Queue receiving the tag events: arrival, activation, NDEF message read and removal. NULL to stop
+void Electroniccats_PN7150::setEventQueue(NciEventQueue *events) {
+  _events = events;
+}
+
+NciEventQueue *Electroniccats_PN7150::getEventQueue() const {
+  return _events;
+}
+
+/// @brief Latency histograms of the commands sent, only collected when PN7150_METRICS is defined
+/// @return NULL if the library was built without PN7150_METRICS
+const NciMetrics *Electroniccats_PN7150::getMetrics() const {
+#ifdef PN7150_METRICS
+  return &this->_metrics;
+#else
+  return NULL;
 #endif
-      uint32_t index = 3;
-      while (index < bytesReceived) {
-        rxBuffer[index] = _wire->read();
-#ifdef DEBUG2
-        Serial.println("[DEBUG] payload[" + String(index) + "] = 0x" + String(rxBuffer[index], HEX));
+}
+
+void Electroniccats_PN7150::resetMetrics() {
+#ifdef PN7150_METRICS
+  _transport->lock();
+  _metrics.reset();
+  _transport->unlock();
 #endif
-        index++;
-      }
-      index = 0;
+}
+
+/// @brief Queue a command (or a data packet) to be sent by poll(), the callback is called from poll() when it
+/// completes. The command is not copied, it must stay valid until then
+/// @return false if the queue is full
+bool Electroniccats_PN7150::submitCommand(const uint8_t *command, uint16_t length, NciCommandCallback_t *callback, void *context, uint16_t timeout) {
+  return _commands.push(command, length, timeout, callback, context);
+}
+
+bool Electroniccats_PN7150::submitCommand(const uint8_t *command, uint16_t length, NciCommandFuture *future, uint16_t timeout) {
+  return _commands.push(command, length, timeout, future);
+}
+
+/// @brief Receive the notifications and data packets read by poll() that do not answer a queued command, e.g.
+/// RF_INTF_ACTIVATED_NTF or the commands of a reader in card emulation mode
+void Electroniccats_PN7150::setFrameCallback(NciFrameCallback_t *callback, void *context) {
+  this->_frameCallback = callback;
+  this->_frameCallbackContext = context;
+}
+
+/// @brief Run the queued commands without blocking, call it from loop(). Reads every frame the PN7150 has ready,
+/// completes the command they answer or hands them to the frame callback, then sends the next command.
+/// Do not mix with the blocking methods while commands are queued, they would take the responses
+void Electroniccats_PN7150::poll() {
+  const uint8_t *command;
+  uint16_t length;
+
+  for (;;) {
+    length = (_rxRing != NULL) ? popFrame(rxBuffer) : 0;
+    if ((length == 0) && this->_interruptMode) {
+      processInterrupt();
+      length = popFrame(rxBuffer);
+    } else if ((length == 0) && hasMessage()) {
+      length = readData(rxBuffer);
     }
-  } else {
-    bytesReceived = 0;
+    if (length == 0)
+      break;
+
+    rxFrameKind = onFrameReceived(rxBuffer, length);
+    if (!_commands.answer(rxBuffer, length) && (_frameCallback != NULL))
+      _frameCallback(rxBuffer, length, _frameCallbackContext);
+  }
+
+  if (_commands.expire(millis())) {
+#ifdef PN7150_METRICS
+    _transport->lock();
+    _metrics.timedOut();
+    _transport->unlock();
+#endif
   }
-  return bytesReceived;
+
+  if (_presenceState != NCI_PRESENCE_STOPPED)
+    runPresenceMonitor();
+
+  while ((command = _commands.next(&length)) != NULL) {
+    if (((command[0] & 0xEF) == 0x00) && (this->_credits == 0))
+      break;  // sent when CORE_CONN_CREDITS_NTF comes
+    if (writeData((uint8_t *)command, length) != 0) {
+      _commands.finish(NCI_COMMAND_BUS_ERROR);
+    } else if (((command[0] & 0xE0) == 0x00) && (remoteDevice.getModeTech() & MODE_LISTEN)) {
+      _commands.finish(NCI_COMMAND_COMPLETED);  // data sent in card emulation answers the reader
+    } else {
+      _commands.sent(millis());
+      break;
+    }
+  }
+}
+
+uint8_t Electroniccats_PN7150::getPendingCommands() const {
+  return _commands.getCount();
+}
+
+/// @brief Drop the queued commands, their callbacks are called with NCI_COMMAND_CANCELLED
+void Electroniccats_PN7150::cancelCommands() {
+  _commands.cancel();
+}
+
+void Electroniccats_PN7150::setReadStrategy(NxpNci_ReadStrategy_t strategy, uint8_t readSize) {
+  _twoWireTransport.setReadStrategy(strategy, readSize);
+}
+
+NxpNci_ReadStrategy_t Electroniccats_PN7150::getReadStrategy() const {
+  return _twoWireTransport.getReadStrategy();
 }
 
 int Electroniccats_PN7150::getFirmwareVersion() {
@@ -215,15 +879,7 @@ uint8_t Electroniccats_PN7150::connectNCI() {
   }
 
   // Open connection to NXPNCI
-  _wire->begin();
-  if (_VENpin != 255) {
-    digitalWrite(_VENpin, HIGH);
-    delay(1);
-    digitalWrite(_VENpin, LOW);
-    delay(1);
-    digitalWrite(_VENpin, HIGH);
-    delay(3);
-  }
+  resetController();
 
   // Loop until NXPNCI answers
   while (wakeupNCI() != SUCCESS) {
@@ -233,8 +889,7 @@ uint8_t Electroniccats_PN7150::connectNCI() {
   }
 
   (void)writeData(NCICoreInit, sizeof(NCICoreInit));
-  getMessage();
-  if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x01) || (rxBuffer[3] != 0x00))
+  if (!waitForMessage(0x40, 0x01, 5) || (rxBuffer[3] != 0x00))
     return ERROR;
 
   // Retrieve NXP-NCI NFC Controller generation
@@ -271,98 +926,86 @@ uint8_t Electroniccats_PN7150::ConfigMode(uint8_t modeSE) {
 
   Electroniccats_PN7150::stopDiscovery();
 
-  uint8_t Command[MAX_NCI_FRAME_SIZE];
-
-  uint8_t Item = 0;
-  uint8_t NCIDiscoverMap[] = {0x21, 0x00};
-
-  // Emulation mode
-  const uint8_t DM_CARDEMU[] = {0x4, 0x2, 0x2};
-  const uint8_t R_CARDEMU[] = {0x1, 0x3, 0x0, 0x1, 0x4};
-
-  // RW Mode
-  const uint8_t DM_RW[] = {0x1, 0x1, 0x1, 0x2, 0x1, 0x1, 0x3, 0x1, 0x1, 0x4, 0x1, 0x2, 0x80, 0x01, 0x80};
-  uint8_t NCIPropAct[] = {0x2F, 0x02, 0x00};
-
-  // P2P Support
-  const uint8_t DM_P2P[] = {0x5, 0x3, 0x3};
-  const uint8_t R_P2P[] = {0x1, 0x3, 0x0, 0x1, 0x5};
-  uint8_t NCISetConfig_NFC[] = {0x20, 0x02, 0x1F, 0x02, 0x29, 0x0D, 0x46, 0x66, 0x6D, 0x01, 0x01, 0x11, 0x03, 0x02, 0x00, 0x01, 0x04, 0x01, 0xFA, 0x61, 0x0D, 0x46, 0x66, 0x6D, 0x01, 0x01, 0x11, 0x03, 0x02, 0x00, 0x01, 0x04, 0x01, 0xFA};
-
-  uint8_t NCIRouting[] = {0x21, 0x01, 0x07, 0x00, 0x01};
-  uint8_t NCISetConfig_NFCA_SELRSP[] = {0x20, 0x02, 0x04, 0x01, 0x32, 0x01, 0x00};
+  NciConfigBuilder config;  // SEL_RES and P2P parameters, sent at once
 
   if (mode == 0)
     return SUCCESS;
 
+  /* Only what the PN7150 does not hold yet is sent, see forgetControllerState() */
+  const uint8_t *DiscoverMap = (modeSE == 1 ? DM_RW::data : modeSE == 2 ? DM_CARDEMU::data
+                                                                        : DM_P2P::data);
+  uint16_t DiscoverMapSize = (modeSE == 1 ? DM_RW::length : modeSE == 2 ? DM_CARDEMU::length
+                                                                        : DM_P2P::length);
+  const uint8_t *Routing = (modeSE == 2 ? R_CARDEMU::data : R_P2P::data);
+  uint16_t RoutingSize = (modeSE == 2 ? R_CARDEMU::length : R_P2P::length);
+  const uint8_t *SelRes = (modeSE == 2 ? NFCA_SELRSP_CARDEMU::data : NFCA_SELRSP_P2P::data);
+
   /* Enable Proprietary interface for T4T card presence check procedure */
   if (modeSE == 1) {
-    if (mode == MODE_RW) {
-      (void)writeData(NCIPropAct, sizeof(NCIPropAct));
-      getMessage(10);
-
-      if ((rxBuffer[0] != 0x4F) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00))
+    if (mode == MODE_RW && !_propActivated) {
+      (void)writeData(NCIPropAct::data, NCIPropAct::length);
+      if (!waitForMessage(0x4F, 0x02, 10) || (rxBuffer[3] != 0x00))
         return ERROR;
+      _propActivated = true;
     }
   }
 
-  //* Building Discovery Map command
-  Item = 0;
-
-  if ((mode & MODE_CARDEMU and modeSE == 2) || (mode & MODE_P2P and modeSE == 3)) {
-    memcpy(&Command[4 + (3 * Item)], (modeSE == 2 ? DM_CARDEMU : DM_P2P), sizeof((modeSE == 2 ? DM_CARDEMU : DM_P2P)));
-    Item++;
-  }
-  if (mode & MODE_RW and modeSE == 1) {
-    memcpy(&Command[4 + (3 * Item)], DM_RW, sizeof(DM_RW));
-    Item += sizeof(DM_RW) / 3;
-  }
-  if (Item != 0) {
-    memcpy(Command, NCIDiscoverMap, sizeof(NCIDiscoverMap));
-    Command[2] = 1 + (Item * 3);
-    Command[3] = Item;
-    (void)writeData(Command, 3 + Command[2]);
-    getMessage(10);
-    if ((rxBuffer[0] != 0x41) || (rxBuffer[1] != 0x00) || (rxBuffer[3] != 0x00)) {
+  //* Discovery Map command
+  if (DiscoverMap != _discoverMap) {
+    _discoverMap = NULL;
+    (void)writeData(DiscoverMap, DiscoverMapSize);
+    if (!waitForMessage(0x41, 0x00, 10) || (rxBuffer[3] != 0x00)) {
       return ERROR;
     }
+    _discoverMap = DiscoverMap;
   }
 
   // Configuring routing
-  Item = 0;
-
   if (modeSE == 2 || modeSE == 3) {  // Emulation or P2P
-    memcpy(&Command[5 + (5 * Item)], (modeSE == 2 ? R_CARDEMU : R_P2P), sizeof((modeSE == 2 ? R_CARDEMU : R_P2P)));
-    Item++;
-
-    if (Item != 0) {
-      memcpy(Command, NCIRouting, sizeof(NCIRouting));
-      Command[2] = 2 + (Item * 5);
-      Command[4] = Item;
-      (void)writeData(Command, 3 + Command[2]);
-      getMessage(10);
-      if ((rxBuffer[0] != 0x41) || (rxBuffer[1] != 0x01) || (rxBuffer[3] != 0x00))
+    if (Routing != _routing) {
+      _routing = NULL;
+      (void)writeData(Routing, RoutingSize);
+      if (!waitForMessage(0x41, 0x01, 10) || (rxBuffer[3] != 0x00))
         return ERROR;
+      _routing = Routing;
     }
-    NCISetConfig_NFCA_SELRSP[6] += (modeSE == 2 ? 0x20 : 0x40);
 
-    if (NCISetConfig_NFCA_SELRSP[6] != 0x00) {
-      (void)writeData(NCISetConfig_NFCA_SELRSP, sizeof(NCISetConfig_NFCA_SELRSP));
-      getMessage(10);
+    if (SelRes != _selRes)
+      config.add(SelRes);
 
-      if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00))
-        return ERROR;
-      else
-        return SUCCESS;
+    if (mode & MODE_P2P and modeSE == 3 and !_p2pConfigured) {
+      config.add(NFC_ATR_REQ_GEN_BYTES::data);
+      config.add(NFC_ATR_RES_GEN_BYTES::data);
     }
 
-    if (mode & MODE_P2P and modeSE == 3) {
-      (void)writeData(NCISetConfig_NFC, sizeof(NCISetConfig_NFC));
-      getMessage(10);
+    _selRes = NULL;
+    if (applyConfig(&config))
+      return ERROR;
+    _selRes = SelRes;
+    if (modeSE == 3)
+      _p2pConfigured = true;
+  }
+  return SUCCESS;
+}
 
-      if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00))
-        return ERROR;
-    }
+/// @brief Send the parameters gathered in config with as few CORE_SET_CONFIG_CMD as possible, the status of each
+/// one is updated in config
+/// @return SUCCESS if all of them were applied, ERROR otherwise or if a parameter could not be added to config
+uint8_t Electroniccats_PN7150::applyConfig(NciConfigBuilder *config) {
+  uint8_t Command[MAX_NCI_FRAME_SIZE];
+  uint8_t first = 0;
+  uint8_t next = 0;
+  uint16_t length;
+
+  if (!config->isValid())
+    return ERROR;
+
+  while ((length = config->buildFrame(first, Command, &next)) != 0) {
+    (void)writeData(Command, length);
+    (void)waitForMessage(0x40, 0x02, 100);  // CORE_SET_CONFIG_RSP, setStatus() fails on nothing
+    if (!config->setStatus(first, next, rxBuffer, rxMessageLength))
+      return ERROR;
+    first = next;
   }
   return SUCCESS;
 }
@@ -373,598 +1016,397 @@ uint8_t Electroniccats_PN7150::configMode() {
 }
 
 bool Electroniccats_PN7150::configureSettings(void) {
-#if NXP_CORE_CONF
-  /* NCI standard dedicated settings
-   * Refer to NFC Forum NCI standard for more details
-   */
-  uint8_t NxpNci_CORE_CONF[] = {
-      0x20, 0x02, 0x05, 0x01, /* CORE_SET_CONFIG_CMD */
-      0x00, 0x02, 0x00, 0x01  /* TOTAL_DURATION */
-  };
-#endif
-
-#if NXP_CORE_CONF_EXTN
-  /* NXP-NCI extension dedicated setting
-   * Refer to NFC controller User Manual for more details
-   */
-  uint8_t NxpNci_CORE_CONF_EXTN[] = {
-      0x20, 0x02, 0x0D, 0x03, /* CORE_SET_CONFIG_CMD */
-      0xA0, 0x40, 0x01, 0x00, /* TAG_DETECTOR_CFG */
-      0xA0, 0x41, 0x01, 0x04, /* TAG_DETECTOR_THRESHOLD_CFG */
-      0xA0, 0x43, 0x01, 0x00  /* TAG_DETECTOR_FALLBACK_CNT_CFG */
-  };
-#endif
+  return Electroniccats_PN7150::configureSettings(NULL, 0);
+}
 
-#if NXP_CORE_STANDBY
-  /* NXP-NCI standby enable setting
-   * Refer to NFC controller User Manual for more details
-   */
-  uint8_t NxpNci_CORE_STANDBY[] = {0x2F, 0x00, 0x01, 0x01}; /* last byte indicates enable/disable */
-#endif
+// Deprecated, use configureSettings(void) instead
+bool Electroniccats_PN7150::ConfigureSettings(void) {
+  return Electroniccats_PN7150::configureSettings();
+}
 
-#if NXP_TVDD_CONF
-  /* NXP-NCI TVDD configuration
-   * Refer to NFC controller Hardware Design Guide document for more details
-   */
-  /* RF configuration related to 1st generation of NXP-NCI controller (e.g PN7120) */
-  uint8_t NxpNci_TVDD_CONF_1stGen[] = {0x20, 0x02, 0x05, 0x01, 0xA0, 0x13, 0x01, 0x00};
+bool Electroniccats_PN7150::configureSettings(uint8_t *uidcf, uint8_t uidlen) {
+  uint8_t NCICoreReset[] = {0x20, 0x00, 0x01, 0x00};
+  uint8_t NCICoreInit[] = {0x20, 0x01, 0x00};
+  uint8_t NFCID1[2 + 10] = {0x33};  // LA_NFCID1
 
-  /* RF configuration related to 2nd generation of NXP-NCI controller (e.g PN7150)*/
-#if (NXP_TVDD_CONF == 1)
-  /* CFG1: Vbat is used to generate the VDD(TX) through TXLDO */
-  uint8_t NxpNci_TVDD_CONF_2ndGen[] = {0x20, 0x02, 0x07, 0x01, 0xA0, 0x0E, 0x03, 0x02, 0x09, 0x00};
-#else
-  /* CFG2: external 5V is used to generate the VDD(TX) through TXLDO */
-  uint8_t NxpNci_TVDD_CONF_2ndGen[] = {0x20, 0x02, 0x07, 0x01, 0xA0, 0x0E, 0x03, 0x06, 0x64, 0x00};
+#if (NXP_TVDD_CONF | NXP_RF_CONF)
+  uint16_t NxpNci_CONF_size = 0;
 #endif
+#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
+  uint8_t NCIWriteTS[3 + 32] = {0xA0, 0x14, 0x20};  // fingerprint of the settings below, stored in place of a build timestamp
+  uint32_t fingerprint = SETTINGS_FINGERPRINT_SEED;
 #endif
+  bool isResetRequired = false;
+  NciConfigBuilder config;  // all the CORE_SET_CONFIG parameters, sent at once
 
-#if NXP_RF_CONF
-  /* NXP-NCI RF configuration
-   * Refer to NFC controller Antenna Design and Tuning Guidelines document for more details
-   */
-  /* RF configuration related to 1st generation of NXP-NCI controller (e.g PN7120) */
-  /* Following configuration is the default settings of PN7120 NFC Controller */
-  uint8_t NxpNci_RF_CONF_1stGen[] = {
-      0x20, 0x02, 0x38, 0x07,
-      0xA0, 0x0D, 0x06, 0x06, 0x42, 0x01, 0x00, 0xF1, 0xFF, /* RF_CLIF_CFG_TARGET          CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x06, 0x44, 0xA3, 0x90, 0x03, 0x00, /* RF_CLIF_CFG_TARGET          CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x34, 0x2D, 0xDC, 0x50, 0x0C, 0x00, /* RF_CLIF_CFG_BR_106_I_RXA_P  CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x04, 0x06, 0x03, 0x00, 0x70,             /* RF_CLIF_CFG_TARGET          CLIF_TRANSCEIVE_CONTROL_REG */
-      0xA0, 0x0D, 0x03, 0x06, 0x16, 0x00,                   /* RF_CLIF_CFG_TARGET          CLIF_TX_UNDERSHOOT_CONFIG_REG */
-      0xA0, 0x0D, 0x03, 0x06, 0x15, 0x00,                   /* RF_CLIF_CFG_TARGET          CLIF_TX_OVERSHOOT_CONFIG_REG */
-      0xA0, 0x0D, 0x06, 0x32, 0x4A, 0x53, 0x07, 0x01, 0x1B  /* RF_CLIF_CFG_BR_106_I_TXA    CLIF_ANA_TX_SHAPE_CONTROL_REG */
-  };
-
-  /* RF configuration related to 2nd generation of NXP-NCI controller (e.g PN7150)*/
-  /* Following configuration relates to performance optimization of OM5578/PN7150 NFC Controller demo kit */
-  uint8_t NxpNci_RF_CONF_2ndGen[] = {
-      0x20, 0x02, 0x94, 0x11,
-      0xA0, 0x0D, 0x06, 0x04, 0x35, 0x90, 0x01, 0xF4, 0x01, /* RF_CLIF_CFG_INITIATOR        CLIF_AGC_INPUT_REG */
-      0xA0, 0x0D, 0x06, 0x06, 0x30, 0x01, 0x90, 0x03, 0x00, /* RF_CLIF_CFG_TARGET           CLIF_SIGPRO_ADCBCM_THRESHOLD_REG */
-      0xA0, 0x0D, 0x06, 0x06, 0x42, 0x02, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_TARGET           CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x20, 0x42, 0x88, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_TECHNO_I_TX15693 CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x04, 0x22, 0x44, 0x23, 0x00,             /* RF_CLIF_CFG_TECHNO_I_RX15693 CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x22, 0x2D, 0x50, 0x34, 0x0C, 0x00, /* RF_CLIF_CFG_TECHNO_I_RX15693 CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x32, 0x42, 0xF8, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_BR_106_I_TXA     CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x34, 0x2D, 0x24, 0x37, 0x0C, 0x00, /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x34, 0x33, 0x86, 0x80, 0x00, 0x70, /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_AGC_CONFIG0_REG */
-      0xA0, 0x0D, 0x04, 0x34, 0x44, 0x22, 0x00,             /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x42, 0x2D, 0x15, 0x45, 0x0D, 0x00, /* RF_CLIF_CFG_BR_848_I_RXA     CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x04, 0x46, 0x44, 0x22, 0x00,             /* RF_CLIF_CFG_BR_106_I_RXB     CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x46, 0x2D, 0x05, 0x59, 0x0E, 0x00, /* RF_CLIF_CFG_BR_106_I_RXB     CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x44, 0x42, 0x88, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_BR_106_I_TXB     CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x56, 0x2D, 0x05, 0x9F, 0x0C, 0x00, /* RF_CLIF_CFG_BR_212_I_RXF_P   CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x54, 0x42, 0x88, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_BR_212_I_TXF     CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x0A, 0x33, 0x80, 0x86, 0x00, 0x70  /* RF_CLIF_CFG_I_ACTIVE         CLIF_AGC_CONFIG0_REG */
-  };
-#endif
+  if (uidlen > sizeof(NFCID1) - 2)
+    return ERROR;
 
+#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
+#if NXP_CORE_CONF_EXTN
+  fingerprint = fingerprintSettings(fingerprint, NxpNci_CORE_CONF_EXTN::data, NxpNci_CORE_CONF_EXTN::length);
+#endif
 #if NXP_CLK_CONF
-  /* NXP-NCI CLOCK configuration
-   * Refer to NFC controller Hardware Design Guide document for more details
-   */
-#if (NXP_CLK_CONF == 1)
-  /* Xtal configuration */
-  uint8_t NxpNci_CLK_CONF[] = {
-      0x20, 0x02, 0x05, 0x01, /* CORE_SET_CONFIG_CMD */
-      0xA0, 0x03, 0x01, 0x08  /* CLOCK_SEL_CFG */
-  };
-#else
-  /* PLL configuration */
-  uint8_t NxpNci_CLK_CONF[] = {
-      0x20, 0x02, 0x09, 0x02, /* CORE_SET_CONFIG_CMD */
-      0xA0, 0x03, 0x01, 0x11, /* CLOCK_SEL_CFG */
-      0xA0, 0x04, 0x01, 0x01  /* CLOCK_TO_CFG */
-  };
+  fingerprint = fingerprintSettings(fingerprint, NxpNci_CLK_CONF::data, NxpNci_CLK_CONF::length);
 #endif
+#if NXP_TVDD_CONF
+  if (NxpNci_CONF_size != 0)
+    fingerprint = fingerprintSettings(fingerprint, NxpNci_TVDD_CONF_2ndGen::data, NxpNci_TVDD_CONF_2ndGen::length);
 #endif
-
-  uint8_t NCICoreReset[] = {0x20, 0x00, 0x01, 0x00};
-  uint8_t NCICoreInit[] = {0x20, 0x01, 0x00};
-  bool gRfSettingsRestored_flag = false;
-
-#if (NXP_TVDD_CONF | NXP_RF_CONF)
-  uint8_t *NxpNci_CONF;
-  uint16_t NxpNci_CONF_size = 0;
+#if NXP_RF_CONF
+  if (NxpNci_CONF_size != 0)
+    fingerprint = fingerprintSettings(fingerprint, NxpNci_RF_CONF_2ndGen::data, NxpNci_RF_CONF_2ndGen::length);
 #endif
-#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
-  uint8_t currentTS[32] = __TIMESTAMP__;
-  uint8_t NCIReadTS[] = {0x20, 0x03, 0x03, 0x01, 0xA0, 0x14};
-  uint8_t NCIWriteTS[7 + 32] = {0x20, 0x02, 0x24, 0x01, 0xA0, 0x14, 0x20};
+  for (uint8_t i = 0; i < 4; i++)
+    NCIWriteTS[3 + i] = (uint8_t)(fingerprint >> (8 * i));
 #endif
-  bool isResetRequired = false;
 
   /* Apply settings */
 #if NXP_CORE_CONF
-  if (sizeof(NxpNci_CORE_CONF) != 0) {
-    isResetRequired = true;
-    (void)writeData(NxpNci_CORE_CONF, sizeof(NxpNci_CORE_CONF));
-    getMessage(10);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CORE_CONF");
+  config.addFrame(NxpNci_CORE_CONF::data, NxpNci_CORE_CONF::length);
 #endif
-      return ERROR;
-    }
+  _totalDuration = 0;
+  if (uidlen != 0) {
+    NFCID1[1] = uidlen;
+    memcpy(&NFCID1[2], uidcf, uidlen);
+    config.add(NFCID1);
   }
-#endif
 
 #if NXP_CORE_STANDBY
-  if (sizeof(NxpNci_CORE_STANDBY) != 0) {
-    (void)(writeData(NxpNci_CORE_STANDBY, sizeof(NxpNci_CORE_STANDBY)));
-    getMessage(10);
-    if ((rxBuffer[0] != 0x4F) || (rxBuffer[1] != 0x00) || (rxBuffer[3] != 0x00)) {
+  (void)writeData(NxpNci_CORE_STANDBY::data, NxpNci_CORE_STANDBY::length);
+  if (!waitForMessage(0x4F, 0x00, 10) || (rxBuffer[3] != 0x00)) {
 #ifdef DEBUG
-      Serial.println("NxpNci_CORE_STANDBY");
+    Serial.println("NxpNci_CORE_STANDBY");
 #endif
-      return ERROR;
-    }
+    return ERROR;
   }
 #endif
 
-  /* All further settings are not versatile, so configuration only applied if there are changes (application build timestamp)
+  /* All further settings are not versatile, so configuration only applied if there are changes (fingerprint of the settings)
      or in case of PN7150B0HN/C11004 Anti-tearing recovery procedure inducing RF setings were restored to their default value */
 #if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
   /* First read timestamp stored in NFC Controller */
-  if (gNfcController_generation == 1)
-    NCIReadTS[5] = 0x0F;
-  (void)writeData(NCIReadTS, sizeof(NCIReadTS));
-  getMessage(10);
-  if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x03) || (rxBuffer[3] != 0x00)) {
+  if (gNfcController_generation == 1) {
+    NCIWriteTS[1] = 0x0F;
+    (void)writeData(NCIReadTS_1stGen::data, NCIReadTS_1stGen::length);
+  } else {
+    (void)writeData(NCIReadTS::data, NCIReadTS::length);
+  }
+  if (!waitForMessage(0x40, 0x03, 10) || (rxBuffer[3] != 0x00)) {
 #ifdef DEBUG
     Serial.println("read timestamp ");
 #endif
     return ERROR;
   }
-  /* Then compare with current build timestamp, and check RF setting restauration flag */
-  /*if(!memcmp(&rxBuffer[8], currentTS, sizeof(currentTS)) && (gRfSettingsRestored_flag == false))
-  {
-      // No change, nothing to do
-  }
-  else
-  {
-      */
-  /* Apply settings */
+  /* Then compare with current fingerprint, and check RF setting restauration flag */
+  if ((rxBuffer[7] == NCIWriteTS[2]) && !memcmp(&rxBuffer[8], &NCIWriteTS[3], NCIWriteTS[2]) && (_rfSettingsRestored == false)) {
+    // No change, nothing to do
 #if NXP_CORE_CONF_EXTN
-  if (sizeof(NxpNci_CORE_CONF_EXTN) != 0) {
-    (void)writeData(NxpNci_CORE_CONF_EXTN, sizeof(NxpNci_CORE_CONF_EXTN));
-    getMessage(10);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CORE_CONF_EXTN");
+    uint16_t Offset = 8 + rxBuffer[7];  // tag detector settings after the fingerprint
+    storeTagDetectorSettings(&rxBuffer[Offset], (rxMessageLength > Offset) ? rxMessageLength - Offset : 0);
 #endif
-      return ERROR;
-    }
-  }
+  } else {
+    /* Apply settings */
+#if NXP_CORE_CONF_EXTN
+    config.addFrame(NxpNci_CORE_CONF_EXTN::data, NxpNci_CORE_CONF_EXTN::length);
+    storeTagDetectorSettings(&NxpNci_CORE_CONF_EXTN::data[4], NxpNci_CORE_CONF_EXTN::length - 4);
 #endif
 
 #if NXP_CLK_CONF
-  if (sizeof(NxpNci_CLK_CONF) != 0) {
     isResetRequired = true;
-
-    (void)writeData(NxpNci_CLK_CONF, sizeof(NxpNci_CLK_CONF));
-    getMessage(10);
-    // NxpNci_HostTransceive(NxpNci_CLK_CONF, sizeof(NxpNci_CLK_CONF), Answer, sizeof(Answer), &AnswerSize);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CLK_CONF");
-#endif
-      return ERROR;
-    }
-  }
+    config.addFrame(NxpNci_CLK_CONF::data, NxpNci_CLK_CONF::length);
 #endif
 
 #if NXP_TVDD_CONF
-  if (NxpNci_CONF_size != 0) {
-    (void)writeData(NxpNci_TVDD_CONF_2ndGen, sizeof(NxpNci_TVDD_CONF_2ndGen));
-    getMessage(10);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CONF_size");
-#endif
-      return ERROR;
-    }
-  }
+    if (NxpNci_CONF_size != 0)
+      config.addFrame(NxpNci_TVDD_CONF_2ndGen::data, NxpNci_TVDD_CONF_2ndGen::length);
 #endif
 
 #if NXP_RF_CONF
-  if (NxpNci_CONF_size != 0) {
-    (void)writeData(NxpNci_RF_CONF_2ndGen, sizeof(NxpNci_RF_CONF_2ndGen));
-    getMessage(10);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CONF_size");
+    if (NxpNci_CONF_size != 0)
+      config.addFrame(NxpNci_RF_CONF_2ndGen::data, NxpNci_RF_CONF_2ndGen::length);
 #endif
-      return ERROR;
-    }
+    /* Store current fingerprint to NFC Controller memory for further checks, once the settings were applied */
+    config.split();
+    config.add(NCIWriteTS);
   }
 #endif
-  /* Store curent timestamp to NFC Controller memory for further checks */
-  if (gNfcController_generation == 1)
-    NCIWriteTS[5] = 0x0F;
-  memcpy(&NCIWriteTS[7], currentTS, sizeof(currentTS));
-  (void)writeData(NCIWriteTS, sizeof(NCIWriteTS));
-  getMessage(10);
-  if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
+
+  if (applyConfig(&config)) {
 #ifdef DEBUG
-    Serial.println("NFC Controller memory");
+    Serial.println("NFC Controller settings");
 #endif
+    _lpcdKnown = false;
     return ERROR;
   }
-  //}
+#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
+  _rfSettingsRestored = false;
 #endif
 
   if (isResetRequired) {
     /* Reset the NFC Controller to insure new settings apply */
     (void)writeData(NCICoreReset, sizeof(NCICoreReset));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x00) || (rxBuffer[3] != 0x00)) {
+    if (!waitForMessage(0x40, 0x00, 5) || (rxBuffer[3] != 0x00)) {
 #ifdef DEBUG
       Serial.println("insure new settings apply");
 #endif
       return ERROR;
     }
+    bool LpcdKnown = _lpcdKnown;  // the PN7150 keeps the tag detector settings across resets
+    forgetControllerState();
+    _lpcdKnown = LpcdKnown;
 
     (void)writeData(NCICoreInit, sizeof(NCICoreInit));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x01) || (rxBuffer[3] != 0x00)) {
+    if (!waitForMessage(0x40, 0x01, 5) || (rxBuffer[3] != 0x00)) {
 #ifdef DEBUG
       Serial.println("insure new settings apply 2");
 #endif
       return ERROR;
     }
   }
-  return SUCCESS;
-}
-
-// Deprecated, use configureSettings(void) instead
-bool Electroniccats_PN7150::ConfigureSettings(void) {
-  return Electroniccats_PN7150::configureSettings();
-}
-
-bool Electroniccats_PN7150::configureSettings(uint8_t *uidcf, uint8_t uidlen) {
+  _settingsApplied = true;
 #if NXP_CORE_CONF
-  /* NCI standard dedicated settings
-   * Refer to NFC Forum NCI standard for more details
-   */
-  uint8_t NxpNci_CORE_CONF[20] = {
-      0x20, 0x02, 0x05, 0x01,  // CORE_SET_CONFIG_CMD
-      0x00, 0x02, 0x00, 0x01   // TOTAL_DURATION
-  };
-
-  if (uidlen == 0)
-    uidlen = 8;
-  else {
-    uidlen += 10;
-    memcpy(&NxpNci_CORE_CONF[0], uidcf, uidlen);
-  }
-
+  _totalDuration = NCI_DISCOVERY_DEFAULT_DURATION;
 #endif
+  return SUCCESS;
+}
 
 #if NXP_CORE_CONF_EXTN
-  /* NXP-NCI extension dedicated setting
-   * Refer to NFC controller User Manual for more details
-   */
-  uint8_t NxpNci_CORE_CONF_EXTN[] = {
-      0x20, 0x02, 0x0D, 0x03, /* CORE_SET_CONFIG_CMD */
-      0xA0, 0x40, 0x01, 0x00, /* TAG_DETECTOR_CFG */
-      0xA0, 0x41, 0x01, 0x04, /* TAG_DETECTOR_THRESHOLD_CFG */
-      0xA0, 0x43, 0x01, 0x00  /* TAG_DETECTOR_FALLBACK_CNT_CFG */
-  };
-#endif
-
-#if NXP_CORE_STANDBY
-  /* NXP-NCI standby enable setting
-   * Refer to NFC controller User Manual for more details
-   */
-  uint8_t NxpNci_CORE_STANDBY[] = {0x2F, 0x00, 0x01, 0x01}; /* last byte indicates enable/disable */
-#endif
-
-#if NXP_TVDD_CONF
-  /* NXP-NCI TVDD configuration
-   * Refer to NFC controller Hardware Design Guide document for more details
-   */
-  /* RF configuration related to 1st generation of NXP-NCI controller (e.g PN7120) */
-  uint8_t NxpNci_TVDD_CONF_1stGen[] = {0x20, 0x02, 0x05, 0x01, 0xA0, 0x13, 0x01, 0x00};
-
-  /* RF configuration related to 2nd generation of NXP-NCI controller (e.g PN7150)*/
-#if (NXP_TVDD_CONF == 1)
-  /* CFG1: Vbat is used to generate the VDD(TX) through TXLDO */
-  uint8_t NxpNci_TVDD_CONF_2ndGen[] = {0x20, 0x02, 0x07, 0x01, 0xA0, 0x0E, 0x03, 0x02, 0x09, 0x00};
-#else
-  /* CFG2: external 5V is used to generate the VDD(TX) through TXLDO */
-  uint8_t NxpNci_TVDD_CONF_2ndGen[] = {0x20, 0x02, 0x07, 0x01, 0xA0, 0x0E, 0x03, 0x06, 0x64, 0x00};
-#endif
-#endif
-
-#if NXP_RF_CONF
-  /* NXP-NCI RF configuration
-   * Refer to NFC controller Antenna Design and Tuning Guidelines document for more details
-   */
-  /* RF configuration related to 1st generation of NXP-NCI controller (e.g PN7120) */
-  /* Following configuration is the default settings of PN7120 NFC Controller */
-  uint8_t NxpNci_RF_CONF_1stGen[] = {
-      0x20, 0x02, 0x38, 0x07,
-      0xA0, 0x0D, 0x06, 0x06, 0x42, 0x01, 0x00, 0xF1, 0xFF, /* RF_CLIF_CFG_TARGET          CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x06, 0x44, 0xA3, 0x90, 0x03, 0x00, /* RF_CLIF_CFG_TARGET          CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x34, 0x2D, 0xDC, 0x50, 0x0C, 0x00, /* RF_CLIF_CFG_BR_106_I_RXA_P  CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x04, 0x06, 0x03, 0x00, 0x70,             /* RF_CLIF_CFG_TARGET          CLIF_TRANSCEIVE_CONTROL_REG */
-      0xA0, 0x0D, 0x03, 0x06, 0x16, 0x00,                   /* RF_CLIF_CFG_TARGET          CLIF_TX_UNDERSHOOT_CONFIG_REG */
-      0xA0, 0x0D, 0x03, 0x06, 0x15, 0x00,                   /* RF_CLIF_CFG_TARGET          CLIF_TX_OVERSHOOT_CONFIG_REG */
-      0xA0, 0x0D, 0x06, 0x32, 0x4A, 0x53, 0x07, 0x01, 0x1B  /* RF_CLIF_CFG_BR_106_I_TXA    CLIF_ANA_TX_SHAPE_CONTROL_REG */
-  };
-
-  /* RF configuration related to 2nd generation of NXP-NCI controller (e.g PN7150)*/
-  /* Following configuration relates to performance optimization of OM5578/PN7150 NFC Controller demo kit */
-  uint8_t NxpNci_RF_CONF_2ndGen[] = {
-      0x20, 0x02, 0x94, 0x11,
-      0xA0, 0x0D, 0x06, 0x04, 0x35, 0x90, 0x01, 0xF4, 0x01, /* RF_CLIF_CFG_INITIATOR        CLIF_AGC_INPUT_REG */
-      0xA0, 0x0D, 0x06, 0x06, 0x30, 0x01, 0x90, 0x03, 0x00, /* RF_CLIF_CFG_TARGET           CLIF_SIGPRO_ADCBCM_THRESHOLD_REG */
-      0xA0, 0x0D, 0x06, 0x06, 0x42, 0x02, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_TARGET           CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x20, 0x42, 0x88, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_TECHNO_I_TX15693 CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x04, 0x22, 0x44, 0x23, 0x00,             /* RF_CLIF_CFG_TECHNO_I_RX15693 CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x22, 0x2D, 0x50, 0x34, 0x0C, 0x00, /* RF_CLIF_CFG_TECHNO_I_RX15693 CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x32, 0x42, 0xF8, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_BR_106_I_TXA     CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x34, 0x2D, 0x24, 0x37, 0x0C, 0x00, /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x34, 0x33, 0x86, 0x80, 0x00, 0x70, /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_AGC_CONFIG0_REG */
-      0xA0, 0x0D, 0x04, 0x34, 0x44, 0x22, 0x00,             /* RF_CLIF_CFG_BR_106_I_RXA_P   CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x42, 0x2D, 0x15, 0x45, 0x0D, 0x00, /* RF_CLIF_CFG_BR_848_I_RXA     CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x04, 0x46, 0x44, 0x22, 0x00,             /* RF_CLIF_CFG_BR_106_I_RXB     CLIF_ANA_RX_REG */
-      0xA0, 0x0D, 0x06, 0x46, 0x2D, 0x05, 0x59, 0x0E, 0x00, /* RF_CLIF_CFG_BR_106_I_RXB     CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x44, 0x42, 0x88, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_BR_106_I_TXB     CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x56, 0x2D, 0x05, 0x9F, 0x0C, 0x00, /* RF_CLIF_CFG_BR_212_I_RXF_P   CLIF_SIGPRO_RM_CONFIG1_REG */
-      0xA0, 0x0D, 0x06, 0x54, 0x42, 0x88, 0x00, 0xFF, 0xFF, /* RF_CLIF_CFG_BR_212_I_TXF     CLIF_ANA_TX_AMPLITUDE_REG */
-      0xA0, 0x0D, 0x06, 0x0A, 0x33, 0x80, 0x86, 0x00, 0x70  /* RF_CLIF_CFG_I_ACTIVE         CLIF_AGC_CONFIG0_REG */
-  };
-#endif
-
-#if NXP_CLK_CONF
-  /* NXP-NCI CLOCK configuration
-   * Refer to NFC controller Hardware Design Guide document for more details
-   */
-#if (NXP_CLK_CONF == 1)
-  /* Xtal configuration */
-  uint8_t NxpNci_CLK_CONF[] = {
-      0x20, 0x02, 0x05, 0x01, /* CORE_SET_CONFIG_CMD */
-      0xA0, 0x03, 0x01, 0x08  /* CLOCK_SEL_CFG */
-  };
-#else
-  /* PLL configuration */
-  uint8_t NxpNci_CLK_CONF[] = {
-      0x20, 0x02, 0x09, 0x02, /* CORE_SET_CONFIG_CMD */
-      0xA0, 0x03, 0x01, 0x11, /* CLOCK_SEL_CFG */
-      0xA0, 0x04, 0x01, 0x01  /* CLOCK_TO_CFG */
-  };
-#endif
+/// @brief Keep the tag detector settings the PN7150 holds, from the parameters of a CORE_GET_CONFIG_RSP or of
+/// the CORE_SET_CONFIG_CMD sent. The ones not listed are the defaults of NxpNci_CORE_CONF_EXTN
+void Electroniccats_PN7150::storeTagDetectorSettings(const uint8_t *params, uint16_t length) {
+  const uint16_t Ids[3] = {0xA040, 0xA041, 0xA043};  // TAG_DETECTOR_CFG, THRESHOLD_CFG and FALLBACK_CNT_CFG
+  uint16_t i = 0;
+
+  _lpcdStored[0] = 0x00;
+  _lpcdStored[1] = NCI_LPCD_DEFAULT_THRESHOLD;
+  _lpcdStored[2] = NCI_LPCD_DEFAULT_FALLBACK;
+  while (i + 3 <= length) {
+    uint16_t Id = (params[i] << 8) | params[i + 1];
+    uint8_t Length = params[i + 2];
+
+    if (i + 3 + Length > length)
+      break;
+    for (uint8_t j = 0; j < 3; j++) {
+      if ((Id == Ids[j]) && (Length == 1))
+        _lpcdStored[j] = params[i + 3];
+    }
+    i += 3 + Length;
+  }
+  _lpcdKnown = true;
+  if (!_lpcdRequested) {  // not written again at each boot before the sketch sets its own
+    _lpcdConfig = _lpcdStored[0] & ~NCI_LPCD_TRACE;
+    _lpcdThreshold = _lpcdStored[1];
+    _lpcdFallback = _lpcdStored[2];
+  }
+}
 #endif
 
-  uint8_t NCICoreReset[] = {0x20, 0x00, 0x01, 0x00};
-  uint8_t NCICoreInit[] = {0x20, 0x01, 0x00};
-  bool gRfSettingsRestored_flag = false;
+// Deprecated, use configureSettings() instead
+bool Electroniccats_PN7150::ConfigureSettings(uint8_t *uidcf, uint8_t uidlen) {
+  return Electroniccats_PN7150::configureSettings(uidcf, uidlen);
+}
 
-#if (NXP_TVDD_CONF | NXP_RF_CONF)
-  uint8_t *NxpNci_CONF;
-  uint16_t NxpNci_CONF_size = 0;
-#endif
-#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
-  uint8_t currentTS[32] = __TIMESTAMP__;
-  uint8_t NCIReadTS[] = {0x20, 0x03, 0x03, 0x01, 0xA0, 0x14};
-  uint8_t NCIWriteTS[7 + 32] = {0x20, 0x02, 0x24, 0x01, 0xA0, 0x14, 0x20};
-#endif
-  bool isResetRequired = false;
+uint8_t Electroniccats_PN7150::StartDiscovery(uint8_t modeSE) {
+  int mode = Electroniccats_PN7150::getMode();
+  uint16_t TotalDuration = NCI_DISCOVERY_DEFAULT_DURATION;
+  uint8_t TotalDurationParam[] = {0x00, 0x02, 0x00, 0x00};  // TOTAL_DURATION
+  uint8_t TagDetectorParams[] = {0xA0, 0x40, 0x01, _lpcdConfig,     // TAG_DETECTOR_CFG
+                                 0xA0, 0x41, 0x01, _lpcdThreshold,  // TAG_DETECTOR_THRESHOLD_CFG
+                                 0xA0, 0x43, 0x01, _lpcdFallback};  // TAG_DETECTOR_FALLBACK_CNT_CFG
+  bool TagDetectorChanged = !_lpcdKnown || (_lpcdStored[0] != _lpcdConfig) || (_lpcdStored[1] != _lpcdThreshold) ||
+                            (_lpcdStored[2] != _lpcdFallback);
+  NciConfigBuilder config;
 
-  /* Apply settings */
-#if NXP_CORE_CONF
-  if (uidlen != 0)  // sizeof(NxpNci_CORE_CONF) != 0)
-  {
-    isResetRequired = true;
-    (void)writeData(NxpNci_CORE_CONF, uidlen);  // sizeof(NxpNci_CORE_CONF));
-    getMessage(100);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CORE_CONF");
-#endif
-      return ERROR;
-    }
+  if (mode != modeSE) {
+    Electroniccats_PN7150::setMode(modeSE);
+    Electroniccats_PN7150::configMode();
   }
-#endif
 
-#if NXP_CORE_STANDBY
-  if (sizeof(NxpNci_CORE_STANDBY) != 0) {
-    (void)(writeData(NxpNci_CORE_STANDBY, sizeof(NxpNci_CORE_STANDBY)));
-    getMessage();
-    if ((rxBuffer[0] != 0x4F) || (rxBuffer[1] != 0x00) || (rxBuffer[3] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CORE_STANDBY");
-#endif
-      return ERROR;
-    }
+  if (modeSE == 1) {
+    NCIStartDiscovery = NCIDiscoverRW::data;
+    NCIStartDiscovery_length = NCIDiscoverRW::length;
+  } else if (modeSE == 2) {
+    NCIStartDiscovery = NCIDiscoverCE::data;
+    NCIStartDiscovery_length = NCIDiscoverCE::length;
+  } else {
+    NCIStartDiscovery = NCIDiscoverP2P::data;
+    NCIStartDiscovery_length = NCIDiscoverP2P::length;
   }
-#endif
 
-  /* All further settings are not versatile, so configuration only applied if there are changes (application build timestamp)
-     or in case of PN7150B0HN/C11004 Anti-tearing recovery procedure inducing RF setings were restored to their default value */
-#if (NXP_CORE_CONF_EXTN | NXP_CLK_CONF | NXP_TVDD_CONF | NXP_RF_CONF)
-  /* First read timestamp stored in NFC Controller */
-  if (gNfcController_generation == 1)
-    NCIReadTS[5] = 0x0F;
-  (void)writeData(NCIReadTS, sizeof(NCIReadTS));
-  getMessage();
-  if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x03) || (rxBuffer[3] != 0x00)) {
-#ifdef DEBUG
-    Serial.println("read timestamp ");
-#endif
-    return ERROR;
+  if (_discoveryProfile != NCI_DISCOVERY_DEFAULT) {
+    if (_discoveryProfile != NCI_DISCOVERY_CUSTOM)
+      buildDiscoveryLoop(NCIStartDiscovery);
+    NCIStartDiscovery = _discoveryLoop.getFrame();
+    NCIStartDiscovery_length = _discoveryLoop.getFrameLength();
+    TotalDuration = _discoveryLoop.getTotalDuration();
   }
-  /* Then compare with current build timestamp, and check RF setting restauration flag */
-  /*if(!memcmp(&rxBuffer[8], currentTS, sizeof(currentTS)) && (gRfSettingsRestored_flag == false))
-  {
-      // No change, nothing to do
-  }
-  else
-  {
-      */
-  /* Apply settings */
-#if NXP_CORE_CONF_EXTN
-  if (sizeof(NxpNci_CORE_CONF_EXTN) != 0) {
-    (void)writeData(NxpNci_CORE_CONF_EXTN, sizeof(NxpNci_CORE_CONF_EXTN));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CORE_CONF_EXTN");
-#endif
-      return ERROR;
-    }
-  }
-#endif
 
-#if NXP_CLK_CONF
-  if (sizeof(NxpNci_CLK_CONF) != 0) {
-    isResetRequired = true;
-
-    (void)writeData(NxpNci_CLK_CONF, sizeof(NxpNci_CLK_CONF));
-    getMessage();
-    // NxpNci_HostTransceive(NxpNci_CLK_CONF, sizeof(NxpNci_CLK_CONF), Answer, sizeof(Answer), &AnswerSize);
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CLK_CONF");
-#endif
-      return ERROR;
-    }
+  if (TotalDuration != _totalDuration) {
+    TotalDurationParam[2] = (uint8_t)TotalDuration;
+    TotalDurationParam[3] = (uint8_t)(TotalDuration >> 8);
+    config.add(TotalDurationParam);
   }
-#endif
-
-#if NXP_TVDD_CONF
-  if (NxpNci_CONF_size != 0) {
-    (void)writeData(NxpNci_TVDD_CONF_2ndGen, sizeof(NxpNci_TVDD_CONF_2ndGen));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CONF_size");
-#endif
-      return ERROR;
-    }
+  if (TagDetectorChanged) {  // only when they change, the PN7150 writes them to its EEPROM
+    config.add(&TagDetectorParams[0]);
+    config.add(&TagDetectorParams[4]);
+    config.add(&TagDetectorParams[8]);
   }
-#endif
-
-#if NXP_RF_CONF
-  if (NxpNci_CONF_size != 0) {
-    (void)writeData(NxpNci_RF_CONF_2ndGen, sizeof(NxpNci_RF_CONF_2ndGen));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("NxpNci_CONF_size");
-#endif
+  if (config.getCount() != 0) {
+    _totalDuration = 0;
+    _lpcdKnown = false;
+    if (applyConfig(&config))
       return ERROR;
-    }
+    _totalDuration = TotalDuration;
+    _lpcdStored[0] = _lpcdConfig;
+    _lpcdStored[1] = _lpcdThreshold;
+    _lpcdStored[2] = _lpcdFallback;
+    _lpcdKnown = true;
   }
-#endif
-  /* Store curent timestamp to NFC Controller memory for further checks */
-  if (gNfcController_generation == 1)
-    NCIWriteTS[5] = 0x0F;
-  memcpy(&NCIWriteTS[7], currentTS, sizeof(currentTS));
-  (void)writeData(NCIWriteTS, sizeof(NCIWriteTS));
-  getMessage();
-  if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x02) || (rxBuffer[3] != 0x00) || (rxBuffer[4] != 0x00)) {
-#ifdef DEBUG
-    Serial.println("NFC Controller memory");
-#endif
+
+  (void)writeData(NCIStartDiscovery, NCIStartDiscovery_length);
+  if (!waitForMessage(0x41, 0x03, 5) || (rxBuffer[3] != 0x00))
     return ERROR;
-  }
-  //}
-#endif
+  else
+    return SUCCESS;
+}
 
-  if (isResetRequired) {
-    /* Reset the NFC Controller to insure new settings apply */
-    (void)writeData(NCICoreReset, sizeof(NCICoreReset));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x00) || (rxBuffer[3] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("insure new settings apply");
-#endif
-      return ERROR;
-    }
+uint8_t Electroniccats_PN7150::startDiscovery() {
+  int mode = Electroniccats_PN7150::getMode();
+  return Electroniccats_PN7150::StartDiscovery(mode);
+}
 
-    (void)writeData(NCICoreInit, sizeof(NCICoreInit));
-    getMessage();
-    if ((rxBuffer[0] != 0x40) || (rxBuffer[1] != 0x01) || (rxBuffer[3] != 0x00)) {
-#ifdef DEBUG
-      Serial.println("insure new settings apply 2");
-#endif
-      return ERROR;
+/// @brief Loop of the profile from the default loop of the mode, NFC-A and listening stay at every loop
+void Electroniccats_PN7150::buildDiscoveryLoop(const uint8_t *modeLoop) {
+  _discoveryLoop.clear();
+  for (uint8_t i = 0; i < modeLoop[3]; i++) {
+    uint8_t ModeTechnology = modeLoop[4 + 2 * i];
+    uint8_t Technology = ModeTechnology & ~MODE_MASK;
+    bool NfcA = (Technology == TECH_PASSIVE_NFCA) || (Technology == TECH_ACTIVE_NFCA);
+
+    if (NfcA || ((ModeTechnology & MODE_MASK) == MODE_LISTEN)) {
+      if (NfcA || (_discoveryProfile == NCI_DISCOVERY_LOW_POWER))
+        (void)_discoveryLoop.add(ModeTechnology, 1);
+    } else if (_discoveryProfile == NCI_DISCOVERY_LOW_POWER) {
+      (void)_discoveryLoop.add(ModeTechnology, NCI_DISCOVERY_LOW_POWER_FREQUENCY);
     }
   }
-  return SUCCESS;
+  if (_discoveryProfile == NCI_DISCOVERY_FAST_NFCA)
+    _discoveryLoop.setTotalDuration(NCI_DISCOVERY_FAST_DURATION);
+  else
+    _discoveryLoop.setTotalDuration(NCI_DISCOVERY_LOW_POWER_DURATION);
 }
 
-// Deprecated, use configureSettings() instead
-bool Electroniccats_PN7150::ConfigureSettings(uint8_t *uidcf, uint8_t uidlen) {
-  return Electroniccats_PN7150::configureSettings(uidcf, uidlen);
+/// @brief Technologies and duration of the discovery loop, applied by the next startDiscovery() or reset()
+/// @return false for NCI_DISCOVERY_CUSTOM, use setDiscoveryLoop() instead
+bool Electroniccats_PN7150::setDiscoveryProfile(NciDiscoveryProfile_t profile) {
+  if (profile == NCI_DISCOVERY_CUSTOM)
+    return false;
+
+  this->_discoveryProfile = profile;
+  return true;
 }
 
-uint8_t Electroniccats_PN7150::StartDiscovery(uint8_t modeSE) {
-  int mode = Electroniccats_PN7150::getMode();
-  if (mode != modeSE) {
-    Electroniccats_PN7150::setMode(modeSE);
-    Electroniccats_PN7150::configMode();
-  }
+NciDiscoveryProfile_t Electroniccats_PN7150::getDiscoveryProfile() const {
+  return _discoveryProfile;
+}
+
+/// @brief Low-power card detection in reader/writer mode, applied by the next startDiscovery() or reset()
+/// @param threshold change of the antenna load that wakes the PN7150 up, see calibrateLowPowerCardDetection()
+/// @param fallback detections before polling anyway, 0 never
+/// @return false if the threshold is 0
+bool Electroniccats_PN7150::setLowPowerCardDetection(bool enable, uint8_t threshold, uint8_t fallback) {
+  if (threshold == 0)
+    return false;
 
-  unsigned char TechTabSize = (modeSE == 1 ? sizeof(DiscoveryTechnologiesRW) : modeSE == 2 ? sizeof(DiscoveryTechnologiesCE)
-                                                                                           : sizeof(DiscoveryTechnologiesP2P));
+  this->_lpcdConfig = enable ? NCI_LPCD_ENABLE : 0x00;
+  this->_lpcdThreshold = threshold;
+  this->_lpcdFallback = fallback;
+  this->_lpcdRequested = true;
+  return true;
+}
 
-  NCIStartDiscovery_length = 0;
-  NCIStartDiscovery[0] = 0x21;
-  NCIStartDiscovery[1] = 0x03;
-  NCIStartDiscovery[2] = (TechTabSize * 2) + 1;
-  NCIStartDiscovery[3] = TechTabSize;
-  for (uint8_t i = 0; i < TechTabSize; i++) {
-    NCIStartDiscovery[(i * 2) + 4] = (modeSE == 1 ? DiscoveryTechnologiesRW[i] : modeSE == 2 ? DiscoveryTechnologiesCE[i]
-                                                                                             : DiscoveryTechnologiesP2P[i]);
+bool Electroniccats_PN7150::isLowPowerCardDetectionEnabled() const {
+  return (_lpcdConfig & NCI_LPCD_ENABLE) != 0;
+}
 
-    NCIStartDiscovery[(i * 2) + 5] = 0x01;
-  }
+uint8_t Electroniccats_PN7150::getLowPowerCardDetectionThreshold() const {
+  return _lpcdThreshold;
+}
 
-  NCIStartDiscovery_length = (TechTabSize * 2) + 4;
-  (void)writeData(NCIStartDiscovery, NCIStartDiscovery_length);
-  getMessage();
+/// @brief Sample the antenna with no card in the field and set the low-power card detection threshold above
+/// its noise, in reader/writer mode. RF_LPCD_TRACE_NTF carries the reference and the measured value, 2 bytes each
+/// @return threshold, 0 if no sample was received or a card was detected
+uint8_t Electroniccats_PN7150::calibrateLowPowerCardDetection(uint8_t samples) {
+  uint8_t Config = _lpcdConfig;
+  uint8_t Received = 0;
+  uint16_t Deviation = 0;
+
+  if (Electroniccats_PN7150::getMode() != mode.READER_WRITER)
+    return 0;
+
+  (void)stopDiscovery();
+  this->_lpcdConfig = NCI_LPCD_ENABLE | NCI_LPCD_TRACE;
+  if (startDiscovery() == SUCCESS) {
+    while (Received < samples) {
+      getMessage(NCI_LPCD_CALIBRATION_TIMEOUT);
+      if (rxMessageLength == 0)
+        break;
+      if (rxFrameKind == NCI_FRAME_RF_INTF_ACTIVATED) {  // a card is in the field
+        Received = 0;
+        break;
+      }
+      if ((rxBuffer[0] == 0x6F) && (rxBuffer[1] == 0x0C) && (rxBuffer[2] >= 4)) {
+        uint16_t Reference = rxBuffer[3] | (rxBuffer[4] << 8);
+        uint16_t Measure = rxBuffer[5] | (rxBuffer[6] << 8);
+        uint16_t Delta = (Measure > Reference) ? (Measure - Reference) : (Reference - Measure);
+        if (Delta > Deviation)
+          Deviation = Delta;
+        Received++;
+      }
+    }
+  }
+  (void)stopDiscovery();
+  this->_lpcdConfig = Config;
 
-  if ((rxBuffer[0] != 0x41) || (rxBuffer[1] != 0x03) || (rxBuffer[3] != 0x00))
-    return ERROR;
-  else
-    return SUCCESS;
+  if (Received == 0)
+    return 0;
+  Deviation += NCI_LPCD_CALIBRATION_MARGIN;
+  this->_lpcdThreshold = (Deviation > 0xFF) ? 0xFF : Deviation;
+  this->_lpcdRequested = true;
+  return _lpcdThreshold;
 }
 
-uint8_t Electroniccats_PN7150::startDiscovery() {
-  int mode = Electroniccats_PN7150::getMode();
-  return Electroniccats_PN7150::StartDiscovery(mode);
+/// @brief Discovery loop used in every mode instead of the one of the profile, applied by the next startDiscovery() or reset()
+/// @param loop copied, NULL goes back to NCI_DISCOVERY_DEFAULT
+/// @return false if the loop has no technology
+bool Electroniccats_PN7150::setDiscoveryLoop(const NciDiscoveryLoop *loop) {
+  if (loop == NULL) {
+    this->_discoveryProfile = NCI_DISCOVERY_DEFAULT;
+    return true;
+  }
+  if (loop->getCount() == 0)
+    return false;
+
+  this->_discoveryLoop = *loop;
+  this->_discoveryProfile = NCI_DISCOVERY_CUSTOM;
+  return true;
 }
 
 bool Electroniccats_PN7150::stopDiscovery() {
   uint8_t NCIStopDiscovery[] = {0x21, 0x06, 0x01, 0x00};
 
+  if (_rfIdle)
+    return SUCCESS;
+
   (void)writeData(NCIStopDiscovery, sizeof(NCIStopDiscovery));
-  getMessage(10);
+  if (!waitForMessage(0x41, 0x06, 10))
+    return SUCCESS;
+  _rfIdle = true;  // stopped now, or already idle if the status is a semantic error
+
+  /* If a remote device was activated RF_DEACTIVATE_NTF follows the response, do not leave it for the next command */
+  if (rxBuffer[3] == 0x00)
+    (void)waitForMessage(0x61, 0x06, 10);
 
   return SUCCESS;
 }
@@ -975,24 +1417,22 @@ bool Electroniccats_PN7150::StopDiscovery() {
 }
 
 bool Electroniccats_PN7150::WaitForDiscoveryNotification(RfIntf_t *pRfIntf, uint16_t tout) {
-  uint8_t NCIRfDiscoverSelect[] = {0x21, 0x04, 0x03, 0x01, protocol.ISODEP, interface.ISODEP};
-
   // P2P Support
   uint8_t NCIStopDiscovery[] = {0x21, 0x06, 0x01, 0x00};
   uint8_t NCIRestartDiscovery[] = {0x21, 0x06, 0x01, 0x03};
   uint8_t saved_NTF[7];
 
-  gNextTag_Protocol = PROT_UNDETERMINED;
   bool getFlag = false;
 wait:
   do {
     getFlag = getMessage(
         tout > 0 ? tout : 1337);  // Infinite loop, waiting for response
-  } while (((rxBuffer[0] != 0x61) || ((rxBuffer[1] != 0x05) && (rxBuffer[1] != 0x03))) && (getFlag == true));
-  gNextTag_Protocol = PROT_UNDETERMINED;
+  } while ((rxFrameKind != NCI_FRAME_RF_INTF_ACTIVATED) && (rxFrameKind != NCI_FRAME_RF_DISCOVER) && (getFlag == true));
+  if (getFlag == false)
+    return ERROR;  // nothing detected
 
   /* Is RF_INTF_ACTIVATED_NTF ? */
-  if (rxBuffer[1] == 0x05) {
+  if (rxFrameKind == NCI_FRAME_RF_INTF_ACTIVATED) {
     pRfIntf->Interface = rxBuffer[4];
     remoteDevice.setInterface(rxBuffer[4]);
     pRfIntf->Protocol = rxBuffer[5];
@@ -1010,14 +1450,14 @@ wait:
       while (1) {
         /* Restart the discovery loop */
         (void)writeData(NCIRestartDiscovery, sizeof(NCIRestartDiscovery));
-        getMessage();
-        getMessage(100);
+        if (waitForMessage(0x41, 0x06, 5) && (rxBuffer[3] == 0x00))
+          (void)waitForMessage(0x61, 0x06, 100);
         /* Wait for discovery */
         do {
           getMessage(1000);  // Infinite loop, waiting for response
-        } while ((rxMessageLength == 4) && (rxBuffer[0] == 0x60) && (rxBuffer[1] == 0x07));
+        } while (rxFrameKind == NCI_FRAME_CORE_GENERIC_ERROR);
 
-        if ((rxMessageLength != 0) && (rxBuffer[0] == 0x61) && (rxBuffer[1] == 0x05)) {
+        if (rxFrameKind == NCI_FRAME_RF_INTF_ACTIVATED) {
           /* Is same device detected ? */
           if (memcmp(saved_NTF, rxBuffer, sizeof(saved_NTF)) == 0)
             break;
@@ -1042,8 +1482,8 @@ wait:
 
             /* Restart the discovery loop */
             (void)writeData(NCIRestartDiscovery, sizeof(NCIRestartDiscovery));
-            getMessage();
-            getMessage(100);
+            if (waitForMessage(0x41, 0x06, 5) && (rxBuffer[3] == 0x00))
+              (void)waitForMessage(0x61, 0x06, 100);
           }
           goto wait;
         }
@@ -1059,55 +1499,25 @@ wait:
     pRfIntf->MoreTags = true;
     remoteDevice.setMoreTagsAvailable(true);
 
-    /* Get next NTF for further activation */
-    do {
-      if (!getMessage(100))
-        return ERROR;
-    } while ((rxBuffer[0] != 0x61) || (rxBuffer[1] != 0x03));
-    gNextTag_Protocol = rxBuffer[4];
-
-    /* Remaining NTF ? */
-
-    while (rxBuffer[rxMessageLength - 1] == 0x02)
-      getMessage(100);
+    /* Remaining NTF ? They are all kept in the inventory */
+    while (rxBuffer[rxMessageLength - 1] == 0x02) {
+      do {
+        if (!getMessage(100))
+          return ERROR;
+      } while (rxFrameKind != NCI_FRAME_RF_DISCOVER);
+    }
 
     /* In case of multiple cards, select the first one */
-    NCIRfDiscoverSelect[4] = remoteDevice.getProtocol();
-    if (remoteDevice.getProtocol() == protocol.ISODEP)
-      NCIRfDiscoverSelect[5] = interface.ISODEP;
-    else if (remoteDevice.getProtocol() == protocol.NFCDEP)
-      NCIRfDiscoverSelect[5] = interface.NFCDEP;
-    else if (remoteDevice.getProtocol() == protocol.MIFARE)
-      NCIRfDiscoverSelect[5] = interface.TAGCMD;
-    else
-      NCIRfDiscoverSelect[5] = interface.FRAME;
-
-    (void)writeData(NCIRfDiscoverSelect, sizeof(NCIRfDiscoverSelect));
-    getMessage(100);
-
-    if ((rxBuffer[0] == 0x41) || (rxBuffer[1] == 0x04) || (rxBuffer[3] == 0x00)) {
-      (void)writeData(rxBuffer, rxMessageLength);
-      getMessage(100);
-
-      if ((rxBuffer[0] == 0x61) || (rxBuffer[1] == 0x05)) {
-        pRfIntf->Interface = rxBuffer[4];
-        remoteDevice.setInterface(rxBuffer[4]);
-        pRfIntf->Protocol = rxBuffer[5];
-        remoteDevice.setProtocol(rxBuffer[5]);
-        pRfIntf->ModeTech = rxBuffer[6];
-        remoteDevice.setModeTech(rxBuffer[6]);
-        remoteDevice.setInfo(pRfIntf, &rxBuffer[10]);
-      }
-
+    if (activateInventoryTag(0, pRfIntf, false) != SUCCESS) {
       /* In case of P2P target detected but lost, inform application to restart discovery */
-      else if (remoteDevice.getProtocol() == protocol.NFCDEP) {
+      if (remoteDevice.getProtocol() == protocol.NFCDEP) {
         /* Restart the discovery loop */
         (void)writeData(NCIStopDiscovery, sizeof(NCIStopDiscovery));
-        getMessage();
-        getMessage(100);
+        if (waitForMessage(0x41, 0x06, 5) && (rxBuffer[3] == 0x00))
+          (void)waitForMessage(0x61, 0x06, 100);
 
         (void)writeData(NCIStartDiscovery, NCIStartDiscovery_length);
-        getMessage();
+        (void)waitForMessage(0x41, 0x03, 5);
 
         goto wait;
       }
@@ -1127,49 +1537,112 @@ bool Electroniccats_PN7150::isTagDetected(uint16_t tout) {
   return !Electroniccats_PN7150::WaitForDiscoveryNotification(&this->dummyRfInterface, tout);
 }
 
-bool Electroniccats_PN7150::cardModeSend(unsigned char *pData, unsigned char DataSize) {
-  bool status;
-  uint8_t Cmd[MAX_NCI_FRAME_SIZE];
+/// @brief Wait for the tags in the field, the first one is activated and all of them are kept in the inventory
+/// @return number of tags found, 0 if none
+uint8_t Electroniccats_PN7150::inventoryTags(uint16_t tout) {
+  if (!isTagDetected(tout))
+    return 0;
+  return _inventory.getCount();
+}
 
-  /* Compute and send DATA_PACKET */
-  Cmd[0] = 0x00;
-  Cmd[1] = 0x00;
-  Cmd[2] = DataSize;
-  memcpy(&Cmd[3], pData, DataSize);
-  (void)writeData(Cmd, DataSize + 3);
+const NciInventory *Electroniccats_PN7150::getInventory() const {
+  return &_inventory;
+}
+
+/// @brief Activate a tag of the inventory, the active one is put to sleep first
+/// @param discoveryId RF discovery ID of the tag, see NciInventoryTag
+bool Electroniccats_PN7150::selectTag(uint8_t discoveryId) {
+  uint8_t index = _inventory.find(discoveryId);
+
+  if (index == NCI_INVENTORY_NONE)
+    return false;
+  return !activateInventoryTag(index, &this->dummyRfInterface, true);
+}
+
+/// @brief RF_DISCOVER_SELECT_CMD of a tag of the inventory
+/// @param deactivate put the active tag to sleep first
+bool Electroniccats_PN7150::activateInventoryTag(uint8_t index, RfIntf_t *pRfIntf, bool deactivate) {
+  uint8_t NCIDeactivateSleep[] = {0x21, 0x06, 0x01, 0x01};
+  uint8_t NCIRfDiscoverSelect[] = {0x21, 0x04, 0x03, 0x01, PROT_ISODEP, INTF_ISODEP};
+  const NciInventoryTag *Tag = _inventory.getTag(index);
+  bool status = ERROR;
+
+  if (Tag == NULL)
+    return ERROR;
+
+  if (deactivate) {
+    (void)writeData(NCIDeactivateSleep, sizeof(NCIDeactivateSleep));
+    if (!waitForMessage(0x41, 0x06, 5) || (rxBuffer[3] != 0x00))
+      return ERROR;
+    if (!waitForMessage(0x61, 0x06, 100))
+      return ERROR;
+  }
+
+  NCIRfDiscoverSelect[3] = Tag->id;
+  NCIRfDiscoverSelect[4] = Tag->protocol;
+  if (Tag->protocol == PROT_ISODEP)
+    NCIRfDiscoverSelect[5] = INTF_ISODEP;
+  else if (Tag->protocol == PROT_NFCDEP)
+    NCIRfDiscoverSelect[5] = INTF_NFCDEP;
+  else if (Tag->protocol == PROT_MIFARE)
+    NCIRfDiscoverSelect[5] = INTF_TAGCMD;
+  else
+    NCIRfDiscoverSelect[5] = INTF_FRAME;
+
+  (void)writeData(NCIRfDiscoverSelect, sizeof(NCIRfDiscoverSelect));
+  if (waitForMessage(0x41, 0x04, 5) && (rxBuffer[3] == 0x00)) {
+    if (waitForMessage(0x61, 0x05, 100)) {
+      pRfIntf->Interface = rxBuffer[4];
+      remoteDevice.setInterface(rxBuffer[4]);
+      pRfIntf->Protocol = rxBuffer[5];
+      remoteDevice.setProtocol(rxBuffer[5]);
+      pRfIntf->ModeTech = rxBuffer[6];
+      remoteDevice.setModeTech(rxBuffer[6]);
+      remoteDevice.setInfo(pRfIntf, &rxBuffer[10]);
+      status = SUCCESS;
+    }
+  }
+
+  _inventoryNext = index + 1;
+  pRfIntf->MoreTags = (_inventoryNext < _inventory.getCount());
+  remoteDevice.setMoreTagsAvailable(pRfIntf->MoreTags);
   return status;
 }
 
+bool Electroniccats_PN7150::cardModeSend(unsigned char *pData, unsigned short DataSize) {
+  /* Compute and send DATA_PACKET */
+  return sendDataPacket(pData, DataSize) ? SUCCESS : ERROR;
+}
+
 // Deprecated, use cardModeSend() instead
 bool Electroniccats_PN7150::CardModeSend(unsigned char *pData, unsigned char DataSize) {
   return Electroniccats_PN7150::cardModeSend(pData, DataSize);
 }
 
 bool Electroniccats_PN7150::cardModeReceive(unsigned char *pData, unsigned char *pDataSize) {
+  unsigned short DataSize;
+  bool status;
+
+  status = cardModeReceive(pData, MaxPayloadSize, &DataSize);
+  *pDataSize = DataSize;
+  return status;
+}
+
+/// @brief Receive data of any length from the reader, DataBufferSize is the size of pData
+/// @return SUCCESS if the whole data fitted in pData
+bool Electroniccats_PN7150::cardModeReceive(unsigned char *pData, unsigned short DataBufferSize, unsigned short *pDataSize) {
 #ifdef DEBUG2
   Serial.println("[DEBUG] cardModeReceive exec");
 #endif
 
   delay(1);
 
-  bool status = NFC_ERROR;
-  uint8_t Ans[MAX_NCI_FRAME_SIZE];
-
-  (void)writeData(Ans, 255);
-  getMessage(2000);
-
-  /* Is data packet ? */
-  if ((rxBuffer[0] == 0x00) && (rxBuffer[1] == 0x00)) {
+  if (!receiveDataPacket(pData, DataBufferSize, pDataSize, 2000))
+    return NFC_ERROR;
 #ifdef DEBUG2
-    Serial.println(rxBuffer[2]);
+  Serial.println(*pDataSize);
 #endif
-    *pDataSize = rxBuffer[2];
-    memcpy(pData, &rxBuffer[3], *pDataSize);
-    status = NFC_SUCCESS;
-  } else {
-    status = NFC_ERROR;
-  }
-  return status;
+  return NFC_SUCCESS;
 }
 
 // Deprecated, use cardModeReceive() instead
@@ -1178,7 +1651,8 @@ bool Electroniccats_PN7150::CardModeReceive(unsigned char *pData, unsigned char
 }
 
 void Electroniccats_PN7150::ProcessCardMode(RfIntf_t RfIntf) {
-  uint8_t Answer[MAX_NCI_FRAME_SIZE];
+  uint8_t Apdu[PN7150_MAX_DATA_SIZE];
+  unsigned short ApduSize;
 
   uint8_t NCIStopDiscovery[] = {0x21, 0x06, 0x01, 0x00};
   bool FirstCmd = true;
@@ -1189,39 +1663,31 @@ void Electroniccats_PN7150::ProcessCardMode(RfIntf_t RfIntf) {
   getMessage(2000);
 
   while (rxMessageLength > 0) {
-    getMessage(2000);
     /* is RF_DEACTIVATE_NTF ? */
-    if ((rxBuffer[0] == 0x61) && (rxBuffer[1] == 0x06)) {
+    if (rxFrameKind == NCI_FRAME_RF_DEACTIVATE) {
       if (FirstCmd) {
         /* Restart the discovery loop */
         (void)writeData(NCIStopDiscovery, sizeof(NCIStopDiscovery));
-        getMessage();
-        do {
-          if ((rxBuffer[0] == 0x41) && (rxBuffer[1] == 0x06))
-            break;
-          getMessage(100);
-        } while (rxMessageLength != 0);
+        (void)waitForMessage(0x41, 0x06, 100);
         (void)writeData(NCIStartDiscovery, NCIStartDiscovery_length);
-        getMessage();
+        (void)waitForMessage(0x41, 0x03, 5);
       }
       /* Come back to discovery state */
     }
     /* is DATA_PACKET ? */
-    else if ((rxBuffer[0] == 0x00) && (rxBuffer[1] == 0x00)) {
+    else if (rxFrameKind == NCI_FRAME_DATA) {
       /* DATA_PACKET */
       uint8_t Cmd[MAX_NCI_FRAME_SIZE];
       uint16_t CmdSize;
 
-      T4T_NDEF_EMU_Next(&rxBuffer[3], rxBuffer[2], &Cmd[3], (unsigned short *)&CmdSize);
-
-      Cmd[0] = 0x00;
-      Cmd[1] = (CmdSize & 0xFF00) >> 8;
-      Cmd[2] = CmdSize & 0x00FF;
+      if (reassembleDataPacket(Apdu, sizeof(Apdu), &ApduSize, 100)) {
+        T4T_NDEF_EMU_Next(Apdu, ApduSize, Cmd, (unsigned short *)&CmdSize);
 
-      (void)writeData(Cmd, CmdSize + 3);
-      getMessage();
+        (void)sendDataPacket(Cmd, CmdSize);
+      }
     }
     FirstCmd = false;
+    getMessage(2000);
   }
 }
 
@@ -1263,20 +1729,20 @@ void Electroniccats_PN7150::processP2pMode(RfIntf_t RfIntf) {
   if ((RfIntf.ModeTech & MODE_LISTEN) != MODE_LISTEN) {
     /* Initiate communication (SYMM PDU) */
     (void)writeData(NCILlcpSymm, sizeof(NCILlcpSymm));
-    getMessage();
 
     /* Save status for discovery restart */
     restart = true;
   }
-  status = ERROR;
-  getMessage(2000);
-  if (rxMessageLength > 0)
-    status = SUCCESS;
+  /* The credits of the packets sent are given back meanwhile, see handleCredits() */
+  do {
+    getMessage(2000);
+  } while (rxFrameKind == NCI_FRAME_CORE_CONN_CREDITS);
+  status = (rxMessageLength > 0) ? SUCCESS : ERROR;
 
   /* Get frame from remote peer */
   while (status == SUCCESS) {
     /* is DATA_PACKET ? */
-    if ((rxBuffer[0] == 0x00) && (rxBuffer[1] == 0x00)) {
+    if (rxFrameKind == NCI_FRAME_DATA) {
       uint8_t Cmd[MAX_NCI_FRAME_SIZE];
       uint16_t CmdSize;
       /* Handle P2P communication */
@@ -1285,55 +1751,46 @@ void Electroniccats_PN7150::processP2pMode(RfIntf_t RfIntf) {
       Cmd[0] = 0x00;
       Cmd[1] = (CmdSize & 0xFF00) >> 8;
       Cmd[2] = CmdSize & 0x00FF;
-      status = ERROR;
       (void)writeData(Cmd, CmdSize + 3);
-      getMessage();
-      if (rxMessageLength > 0)
-        status = SUCCESS;
     }
     /* is CORE_INTERFACE_ERROR_NTF ?*/
-    else if ((rxBuffer[0] == 0x60) && (rxBuffer[1] == 0x08)) {
+    else if (rxFrameKind == NCI_FRAME_CORE_INTERFACE_ERROR) {
       /* Come back to discovery state */
       break;
     }
     /* is RF_DEACTIVATE_NTF ? */
-    else if ((rxBuffer[0] == 0x61) && (rxBuffer[1] == 0x06)) {
+    else if (rxFrameKind == NCI_FRAME_RF_DEACTIVATE) {
       /* Come back to discovery state */
       break;
     }
     /* is RF_DISCOVERY_NTF ? */
-    else if ((rxBuffer[0] == 0x61) && ((rxBuffer[1] == 0x05) || (rxBuffer[1] == 0x03))) {
+    else if ((rxFrameKind == NCI_FRAME_RF_INTF_ACTIVATED) || (rxFrameKind == NCI_FRAME_RF_DISCOVER)) {
       do {
-        if ((rxBuffer[0] == 0x61) && ((rxBuffer[1] == 0x05) || (rxBuffer[1] == 0x03))) {
+        if ((rxFrameKind == NCI_FRAME_RF_INTF_ACTIVATED) || (rxFrameKind == NCI_FRAME_RF_DISCOVER)) {
           if ((rxBuffer[6] & MODE_LISTEN) != MODE_LISTEN)
             restart = true;
           else
             restart = false;
         }
-        status = ERROR;
-        (void)writeData(rxBuffer, rxMessageLength);
-        getMessage();
-        if (rxMessageLength > 0)
-          status = SUCCESS;
+        getMessage(100);
       } while (rxMessageLength != 0);
       /* Come back to discovery state */
       break;
     }
 
     /* Wait for next frame from remote P2P, or notification event */
-    status = ERROR;
-    (void)writeData(rxBuffer, rxMessageLength);
-    getMessage();
-    if (rxMessageLength > 0)
-      status = SUCCESS;
+    do {
+      getMessage(2000);
+    } while (rxFrameKind == NCI_FRAME_CORE_CONN_CREDITS);
+    status = (rxMessageLength > 0) ? SUCCESS : ERROR;
   }
 
   /* Is Initiator mode ? */
   if (restart) {
     /* Communication ended, restart discovery loop */
     (void)writeData(NCIRestartDiscovery, sizeof(NCIRestartDiscovery));
-    getMessage();
-    getMessage(100);
+    if (waitForMessage(0x41, 0x06, 5) && (rxBuffer[3] == 0x00))
+      (void)waitForMessage(0x61, 0x06, 100);
   }
 }
 
@@ -1345,12 +1802,15 @@ void Electroniccats_PN7150::ProcessP2pMode(RfIntf_t RfIntf) {
 void Electroniccats_PN7150::presenceCheck(RfIntf_t RfIntf) {
   bool status;
   uint8_t i;
+  uint8_t Rsp[32];
+  unsigned short RspSize;
 
-  uint8_t NCIPresCheckT1T[] = {0x00, 0x00, 0x07, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-  uint8_t NCIPresCheckT2T[] = {0x00, 0x00, 0x02, 0x30, 0x00};
+  /* Data packet payloads, sent with sendDataPacket() */
+  uint8_t NCIPresCheckT1T[] = {0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint8_t NCIPresCheckT2T[] = {0x30, 0x00};
   uint8_t NCIPresCheckT3T[] = {0x21, 0x08, 0x04, 0xFF, 0xFF, 0x00, 0x01};
   uint8_t NCIPresCheckIsoDep[] = {0x2F, 0x11, 0x00};
-  uint8_t NCIPresCheckIso15693[] = {0x00, 0x00, 0x0B, 0x26, 0x01, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint8_t NCIPresCheckIso15693[] = {0x26, 0x01, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
   uint8_t NCIDeactivate[] = {0x21, 0x06, 0x01, 0x01};
   uint8_t NCISelectMIFARE[] = {0x21, 0x04, 0x03, 0x01, 0x80, 0x80};
 
@@ -1358,52 +1818,44 @@ void Electroniccats_PN7150::presenceCheck(RfIntf_t RfIntf) {
     case PROT_T1T:
       do {
         delay(500);
-        (void)writeData(NCIPresCheckT1T, sizeof(NCIPresCheckT1T));
-        getMessage();
-        getMessage(100);
-      } while ((rxBuffer[0] == 0x00) && (rxBuffer[1] == 0x00));
+        (void)sendDataPacket(NCIPresCheckT1T, sizeof(NCIPresCheckT1T));
+      } while (receiveDataPacket(Rsp, sizeof(Rsp), &RspSize, 100));
       break;
 
     case PROT_T2T:
       do {
         delay(500);
-        (void)writeData(NCIPresCheckT2T, sizeof(NCIPresCheckT2T));
-        getMessage();
-        getMessage(100);
-      } while ((rxBuffer[0] == 0x00) && (rxBuffer[1] == 0x00) && (rxBuffer[2] == 0x11));
+        (void)sendDataPacket(NCIPresCheckT2T, sizeof(NCIPresCheckT2T));
+      } while (receiveDataPacket(Rsp, sizeof(Rsp), &RspSize, 100) && (RspSize == 0x11));
       break;
 
     case PROT_T3T:
       do {
         delay(500);
         (void)writeData(NCIPresCheckT3T, sizeof(NCIPresCheckT3T));
-        getMessage();
-        getMessage(100);
-      } while ((rxBuffer[0] == 0x61) && (rxBuffer[1] == 0x08) && ((rxBuffer[3] == 0x00) || (rxBuffer[4] > 0x00)));
+        (void)waitForMessage(0x41, 0x08, 5);
+      } while (waitForMessage(0x61, 0x08, 100) && ((rxBuffer[3] == 0x00) || (rxBuffer[4] > 0x00)));
       break;
 
     case PROT_ISODEP:
       do {
         delay(500);
         (void)writeData(NCIPresCheckIsoDep, sizeof(NCIPresCheckIsoDep));
-        getMessage();
-        getMessage(100);
-      } while ((rxBuffer[0] == 0x6F) && (rxBuffer[1] == 0x11) && (rxBuffer[2] == 0x01) && (rxBuffer[3] == 0x01));
+        (void)waitForMessage(0x4F, 0x11, 5);
+      } while (waitForMessage(0x6F, 0x11, 100) && (rxBuffer[2] == 0x01) && (rxBuffer[3] == 0x01));
       break;
 
     case PROT_ISO15693:
       do {
         delay(500);
         for (i = 0; i < 8; i++) {
-          NCIPresCheckIso15693[i + 6] = remoteDevice.getID()[7 - i];
+          NCIPresCheckIso15693[i + 3] = remoteDevice.getID()[7 - i];
         }
-        (void)writeData(NCIPresCheckIso15693, sizeof(NCIPresCheckIso15693));
-        getMessage();
-        getMessage(100);
+        (void)sendDataPacket(NCIPresCheckIso15693, sizeof(NCIPresCheckIso15693));
         status = ERROR;
-        if (rxMessageLength)
+        if (receiveDataPacket(Rsp, sizeof(Rsp), &RspSize, 100) && (RspSize > 0))
           status = SUCCESS;
-      } while ((status == SUCCESS) && (rxBuffer[0] == 0x00) && (rxBuffer[1] == 0x00) && (rxBuffer[rxMessageLength - 1] == 0x00));
+      } while ((status == SUCCESS) && (Rsp[RspSize - 1] == 0x00));
       break;
 
     case PROT_MIFARE:
@@ -1411,20 +1863,25 @@ void Electroniccats_PN7150::presenceCheck(RfIntf_t RfIntf) {
         delay(500);
         /* Deactivate target */
         (void)writeData(NCIDeactivate, sizeof(NCIDeactivate));
-        getMessage();
-        getMessage(100);
+        if (waitForMessage(0x41, 0x06, 5) && (rxBuffer[3] == 0x00))
+          (void)waitForMessage(0x61, 0x06, 100);
 
         /* Reactivate target */
+        _reselecting = true;
         (void)writeData(NCISelectMIFARE, sizeof(NCISelectMIFARE));
-        getMessage();
-        getMessage(100);
-      } while ((rxBuffer[0] == 0x61) && (rxBuffer[1] == 0x05));
+        (void)waitForMessage(0x41, 0x04, 5);
+        status = waitForMessage(0x61, 0x05, 100);
+        _reselecting = false;
+      } while (status);
       break;
 
     default:
       /* Nothing to do */
-      break;
+      return;
   }
+
+  if (_events != NULL)
+    _events->add(NCI_EVENT_TAG_DEPARTED, micros());
 }
 
 void Electroniccats_PN7150::waitForTagRemoval() {
@@ -1436,30 +1893,211 @@ void Electroniccats_PN7150::PresenceCheck(RfIntf_t RfIntf) {
   Electroniccats_PN7150::presenceCheck(RfIntf);
 }
 
-bool Electroniccats_PN7150::readerTagCmd(unsigned char *pCommand, unsigned char CommandSize, unsigned char *pAnswer, unsigned char *pAnswerSize) {
-  bool status = ERROR;
-  uint8_t Cmd[MAX_NCI_FRAME_SIZE];
+/* Probes of the presence monitor, the data packets go on the static RF connection */
+static const uint8_t PresenceProbeT1T[] = {0x00, 0x00, 0x07, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};  // RID
+static const uint8_t PresenceProbeT2T[] = {0x00, 0x00, 0x02, 0x30, 0x00};                                // READ of block 0
+static const uint8_t PresenceProbeT3T[] = {0x21, 0x08, 0x04, 0xFF, 0xFF, 0x00, 0x01};                    // RF_T3T_POLLING_CMD
+static const uint8_t PresenceProbeIsoDep[] = {0x2F, 0x11, 0x00};                                         // proprietary presence check
+static const uint8_t PresenceProbeIso15693[] = {0x00, 0x00, 0x0B, 0x26, 0x01, 0x40};                     // INVENTORY, the UID follows
+static const uint8_t PresenceSleepMIFARE[] = {0x21, 0x06, 0x01, 0x01};                                   // RF_DEACTIVATE_CMD to sleep
+static const uint8_t PresenceSelectMIFARE[] = {0x21, 0x04, 0x03, 0x01, 0x80, 0x80};                      // RF_DISCOVER_SELECT_CMD
+
+/// @brief Probe the active tag from poll() rather than blocking like waitForTagRemoval(), the callback is called
+/// by poll() once the tag left. Nothing else must be exchanged with the tag while the monitor runs
+/// @param interval ms between the answer to a probe and the next one
+/// @return false if no tag is active in poll mode
+bool Electroniccats_PN7150::startPresenceMonitor(NciPresenceCallback_t *callback, void *context, uint16_t interval) {
+  if (remoteDevice.getModeTech() & MODE_LISTEN)
+    return false;
 
-  /* Compute and send DATA_PACKET */
-  Cmd[0] = 0x00;
-  Cmd[1] = 0x00;
-  Cmd[2] = CommandSize;
-  memcpy(&Cmd[3], pCommand, CommandSize);
+  switch (remoteDevice.getProtocol()) {
+    case PROT_T1T:
+    case PROT_T2T:
+    case PROT_T3T:
+    case PROT_ISODEP:
+    case PROT_ISO15693:
+    case PROT_MIFARE:
+      break;
+    default:
+      return false;
+  }
 
-  (void)writeData(Cmd, CommandSize + 3);
-  getMessage();
-  getMessage(1000);
-  /* Wait for Answer 1S */
+  _presenceCallback = callback;
+  _presenceContext = context;
+  _presenceInterval = interval;
+  setPresenceState(NCI_PRESENCE_WAITING);
+  return true;
+}
+
+/// @brief The answer to a probe still on its way is ignored
+void Electroniccats_PN7150::stopPresenceMonitor() {
+  _presenceState = NCI_PRESENCE_STOPPED;
+}
+
+NciPresenceState_t Electroniccats_PN7150::getPresenceState() const {
+  return _presenceState;
+}
+
+void Electroniccats_PN7150::setPresenceState(NciPresenceState_t state) {
+  _presenceState = state;
+  _presenceSince = millis();
+}
+
+/// @brief Called by poll(): sends the next probe, times out the notifications and reports the removal
+void Electroniccats_PN7150::runPresenceMonitor() {
+  const uint8_t *probe = NULL;
+  uint16_t length = 0;
+  NciPresenceState_t next = NCI_PRESENCE_PROBING;
+  unsigned long elapsed = millis() - _presenceSince;
+
+  if (((_presenceState == NCI_PRESENCE_CHECKING) || (_presenceState == NCI_PRESENCE_SLEEPING) || (_presenceState == NCI_PRESENCE_SELECTING)) &&
+      (elapsed >= NCI_PRESENCE_TIMEOUT))
+    setPresenceState(NCI_PRESENCE_LEFT);
+
+  /* Probes wait for the commands of the application */
+  if ((_presenceState == NCI_PRESENCE_WAITING) && (elapsed >= _presenceInterval) && (_commands.getCount() == 0)) {
+    switch (remoteDevice.getProtocol()) {
+      case PROT_T1T:
+        probe = PresenceProbeT1T;
+        length = sizeof(PresenceProbeT1T);
+        break;
+      case PROT_T2T:
+        probe = PresenceProbeT2T;
+        length = sizeof(PresenceProbeT2T);
+        break;
+      case PROT_T3T:
+        probe = PresenceProbeT3T;
+        length = sizeof(PresenceProbeT3T);
+        break;
+      case PROT_ISODEP:
+        probe = PresenceProbeIsoDep;
+        length = sizeof(PresenceProbeIsoDep);
+        break;
+      case PROT_ISO15693:
+        memcpy(_presenceProbe, PresenceProbeIso15693, sizeof(PresenceProbeIso15693));
+        for (uint8_t i = 0; i < 8; i++) {
+          _presenceProbe[sizeof(PresenceProbeIso15693) + i] = remoteDevice.getID()[7 - i];
+        }
+        probe = _presenceProbe;
+        length = sizeof(PresenceProbeIso15693) + 8;
+        break;
+      case PROT_MIFARE:
+        probe = PresenceSleepMIFARE;
+        length = sizeof(PresenceSleepMIFARE);
+        next = NCI_PRESENCE_SLEEPING;
+        break;
+      default:
+        break;
+    }
+    if ((probe != NULL) && _commands.push(probe, length, NCI_PRESENCE_TIMEOUT, Electroniccats_PN7150::presenceAnswered, this))
+      setPresenceState(next);
+  }
+
+  if (_presenceState == NCI_PRESENCE_LEFT) {
+    _presenceState = NCI_PRESENCE_STOPPED;
+    if (_events != NULL)
+      _events->add(NCI_EVENT_TAG_DEPARTED, micros());
+    if (_presenceCallback != NULL)
+      _presenceCallback(_presenceContext);
+  }
+}
+
+/// @brief Response or data packet answering a probe
+void Electroniccats_PN7150::presenceAnswered(NciCommandStatus_t status, const uint8_t *response, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+  bool present;
+
+  if ((nfc->_presenceState != NCI_PRESENCE_PROBING) && (nfc->_presenceState != NCI_PRESENCE_SLEEPING) && (nfc->_presenceState != NCI_PRESENCE_SELECTING))
+    return;  // stopped meanwhile
+  if (status != NCI_COMMAND_COMPLETED) {
+    nfc->setPresenceState(NCI_PRESENCE_LEFT);
+    return;
+  }
+
+  /* The result of the commands comes in a notification */
+  if ((response[0] & 0xE0) == 0x40) {
+    if ((length < 4) || (response[3] != 0x00))
+      nfc->setPresenceState(NCI_PRESENCE_LEFT);
+    else if (nfc->_presenceState == NCI_PRESENCE_PROBING)
+      nfc->setPresenceState(NCI_PRESENCE_CHECKING);
+    return;
+  }
+
+  switch (nfc->remoteDevice.getProtocol()) {
+    case PROT_T2T:
+      present = ((response[0] & 0xE0) == 0x00) && (response[2] == 0x11);
+      break;
+    case PROT_ISO15693:
+      present = ((response[0] & 0xE0) == 0x00) && (response[2] > 0) && (response[length - 1] == 0x00);
+      break;
+    default:
+      present = ((response[0] & 0xE0) == 0x00);
+      break;
+  }
+  nfc->setPresenceState(present ? NCI_PRESENCE_WAITING : NCI_PRESENCE_LEFT);
+}
+
+/// @brief Notifications of the presence checks, and the deactivations which end the monitoring
+void Electroniccats_PN7150::handlePresence(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context) {
+  Electroniccats_PN7150 *nfc = (Electroniccats_PN7150 *)context;
+  NciPresenceState_t state = nfc->_presenceState;
+
+  if ((state == NCI_PRESENCE_STOPPED) || (state == NCI_PRESENCE_LEFT))
+    return;
+
+  switch (kind) {
+    case NCI_FRAME_NOTIFICATION:
+      if ((frame[0] == 0x60) && (frame[1] == 0x00))  // CORE_RESET_NTF
+        nfc->setPresenceState(NCI_PRESENCE_LEFT);
+      else if ((state == NCI_PRESENCE_CHECKING) && (frame[0] == 0x6F) && (frame[1] == 0x11) && (length > 3))
+        nfc->setPresenceState((frame[3] == 0x01) ? NCI_PRESENCE_WAITING : NCI_PRESENCE_LEFT);
+      else if ((state == NCI_PRESENCE_CHECKING) && (frame[0] == 0x61) && (frame[1] == 0x08) && (length > 4))
+        nfc->setPresenceState(((frame[3] == 0x00) || (frame[4] > 0x00)) ? NCI_PRESENCE_WAITING : NCI_PRESENCE_LEFT);
+      break;
+
+    case NCI_FRAME_RF_DEACTIVATE:
+      if ((state == NCI_PRESENCE_SLEEPING) && (length > 3) && (frame[3] == 0x01) &&
+          nfc->_commands.push(PresenceSelectMIFARE, sizeof(PresenceSelectMIFARE), NCI_PRESENCE_TIMEOUT, Electroniccats_PN7150::presenceAnswered, nfc))
+        nfc->setPresenceState(NCI_PRESENCE_SELECTING);
+      else
+        nfc->setPresenceState(NCI_PRESENCE_LEFT);
+      break;
+
+    case NCI_FRAME_RF_INTF_ACTIVATED:
+      if (state == NCI_PRESENCE_SELECTING)
+        nfc->setPresenceState(NCI_PRESENCE_WAITING);
+      break;
+
+    case NCI_FRAME_CORE_GENERIC_ERROR:
+      if (state == NCI_PRESENCE_SELECTING)
+        nfc->setPresenceState(NCI_PRESENCE_LEFT);
+      break;
 
-  if ((rxBuffer[0] == 0x0) && (rxBuffer[1] == 0x0))
-    status = SUCCESS;
+    default:
+      break;
+  }
+}
 
-  *pAnswerSize = rxBuffer[2];
-  memcpy(pAnswer, &rxBuffer[3], *pAnswerSize);
+bool Electroniccats_PN7150::readerTagCmd(unsigned char *pCommand, unsigned char CommandSize, unsigned char *pAnswer, unsigned char *pAnswerSize) {
+  unsigned short AnswerSize;
+  bool status;
 
+  status = readerTagCmd(pCommand, (unsigned short)CommandSize, pAnswer, MaxPayloadSize, &AnswerSize);
+  *pAnswerSize = AnswerSize;
   return status;
 }
 
+/// @brief Exchange data of any length with the tag, AnswerBufferSize is the size of pAnswer
+/// @return SUCCESS if the whole answer fitted in pAnswer
+bool Electroniccats_PN7150::readerTagCmd(unsigned char *pCommand, unsigned short CommandSize, unsigned char *pAnswer, unsigned short AnswerBufferSize, unsigned short *pAnswerSize) {
+  *pAnswerSize = 0;
+  if (!sendDataPacket(pCommand, CommandSize))
+    return ERROR;
+
+  /* Wait for Answer 1S */
+  return receiveDataPacket(pAnswer, AnswerBufferSize, pAnswerSize, 1000) ? SUCCESS : ERROR;
+}
+
 // Deprecated, use readerTagCmd() instead
 bool Electroniccats_PN7150::ReaderTagCmd(unsigned char *pCommand, unsigned char CommandSize, unsigned char *pAnswer, unsigned char *pAnswerSize) {
   return Electroniccats_PN7150::readerTagCmd(pCommand, CommandSize, pAnswer, pAnswerSize);
@@ -1471,18 +2109,17 @@ bool Electroniccats_PN7150::readerReActivate() {
 
   /* First de-activate the target */
   (void)writeData(NCIDeactivate, sizeof(NCIDeactivate));
-  getMessage();
-  getMessage(100);
+  if (waitForMessage(0x41, 0x06, 5) && (rxBuffer[3] == 0x00))
+    (void)waitForMessage(0x61, 0x06, 100);
 
   /* Then re-activate the target */
   NCIActivate[4] = remoteDevice.getProtocol();
   NCIActivate[5] = remoteDevice.getInterface();
 
-  (void)writeData(NCIDeactivate, sizeof(NCIDeactivate));
-  getMessage();
-  getMessage(100);
-
-  if ((rxBuffer[0] != 0x61) || (rxBuffer[1] != 0x05))
+  (void)writeData(NCIActivate, sizeof(NCIActivate));
+  if (!waitForMessage(0x41, 0x04, 5) || (rxBuffer[3] != 0x00))
+    return ERROR;
+  if (!waitForMessage(0x61, 0x05, 100))
     return ERROR;
   return SUCCESS;
 }
@@ -1493,15 +2130,11 @@ bool Electroniccats_PN7150::ReaderReActivate(RfIntf_t *pRfIntf) {
 }
 
 bool Electroniccats_PN7150::ReaderActivateNext(RfIntf_t *pRfIntf) {
-  uint8_t NCIStopDiscovery[] = {0x21, 0x06, 0x01, 0x01};
-  uint8_t NCIRfDiscoverSelect[] = {0x21, 0x04, 0x03, 0x02, PROT_ISODEP, INTF_ISODEP};
-
-  bool status = ERROR;
-
   pRfIntf->MoreTags = false;
   remoteDevice.setMoreTagsAvailable(false);
 
-  if (gNextTag_Protocol == protocol.UNDETERMINED) {
+  /* Every tag of the inventory was activated */
+  if (_inventoryNext >= _inventory.getCount()) {
     pRfIntf->Interface = INTF_UNDETERMINED;
     remoteDevice.setInterface(interface.UNDETERMINED);
     pRfIntf->Protocol = PROT_UNDETERMINED;
@@ -1509,89 +2142,72 @@ bool Electroniccats_PN7150::ReaderActivateNext(RfIntf_t *pRfIntf) {
     return ERROR;
   }
 
-  /* First disconnect current tag */
-  (void)writeData(NCIStopDiscovery, sizeof(NCIStopDiscovery));
-  getMessage();
-
-  if ((rxBuffer[0] != 0x41) && (rxBuffer[1] != 0x06) && (rxBuffer[3] != 0x00))
-    return ERROR;
-  getMessage(100);
-
-  if ((rxBuffer[0] != 0x61) && (rxBuffer[1] != 0x06))
-    return ERROR;
-
-  NCIRfDiscoverSelect[4] = gNextTag_Protocol;
-  if (gNextTag_Protocol == PROT_ISODEP)
-    NCIRfDiscoverSelect[5] = INTF_ISODEP;
-  else if (gNextTag_Protocol == PROT_ISODEP)
-    NCIRfDiscoverSelect[5] = INTF_NFCDEP;
-  else if (gNextTag_Protocol == PROT_MIFARE)
-    NCIRfDiscoverSelect[5] = INTF_TAGCMD;
-  else
-    NCIRfDiscoverSelect[5] = INTF_FRAME;
-
-  (void)writeData(NCIRfDiscoverSelect, sizeof(NCIRfDiscoverSelect));
-  getMessage();
-
-  if ((rxBuffer[0] == 0x41) && (rxBuffer[1] == 0x04) && (rxBuffer[3] == 0x00)) {
-    getMessage(100);
-    if ((rxBuffer[0] == 0x61) || (rxBuffer[1] == 0x05)) {
-      pRfIntf->Interface = rxBuffer[4];
-      remoteDevice.setInterface(rxBuffer[4]);
-      pRfIntf->Protocol = rxBuffer[5];
-      remoteDevice.setProtocol(rxBuffer[5]);
-      pRfIntf->ModeTech = rxBuffer[6];
-      remoteDevice.setModeTech(rxBuffer[6]);
-      remoteDevice.setInfo(pRfIntf, &rxBuffer[10]);
-      status = SUCCESS;
-    }
-  }
-
-  return status;
+  return activateInventoryTag(_inventoryNext, pRfIntf, true);
 }
 
 bool Electroniccats_PN7150::activateNextTagDiscovery() {
   return !Electroniccats_PN7150::ReaderActivateNext(&this->dummyRfInterface);
 }
 
+/* Length of the message given to the pull callback by the NDEF reader, for the event of readNdef() */
+static RW_NDEF_Callback_t *NdefRead_PullCb;
+static unsigned short NdefRead_size;
+static bool NdefRead_done;
+
+static void recordNdefRead(unsigned char *pMessage, unsigned short Message_size) {
+  NdefRead_done = true;
+  NdefRead_size = Message_size;
+  if (NdefRead_PullCb != NULL)
+    NdefRead_PullCb(pMessage, Message_size);
+}
+
 void Electroniccats_PN7150::readNdef(RfIntf_t RfIntf) {
   uint8_t Cmd[MAX_NCI_FRAME_SIZE];
   uint16_t CmdSize = 0;
-
+  uint8_t Rsp[PN7150_MAX_DATA_SIZE];
+  unsigned short RspSize = rxBuffer[2];
+  uint8_t *pRsp = &rxBuffer[3];
+  bool recording = (_events != NULL);
+
+  if (recording) {
+    NdefRead_PullCb = pRW_NDEF_PullCb;
+    NdefRead_done = false;
+    pRW_NDEF_PullCb = recordNdefRead;
+  }
+  RW_NDEF_SetCache(_ndefCache, remoteDevice.getNFCID(), remoteDevice.getNFCIDLen());
+  RW_NDEF_SetApduSize(sizeof(Rsp));
   RW_NDEF_Reset(remoteDevice.getProtocol());
 
   while (1) {
-    RW_NDEF_Read_Next(&rxBuffer[3], rxBuffer[2], &Cmd[3], (unsigned short *)&CmdSize);
+    RW_NDEF_Read_Next(pRsp, RspSize, Cmd, (unsigned short *)&CmdSize);
     if (CmdSize == 0) {
       /// End of the Read operation
       break;
     } else {
-      // Compute and send DATA_PACKET
-      Cmd[0] = 0x00;
-      Cmd[1] = (CmdSize & 0xFF00) >> 8;
-      Cmd[2] = CmdSize & 0x00FF;
+      /* The tag went back to IDLE, e.g. a T2T without GET_VERSION */
+      if (RW_NdefReActivate) {
+        RW_NdefReActivate = false;
+        _reselecting = true;
+        (void)readerReActivate();
+        _reselecting = false;
+      }
 
-      (void)writeData(Cmd, CmdSize + 3);
-      getMessage();
-      getMessage(1000);
-
-      // Manage chaining in case of T4T
-      if (remoteDevice.getInterface() == INTF_ISODEP && rxBuffer[0] == 0x10) {
-        uint8_t tmp[MAX_NCI_FRAME_SIZE];
-        uint8_t tmpSize = 0;
-        while (rxBuffer[0] == 0x10) {
-          memcpy(&tmp[tmpSize], &rxBuffer[3], rxBuffer[2]);
-          tmpSize += rxBuffer[2];
-          getMessage(100);
-        }
-        memcpy(&tmp[tmpSize], &rxBuffer[3], rxBuffer[2]);
-        tmpSize += rxBuffer[2];
-        //* Compute all chained frame into one unique answer
-        memcpy(&rxBuffer[3], tmp, tmpSize);
-        rxBuffer[2] = tmpSize;
+      // Send DATA_PACKET, chained answers are put back together
+      (void)sendDataPacket(Cmd, CmdSize);
+      if (receiveDataPacket(Rsp, sizeof(Rsp), &RspSize, 1000)) {
+        pRsp = Rsp;
+      } else {
+        pRsp = &rxBuffer[3];  // Error or timeout, the reader checks the last frame
+        RspSize = rxBuffer[2];
       }
     }
   }
+
+  if (recording) {
+    pRW_NDEF_PullCb = NdefRead_PullCb;
+    if (NdefRead_done && (_events != NULL))
+      _events->add(NCI_EVENT_NDEF_READ, micros(), NdefRead_size);
+  }
 }
 
 void Electroniccats_PN7150::readNdefMessage(void) {
@@ -1604,25 +2220,33 @@ void Electroniccats_PN7150::ReadNdef(RfIntf_t RfIntf) {
 }
 
 void Electroniccats_PN7150::writeNdef(RfIntf_t RfIntf) {
-  uint8_t Cmd[MAX_NCI_FRAME_SIZE];
+  uint8_t Cmd[PN7150_MAX_DATA_SIZE];  // UPDATE BINARY, extended if the tag and PN7150_MAX_DATA_SIZE allow it
   uint16_t CmdSize = 0;
-
+  uint8_t Rsp[PN7150_MAX_DATA_SIZE];
+  unsigned short RspSize = rxBuffer[2];
+  uint8_t *pRsp = &rxBuffer[3];
+
+  /* The message changes, it must be read from the tag next time */
+  if (_ndefCache != NULL)
+    _ndefCache->remove(remoteDevice.getNFCID(), remoteDevice.getNFCIDLen());
+  RW_NDEF_SetDifferential(_differentialWrite);
+  RW_NDEF_SetApduSize(sizeof(Cmd));
   RW_NDEF_Reset(remoteDevice.getProtocol());
 
   while (1) {
-    RW_NDEF_Write_Next(&rxBuffer[3], rxBuffer[2], &Cmd[3], (unsigned short *)&CmdSize);
+    RW_NDEF_Write_Next(pRsp, RspSize, Cmd, (unsigned short *)&CmdSize);
     if (CmdSize == 0) {
       // End of the Write operation
       break;
     } else {
-      // Compute and send DATA_PACKET
-      Cmd[0] = 0x00;
-      Cmd[1] = (CmdSize & 0xFF00) >> 8;
-      Cmd[2] = CmdSize & 0x00FF;
-
-      (void)writeData(Cmd, CmdSize + 3);
-      getMessage();
-      getMessage(2000);
+      // Send DATA_PACKET, chained answers are put back together
+      (void)sendDataPacket(Cmd, CmdSize);
+      if (receiveDataPacket(Rsp, sizeof(Rsp), &RspSize, 2000)) {
+        pRsp = Rsp;
+      } else {
+        pRsp = &rxBuffer[3];  // Error or timeout, the writer checks the last frame
+        RspSize = rxBuffer[2];
+      }
     }
   }
 }
@@ -1655,9 +2279,8 @@ bool Electroniccats_PN7150::nciFactoryTestPrbs(NxpNci_TechType_t type, NxpNci_Bi
   }
 
   if (NxpNci_cmd_size != 0) {
-    (void)writeData(NxpNci_cmd, sizeof(NxpNci_cmd));
-    getMessage();
-    if ((rxBuffer[0] != 0x4F) || (rxBuffer[1] != 0x30) || (rxBuffer[3] != 0x00))
+    (void)writeData(NxpNci_cmd, NxpNci_cmd_size);
+    if (!waitForMessage(0x4F, 0x30, 5) || (rxBuffer[3] != 0x00))
       return ERROR;
   } else {
     return ERROR;
@@ -1675,8 +2298,7 @@ bool Electroniccats_PN7150::nciFactoryTestRfOn() {
   uint8_t NCIRfOn[] = {0x2F, 0x3D, 0x02, 0x20, 0x01};
 
   (void)writeData(NCIRfOn, sizeof(NCIRfOn));
-  getMessage();
-  if ((rxBuffer[0] != 0x4F) || (rxBuffer[1] != 0x3D) || (rxBuffer[3] != 0x00))
+  if (!waitForMessage(0x4F, 0x3D, 5) || (rxBuffer[3] != 0x00))
     return ERROR;
 
   return SUCCESS;
@@ -1692,8 +2314,8 @@ bool Electroniccats_PN7150::reset() {
     return false;
   }
 
-  // Configure settings only if we have not detected a tag yet
-  if (remoteDevice.getProtocol() == protocol.UNDETERMINED) {
+  // Configure settings only if we have not detected a tag yet, and the PN7150 does not hold them already
+  if ((remoteDevice.getProtocol() == protocol.UNDETERMINED) && !_settingsApplied) {
     if (Electroniccats_PN7150::configureSettings()) {
       return false;
     }
@@ -20,20 +20,29 @@
 
 #include <Arduino.h>  // Gives us access to all typical Arduino types and functions
                       // The HW interface between The PN7150 and the DeviceHost is I2C, so we need the I2C library.library
+#include "LinuxTransport.h"
 #include "Mode.h"
+#include "NciCommandQueue.h"
+#include "NciConfigBuilder.h"
+#include "NciDiscoveryLoop.h"
+#include "NciDispatcher.h"
+#include "NciEventQueue.h"
+#include "NciFrame.h"
+#include "NciInventory.h"
+#include "NciMetrics.h"
+#include "NciRingBuffer.h"
+#include "NciSimulator.h"
+#include "NciTrace.h"
+#include "NciTraceReplay.h"
+#include "NciTransport.h"
+#include "NdefCache.h"
 #include "NdefMessage.h"
 #include "NdefRecord.h"
 #include "P2P_NDEF.h"
 #include "RemoteDevice.h"
 #include "T4T_NDEF_emu.h"
+#include "TwoWireTransport.h"
 
-#if defined(TEENSYDUINO) && defined(KINETISK)  // Teensy 3.0, 3.1, 3.2, 3.5, 3.6 :  Special, more optimized I2C library for Teensy boards
-#include <i2c_t3.h>                            // Credits Brian "nox771" : see https://forum.pjrc.com/threads/21680-New-I2C-library-for-Teensy3
-#else
-#include <Wire.h>
-#endif
-
-#define NO_PN7150_RESET_PIN 255
 /* Following definitions specifies which settings will apply when NxpNci_ConfigureSettings()
  * API is called from the application
  */
@@ -53,6 +62,14 @@
 #define ERROR NFC_ERROR
 #define MAX_NCI_FRAME_SIZE 258
 
+/*
+ * Largest data exchanged with the remote device in one go by the NDEF readers and the
+ * card emulation, chained packets are put back together in a buffer of this size
+ */
+#ifndef PN7150_MAX_DATA_SIZE
+#define PN7150_MAX_DATA_SIZE 261  // Short APDU: header, Lc = 255, data and Le
+#endif
+
 /*
  * Flag definition used for NFC library configuration
  */
@@ -61,8 +78,40 @@
 #define MODE_RW (1 << 2)
 
 #define MaxPayloadSize 255  // See NCI specification V1.0, section 3.1
+#define NCI_CREDITS_UNLIMITED 0xFF  // Initial credits of a connection without flow control
 #define MsgHeaderSize 3
 
+/*
+ * Low-power card detection (TAG_DETECTOR_CFG): between the polling loops the PN7150 only senses
+ * the antenna and powers the RF field once a card changes its load by more than the threshold
+ */
+#define NCI_LPCD_ENABLE 0x01
+#define NCI_LPCD_TRACE 0x02  // RF_LPCD_TRACE_NTF with the reference and measured values, for the calibration
+#define NCI_LPCD_DEFAULT_THRESHOLD 0x04
+#define NCI_LPCD_DEFAULT_FALLBACK 0x00  // detections before falling back to polling, 0 never
+#define NCI_LPCD_CALIBRATION_SAMPLES 16
+#define NCI_LPCD_CALIBRATION_MARGIN 2  // added to the largest deviation sampled
+#define NCI_LPCD_CALIBRATION_TIMEOUT 2000
+
+/*
+ * Presence monitor run by poll(): the active tag is probed every interval, the callback is
+ * called once it does not answer anymore
+ */
+#define NCI_PRESENCE_INTERVAL 50  // ms between the answer to a probe and the next one
+#define NCI_PRESENCE_TIMEOUT 100  // ms to answer a probe
+
+typedef enum {
+  NCI_PRESENCE_STOPPED,
+  NCI_PRESENCE_WAITING,    // tag present, until the next probe
+  NCI_PRESENCE_PROBING,    // probe sent, waiting for its answer
+  NCI_PRESENCE_CHECKING,   // ISO-DEP and T3T, waiting for the notification with the result
+  NCI_PRESENCE_SLEEPING,   // MIFARE Classic, waiting for the tag to be put to sleep
+  NCI_PRESENCE_SELECTING,  // MIFARE Classic, waiting for the tag to be activated again
+  NCI_PRESENCE_LEFT        // removal seen, the callback is called by the next poll()
+} NciPresenceState_t;
+
+typedef void NciPresenceCallback_t(void *context);
+
 /***** Factory Test dedicated APIs *********************************************/
 #ifdef NFC_FACTORY_TEST
 
@@ -100,22 +149,94 @@ typedef enum {
 class Electroniccats_PN7150 : public Mode {
  private:
   bool _hasBeenInitialized;
-  uint8_t _IRQpin, _VENpin, _I2Caddress;
-  TwoWire *_wire;
+  TwoWireTransport _twoWireTransport;
+  NciTransport *_transport;
   RfIntf_t dummyRfInterface;
   uint8_t rxBuffer[MaxPayloadSize + MsgHeaderSize];  // buffer where we store bytes received until they form a complete message
   unsigned long timeOut;
   unsigned long timeOutStartTime;
   uint32_t rxMessageLength;  // length of the last message received. As these are not 0x00 terminated, we need to remember the length
+  NciRingBuffer *_rxRing;    // frames received but not yet consumed by getMessage(), given by enableInterruptMode()
+  bool _interruptMode;
+  volatile bool _irqPending;
+  mutable volatile bool _busLocked;  // set while the main context owns the I2C bus
+  NciTrace *_trace;                  // receives a copy of every frame when set
+  NdefCache *_ndefCache;             // messages of the tags already read, when set
+  bool _differentialWrite;           // writeNdef() only writes what differs from the tag
+  NciEventQueue *_events;            // receives the tag events when set
+#ifdef PN7150_METRICS
+  mutable NciMetrics _metrics;
+#endif
+  NciCommandQueue _commands;           // commands run by poll()
+  NciFrameCallback_t *_frameCallback;  // frames received by poll() that answer no command
+  void *_frameCallbackContext;
+  uint8_t _maxDataPayload;   // of the RF connection, from RF_INTF_ACTIVATED_NTF
+  mutable uint8_t _credits;  // data packets the PN7150 can take on the RF connection
+  bool _rfSettingsRestored;  // anti-tearing recovery put the RF settings back to their defaults
+  /* What the PN7150 holds, so a mode switch only sends what differs. NULL or false when unknown */
+  bool _settingsApplied;         // configureSettings() ran since the last reset of the PN7150
+  mutable bool _rfIdle;          // stopped, no RF_DISCOVER_CMD sent since
+  bool _propActivated;           // proprietary RF interface enabled
+  const uint8_t *_discoverMap;   // RF_DISCOVER_MAP_CMD applied
+  const uint8_t *_routing;       // RF_SET_LISTEN_MODE_ROUTING_CMD applied
+  const uint8_t *_selRes;        // LA_SEL_INFO parameter applied
+  bool _p2pConfigured;           // ATR general bytes applied
+  uint16_t _totalDuration;       // TOTAL_DURATION applied, 0 when unknown
+  NciDiscoveryProfile_t _discoveryProfile;
+  NciDiscoveryLoop _discoveryLoop;  // loop of the profile, or the one of setDiscoveryLoop()
+  uint8_t _lpcdConfig;              // TAG_DETECTOR_CFG, THRESHOLD_CFG and FALLBACK_CNT_CFG to apply
+  uint8_t _lpcdThreshold;
+  uint8_t _lpcdFallback;
+  uint8_t _lpcdStored[3];  // the ones the PN7150 holds, it keeps them across resets
+  bool _lpcdKnown;         // _lpcdStored was read back or written since the last reset
+  bool _lpcdRequested;     // set by the sketch, until then they follow the PN7150
+  mutable NciInventory _inventory;  // tags of the current discovery, emptied when it starts again
+  uint8_t _inventoryNext;           // tag activated by activateNextTagDiscovery()
+  NciPresenceState_t _presenceState;
+  NciPresenceCallback_t *_presenceCallback;
+  void *_presenceContext;
+  uint16_t _presenceInterval;
+  unsigned long _presenceSince;  // of the current state
+  uint8_t _presenceProbe[14];    // data packet or command sent by the monitor
+  bool _reselecting;             // activation made by the driver itself (presence check, reader fallback), not an event
+  uint8_t _lastError;            // status of the last error notification
+  NciDispatcher _dispatcher;
+  NciFrameKind_t rxFrameKind;  // kind of the last message received, decoded once by the dispatcher
+  void init();
+  void storeTagDetectorSettings(const uint8_t *params, uint16_t length);
+  static void interruptHandler(void *context);
+  void onInterrupt();
+  void drainMessages();
+  uint16_t popFrame(uint8_t *frame);
+  unsigned long remainingTime() const;
+  void resetController();
   uint8_t gNfcController_generation = 0;
   uint8_t gNfcController_fw_version[3] = {0};
   void setTimeOut(unsigned long);  // set a timeOut for an expected next event, eg reception of Response after sending a Command
   bool isTimeOut() const;
   uint8_t wakeupNCI();
   bool getMessage(uint16_t timeout = 5);  // 5 miliseconds as default to wait for interrupt responses
+  bool waitForMessage(uint8_t header, uint8_t oid, uint16_t timeout);
+  NciFrameKind_t onFrameReceived(const uint8_t *frame, uint16_t length);
+  static void handleActivation(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handleDeactivation(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handleCredits(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handleReset(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handleDiscovery(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handleError(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handleData(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void handlePresence(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+  static void presenceAnswered(NciCommandStatus_t status, const uint8_t *response, uint16_t length, void *context);
+  void setPresenceState(NciPresenceState_t state);
+  void runPresenceMonitor();
+  bool activateInventoryTag(uint8_t index, RfIntf_t *pRfIntf, bool deactivate);
+  bool reassembleDataPacket(uint8_t *data, uint16_t size, uint16_t *length, uint16_t timeout);
+  bool waitForCredit(uint16_t timeout);
+  void buildDiscoveryLoop(const uint8_t *modeLoop);
 
  public:
   Electroniccats_PN7150(uint8_t IRQpin, uint8_t VENpin, uint8_t I2Caddress, TwoWire *wire = &Wire);
+  Electroniccats_PN7150(NciTransport *transport);
   uint8_t begin(void);
   RemoteDevice remoteDevice;
   Protocol protocol;
@@ -123,13 +244,44 @@ class Electroniccats_PN7150 : public Mode {
   ModeTech modeTech;
   Interface interface;
   bool hasMessage() const;
-  uint8_t writeData(uint8_t data[], uint32_t dataLength) const;  // write data from DeviceHost to PN7150. Returns success (0) or Fail (> 0)
-  uint32_t readData(uint8_t data[]) const;                       // read data from PN7150, returns the amount of bytes read
+  bool enableInterruptMode(NciRingBuffer *ring);
+  void disableInterruptMode();
+  bool isInterruptModeEnabled() const;
+  void processInterrupt();
+  uint8_t writeData(const uint8_t data[], uint32_t dataLength) const;  // write data from DeviceHost to PN7150. Returns success (0) or Fail (> 0)
+  uint32_t readData(uint8_t data[]) const;                             // read data from PN7150, returns the amount of bytes read
+  bool sendDataPacket(const uint8_t *data, uint16_t length);
+  bool receiveDataPacket(uint8_t *data, uint16_t size, uint16_t *length, uint16_t timeout = 1000);
+  uint8_t getCredits() const;
+  uint8_t getLastError() const;
+  void setReadStrategy(NxpNci_ReadStrategy_t strategy, uint8_t readSize = PN7150_DEFAULT_READ_SIZE);  // Only for the TwoWire transport
+  NxpNci_ReadStrategy_t getReadStrategy() const;
+  void setTrace(NciTrace *trace);
+  NciTrace *getTrace() const;
+  void setNdefCache(NdefCache *cache);
+  NdefCache *getNdefCache() const;
+  void setNdefBuffer(uint8_t *buffer, uint16_t size);
+  void setDifferentialWrite(bool enable);
+  bool getDifferentialWrite() const;
+  void setEventQueue(NciEventQueue *events);
+  NciEventQueue *getEventQueue() const;
+  const NciMetrics *getMetrics() const;
+  void resetMetrics();
+  bool submitCommand(const uint8_t *command, uint16_t length, NciCommandCallback_t *callback, void *context = NULL, uint16_t timeout = 1000);
+  bool submitCommand(const uint8_t *command, uint16_t length, NciCommandFuture *future, uint16_t timeout = 1000);
+  void setFrameCallback(NciFrameCallback_t *callback, void *context = NULL);
+  bool addFrameHandler(NciFrameKind_t kind, NciFrameHandler_t *handler, void *context = NULL);
+  bool removeFrameHandler(NciFrameKind_t kind, NciFrameHandler_t *handler);
+  void poll();
+  uint8_t getPendingCommands() const;
+  void cancelCommands();
   int getFirmwareVersion();
   int GetFwVersion();  // Deprecated, use getFirmwareVersion() instead
   uint8_t connectNCI();
   uint8_t ConfigMode(uint8_t modeSE);  // Deprecated, use configMode(void) instead
   uint8_t configMode(void);
+  uint8_t applyConfig(NciConfigBuilder *config);
+  void forgetControllerState();
   bool setReaderWriterMode();
   bool setEmulationMode();
   bool setP2PMode();
@@ -140,12 +292,23 @@ class Electroniccats_PN7150 : public Mode {
   uint8_t startDiscovery();
   uint8_t StartDiscovery(uint8_t modeSE);  // Deprecated, use startDiscovery() instead
   bool stopDiscovery();
+  bool setDiscoveryProfile(NciDiscoveryProfile_t profile);
+  NciDiscoveryProfile_t getDiscoveryProfile() const;
+  bool setDiscoveryLoop(const NciDiscoveryLoop *loop);
+  bool setLowPowerCardDetection(bool enable, uint8_t threshold = NCI_LPCD_DEFAULT_THRESHOLD, uint8_t fallback = NCI_LPCD_DEFAULT_FALLBACK);
+  bool isLowPowerCardDetectionEnabled() const;
+  uint8_t getLowPowerCardDetectionThreshold() const;
+  uint8_t calibrateLowPowerCardDetection(uint8_t samples = NCI_LPCD_CALIBRATION_SAMPLES);
   bool StopDiscovery();                                                     // Deprecated, use stopDiscovery() instead
   bool WaitForDiscoveryNotification(RfIntf_t *pRfIntf, uint16_t tout = 0);  // Deprecated, use isTagDetected() instead
   bool isTagDetected(uint16_t tout = 500);
-  bool cardModeSend(unsigned char *pData, unsigned char DataSize);
+  uint8_t inventoryTags(uint16_t tout = 500);
+  const NciInventory *getInventory() const;
+  bool selectTag(uint8_t discoveryId);
+  bool cardModeSend(unsigned char *pData, unsigned short DataSize);
   bool CardModeSend(unsigned char *pData, unsigned char DataSize);  // Deprecated, use cardModeSend() instead
   bool cardModeReceive(unsigned char *pData, unsigned char *pDataSize);
+  bool cardModeReceive(unsigned char *pData, unsigned short DataBufferSize, unsigned short *pDataSize);
   bool CardModeReceive(unsigned char *pData, unsigned char *pDataSize);  // Deprecated, use cardModeReceive() instead
   void handleCardEmulation();
   void ProcessCardMode(RfIntf_t RfIntf);                              // Deprecated, use handleCardEmulation() instead
@@ -156,7 +319,11 @@ class Electroniccats_PN7150 : public Mode {
   void presenceCheck(RfIntf_t RfIntf);                                // Deprecated, use waitForTagRemoval() instead
   void PresenceCheck(RfIntf_t RfIntf);                                // Deprecated, use waitForTagRemoval() instead
   void waitForTagRemoval();
+  bool startPresenceMonitor(NciPresenceCallback_t *callback, void *context = NULL, uint16_t interval = NCI_PRESENCE_INTERVAL);
+  void stopPresenceMonitor();
+  NciPresenceState_t getPresenceState() const;
   bool readerTagCmd(unsigned char *pCommand, unsigned char CommandSize, unsigned char *pAnswer, unsigned char *pAnswerSize);
+  bool readerTagCmd(unsigned char *pCommand, unsigned short CommandSize, unsigned char *pAnswer, unsigned short AnswerBufferSize, unsigned short *pAnswerSize);
   bool ReaderTagCmd(unsigned char *pCommand, unsigned char CommandSize, unsigned char *pAnswer, unsigned char *pAnswerSize);  // Deprecated, use readerTagCmd() instead
   bool readerReActivate();
   bool ReaderReActivate(RfIntf_t *pRfIntf);          // Deprecated, use readerReActivate() instead
@@ -0,0 +1,313 @@
+/**
+ * NCI transport over Linux i2c-dev and the GPIO character device
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#if defined(__linux__)
+
+#include "LinuxTransport.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <linux/i2c-dev.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MsgHeaderSize 3
+#define IrqThreadPollPeriod 100  // ms, how often the IRQ thread checks if it has to stop
+#define IdleMaxPeriod 10         // ms, bounds the wait if the wake up came before idle() started
+
+LinuxTransport::LinuxTransport(const char *i2cDevice, uint8_t I2Caddress, const char *gpioChip, uint32_t irqLine,
+                               uint32_t venLine, bool useIrqThread) : _i2cDevice(i2cDevice), _gpioChip(gpioChip), _irqLine(irqLine), _venLine(venLine), _I2Caddress(I2Caddress) {
+  this->_i2cFd = -1;
+  this->_irqFd = -1;
+  this->_venFd = -1;
+  this->_useIrqThread = useIrqThread;
+  this->_irqHandler = NULL;
+  this->_irqContext = NULL;
+  this->_irqThreadRunning = false;
+  this->_resumed = false;
+  pthread_mutex_init(&_busMutex, NULL);
+  pthread_mutex_init(&_idleMutex, NULL);
+  pthread_cond_init(&_idleCond, NULL);
+  pthread_cond_init(&_resumeCond, NULL);
+  pthread_mutex_init(&_stateMutex, NULL);
+}
+
+LinuxTransport::~LinuxTransport() {
+  end();
+  pthread_mutex_destroy(&_stateMutex);
+  pthread_cond_destroy(&_resumeCond);
+  pthread_cond_destroy(&_idleCond);
+  pthread_mutex_destroy(&_idleMutex);
+  pthread_mutex_destroy(&_busMutex);
+}
+
+bool LinuxTransport::begin() {
+  int chipFd;
+
+  if (_i2cFd >= 0)
+    return true;
+
+  _i2cFd = open(_i2cDevice, O_RDWR);
+  if (_i2cFd < 0)
+    return false;
+  if (ioctl(_i2cFd, I2C_SLAVE, _I2Caddress) < 0) {
+    end();
+    return false;
+  }
+
+  chipFd = open(_gpioChip, O_RDWR);
+  if (chipFd < 0) {
+    end();
+    return false;
+  }
+
+  struct gpioevent_request irqRequest;
+  memset(&irqRequest, 0, sizeof(irqRequest));
+  irqRequest.lineoffset = _irqLine;
+  irqRequest.handleflags = GPIOHANDLE_REQUEST_INPUT;
+  irqRequest.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+  strncpy(irqRequest.consumer_label, "pn7150-irq", sizeof(irqRequest.consumer_label) - 1);
+  if (ioctl(chipFd, GPIO_GET_LINEEVENT_IOCTL, &irqRequest) == 0)
+    _irqFd = irqRequest.fd;
+
+  if (_venLine != NO_LINUX_GPIO_LINE) {
+    struct gpiohandle_request venRequest;
+    memset(&venRequest, 0, sizeof(venRequest));
+    venRequest.lineoffsets[0] = _venLine;
+    venRequest.lines = 1;
+    venRequest.flags = GPIOHANDLE_REQUEST_OUTPUT;
+    venRequest.default_values[0] = 1;
+    strncpy(venRequest.consumer_label, "pn7150-ven", sizeof(venRequest.consumer_label) - 1);
+    if (ioctl(chipFd, GPIO_GET_LINEHANDLE_IOCTL, &venRequest) == 0)
+      _venFd = venRequest.fd;
+  }
+  close(chipFd);
+
+  if ((_irqFd < 0) || ((_venLine != NO_LINUX_GPIO_LINE) && (_venFd < 0))) {
+    end();
+    return false;
+  }
+  return true;
+}
+
+void LinuxTransport::end() {
+  detachIrqHandler();
+  if (_venFd >= 0)
+    close(_venFd);
+  if (_irqFd >= 0)
+    close(_irqFd);
+  if (_i2cFd >= 0)
+    close(_i2cFd);
+  _venFd = -1;
+  _irqFd = -1;
+  _i2cFd = -1;
+}
+
+uint8_t LinuxTransport::writeFrame(const uint8_t *frame, uint16_t length) {
+  ssize_t written;
+
+  if (_i2cFd < 0)
+    return 4;
+
+  pthread_mutex_lock(&_busMutex);
+  written = write(_i2cFd, frame, length);
+  pthread_mutex_unlock(&_busMutex);
+
+  if (written < 0)
+    return (errno == ENXIO) ? 2 : 4;  // address NACK, other error (same codes as Wire::endTransmission())
+  return (written == length) ? 0 : 4;
+}
+
+bool LinuxTransport::readBytes(uint8_t *buffer, uint16_t length) {
+  return read(_i2cFd, buffer, length) == (ssize_t)length;
+}
+
+uint16_t LinuxTransport::readFrame(uint8_t *frame) {
+  uint16_t bytesReceived = 0;
+
+  if ((_i2cFd < 0) || !isIrqActive())
+    return 0;
+
+  /* Header and payload must not be split by a write from the other thread */
+  pthread_mutex_lock(&_busMutex);
+  if (readBytes(frame, MsgHeaderSize)) {
+    bytesReceived = MsgHeaderSize;
+    if ((frame[2] > 0) && readBytes(&frame[MsgHeaderSize], frame[2]))
+      bytesReceived += frame[2];
+  }
+  pthread_mutex_unlock(&_busMutex);
+  return bytesReceived;
+}
+
+bool LinuxTransport::isIrqActive() {
+  struct gpiohandle_data data;
+
+  if (_irqFd < 0)
+    return false;
+
+  memset(&data, 0, sizeof(data));
+  if (ioctl(_irqFd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) < 0)
+    return false;
+  return data.values[0] != 0;
+}
+
+/// @brief Sleep until the next IRQ rising edge, timeout in ms (-1 waits forever)
+bool LinuxTransport::consumeIrqEvent(int timeout) {
+  struct pollfd pfd;
+  struct gpioevent_data event;
+
+  pfd.fd = _irqFd;
+  pfd.events = POLLIN | POLLPRI;
+  pfd.revents = 0;
+  if (poll(&pfd, 1, timeout) <= 0)
+    return false;
+  return read(_irqFd, &event, sizeof(event)) == (ssize_t)sizeof(event);
+}
+
+bool LinuxTransport::waitForIrq(unsigned long timeout) {
+  if (isIrqActive())
+    return true;
+  if (_irqThreadRunning) {  // the thread owns the edge events
+    idle(timeout);
+    return isIrqActive();
+  }
+
+  consumeIrqEvent((timeout > 0x7FFFFFFF) ? -1 : (int)timeout);
+  return isIrqActive();
+}
+
+bool LinuxTransport::hasVen() const {
+  return _venLine != NO_LINUX_GPIO_LINE;
+}
+
+void LinuxTransport::setVen(bool level) {
+  struct gpiohandle_data data;
+
+  if (_venFd < 0)
+    return;
+
+  memset(&data, 0, sizeof(data));
+  data.values[0] = level ? 1 : 0;
+  ioctl(_venFd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+}
+
+/// @brief Without the IRQ thread there is no interrupt context on Linux, so the driver keeps polling
+bool LinuxTransport::attachIrqHandler(NciTransportIrqHandler_t *handler, void *context) {
+  if (!_useIrqThread || (_irqFd < 0))
+    return false;
+  if (_irqThreadRunning)
+    detachIrqHandler();
+
+  this->_irqHandler = handler;
+  this->_irqContext = context;
+  this->_irqThreadRunning = true;
+  if (pthread_create(&_irqThread, NULL, LinuxTransport::irqThreadEntry, this) != 0) {
+    this->_irqThreadRunning = false;
+    this->_irqHandler = NULL;
+    return false;
+  }
+  return true;
+}
+
+void LinuxTransport::detachIrqHandler() {
+  if (!_irqThreadRunning)
+    return;
+
+  this->_irqThreadRunning = false;
+  pthread_join(_irqThread, NULL);
+  this->_irqHandler = NULL;
+  this->_irqContext = NULL;
+}
+
+bool LinuxTransport::isIrqHandlerThreaded() const {
+  return true;
+}
+
+void *LinuxTransport::irqThreadEntry(void *arg) {
+  ((LinuxTransport *)arg)->irqThreadLoop();
+  return NULL;
+}
+
+void LinuxTransport::irqThreadLoop() {
+  struct timespec deadline;
+
+  while (_irqThreadRunning) {
+    /* A frame may be pending before its edge was seen, so check the level as well */
+    if (consumeIrqEvent(IrqThreadPollPeriod) || isIrqActive()) {
+      pthread_mutex_lock(&_idleMutex);
+      this->_resumed = false;
+      pthread_mutex_unlock(&_idleMutex);
+
+      _irqHandler(_irqContext);
+
+      pthread_mutex_lock(&_idleMutex);
+      pthread_cond_broadcast(&_idleCond);
+      /* IRQ still high, the handler had no room for the frame: wait until the driver takes one */
+      if (isIrqActive() && !this->_resumed) {
+        deadlineIn(&deadline, IrqThreadPollPeriod);
+        pthread_cond_timedwait(&_resumeCond, &_idleMutex, &deadline);
+      }
+      pthread_mutex_unlock(&_idleMutex);
+    }
+  }
+}
+
+void LinuxTransport::idle(unsigned long timeout) {
+  struct timespec deadline;
+
+  if (!_irqThreadRunning) {
+    if (timeout > 0)
+      usleep(1000);
+    return;
+  }
+
+  if (timeout > IdleMaxPeriod)
+    timeout = IdleMaxPeriod;
+  deadlineIn(&deadline, timeout);
+
+  pthread_mutex_lock(&_idleMutex);
+  pthread_cond_timedwait(&_idleCond, &_idleMutex, &deadline);
+  pthread_mutex_unlock(&_idleMutex);
+}
+
+void LinuxTransport::resumeIrqHandler() {
+  pthread_mutex_lock(&_idleMutex);
+  this->_resumed = true;
+  pthread_cond_signal(&_resumeCond);
+  pthread_mutex_unlock(&_idleMutex);
+}
+
+void LinuxTransport::lock() {
+  pthread_mutex_lock(&_stateMutex);
+}
+
+void LinuxTransport::unlock() {
+  pthread_mutex_unlock(&_stateMutex);
+}
+
+/// @brief Absolute time timeout ms from now, for pthread_cond_timedwait()
+void LinuxTransport::deadlineIn(struct timespec *deadline, unsigned long timeout) {
+  clock_gettime(CLOCK_REALTIME, deadline);
+  deadline->tv_sec += timeout / 1000;
+  deadline->tv_nsec += (long)(timeout % 1000) * 1000000L;
+  if (deadline->tv_nsec >= 1000000000L) {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000L;
+  }
+}
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * NCI transport over Linux i2c-dev and the GPIO character device
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef LinuxTransport_H
+#define LinuxTransport_H
+
+#if defined(__linux__)
+
+#include <pthread.h>
+
+#include "NciTransport.h"
+
+#define NO_LINUX_GPIO_LINE 0xFFFFFFFF
+
+/*
+ * Talks to the PN7150 from a Linux host (Raspberry Pi, BeagleBone...) through
+ * /dev/i2c-N and /dev/gpiochipN. IRQ edges are read from the kernel so waiting
+ * for a frame sleeps in poll() instead of spinning on the bus.
+ */
+class LinuxTransport : public NciTransport {
+ private:
+  const char *_i2cDevice;
+  const char *_gpioChip;
+  uint32_t _irqLine, _venLine;
+  uint8_t _I2Caddress;
+  int _i2cFd, _irqFd, _venFd;
+  bool _useIrqThread;
+  NciTransportIrqHandler_t *_irqHandler;
+  void *_irqContext;
+  pthread_t _irqThread;
+  volatile bool _irqThreadRunning;
+  pthread_mutex_t _busMutex;
+  pthread_mutex_t _idleMutex;
+  pthread_cond_t _idleCond;
+  pthread_cond_t _resumeCond;
+  bool _resumed;  // the driver took a frame since the handler last ran
+  pthread_mutex_t _stateMutex;
+  static void *irqThreadEntry(void *arg);
+  void irqThreadLoop();
+  bool consumeIrqEvent(int timeout);
+  static void deadlineIn(struct timespec *deadline, unsigned long timeout);
+  bool readBytes(uint8_t *buffer, uint16_t length);
+
+ public:
+  LinuxTransport(const char *i2cDevice, uint8_t I2Caddress, const char *gpioChip, uint32_t irqLine,
+                 uint32_t venLine = NO_LINUX_GPIO_LINE, bool useIrqThread = true);
+  ~LinuxTransport();
+  bool begin();
+  void end();
+  uint8_t writeFrame(const uint8_t *frame, uint16_t length);
+  uint16_t readFrame(uint8_t *frame);
+  bool isIrqActive();
+  bool waitForIrq(unsigned long timeout);
+  bool hasVen() const;
+  void setVen(bool level);
+  bool attachIrqHandler(NciTransportIrqHandler_t *handler, void *context);
+  void detachIrqHandler();
+  bool isIrqHandlerThreaded() const;
+  void idle(unsigned long timeout);
+  void resumeIrqHandler();
+  void lock();
+  void unlock();
+};
+
+#endif
+
+#endif
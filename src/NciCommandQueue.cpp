@@ -0,0 +1,142 @@
+/**
+ * Library to run NCI commands without blocking the caller
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciCommandQueue.h"
+
+#include <string.h>
+
+#define MT_MASK 0xE0
+#define MT_DATA 0x00
+#define MT_CMD 0x20
+#define MT_RSP 0x40
+#define GID_MASK 0x0F  // connection identifier for data packets
+#define OID_MASK 0x3F
+
+NciCommandQueue::NciCommandQueue() {
+  this->head = 0;
+  this->count = 0;
+  this->waiting = false;
+  this->sentAt = 0;
+}
+
+bool NciCommandQueue::push(const uint8_t *frame, uint16_t length, uint16_t timeout, NciCommandCallback_t *callback, void *context) {
+  Entry *entry;
+
+  if ((count == NCI_COMMAND_QUEUE_SIZE) || (length < 3))
+    return false;
+
+  entry = &entries[(head + count) % NCI_COMMAND_QUEUE_SIZE];
+  entry->frame = frame;
+  entry->length = length;
+  entry->timeout = timeout;
+  entry->callback = callback;
+  entry->context = context;
+  count++;
+  return true;
+}
+
+bool NciCommandQueue::push(const uint8_t *frame, uint16_t length, uint16_t timeout, NciCommandFuture *future) {
+  future->status = NCI_COMMAND_PENDING;
+  future->length = 0;
+  if (!push(frame, length, timeout, NciCommandQueue::completeFuture, future)) {
+    future->status = NCI_COMMAND_CANCELLED;
+    return false;
+  }
+  return true;
+}
+
+void NciCommandQueue::completeFuture(NciCommandStatus_t status, const uint8_t *response, uint16_t length, void *context) {
+  NciCommandFuture *future = (NciCommandFuture *)context;
+
+  if ((future->response != NULL) && (response != NULL)) {
+    future->length = (length < future->responseSize) ? length : future->responseSize;
+    memcpy(future->response, response, future->length);
+  }
+  future->status = status;
+}
+
+uint8_t NciCommandQueue::getCount() const {
+  return count;
+}
+
+bool NciCommandQueue::isWaiting() const {
+  return waiting;
+}
+
+const uint8_t *NciCommandQueue::next(uint16_t *length) {
+  if (waiting || (count == 0))
+    return NULL;
+
+  *length = entries[head].length;
+  return entries[head].frame;
+}
+
+void NciCommandQueue::sent(unsigned long now) {
+  this->waiting = true;
+  this->sentAt = now;
+}
+
+/// @brief A command is answered by the response with the same GID and OID, a data packet by a data packet on
+/// the same connection or by CORE_INTERFACE_ERROR_NTF
+bool NciCommandQueue::answer(const uint8_t *frame, uint16_t length) {
+  const uint8_t *command;
+
+  if (!waiting)
+    return false;
+  command = entries[head].frame;
+
+  if ((command[0] & MT_MASK) == MT_CMD) {
+    if (((frame[0] & MT_MASK) != MT_RSP) || ((frame[0] & GID_MASK) != (command[0] & GID_MASK)) || ((frame[1] & OID_MASK) != (command[1] & OID_MASK)))
+      return false;
+  } else if ((command[0] & MT_MASK) == MT_DATA) {
+    if (((frame[0] & MT_MASK) == MT_DATA) && ((frame[0] & GID_MASK) != (command[0] & GID_MASK)))
+      return false;
+    if (((frame[0] & MT_MASK) != MT_DATA) && ((frame[0] != 0x60) || (frame[1] != 0x08)))
+      return false;
+  } else {
+    return false;
+  }
+
+  complete(NCI_COMMAND_COMPLETED, frame, length);
+  return true;
+}
+
+bool NciCommandQueue::expire(unsigned long now) {
+  if (!waiting || ((now - sentAt) < entries[head].timeout))
+    return false;
+
+  complete(NCI_COMMAND_TIMEOUT, NULL, 0);
+  return true;
+}
+
+void NciCommandQueue::finish(NciCommandStatus_t status) {
+  if (count > 0)
+    complete(status, NULL, 0);
+}
+
+/// @brief Drop every command, their callbacks are called with NCI_COMMAND_CANCELLED
+void NciCommandQueue::cancel() {
+  while (count > 0)
+    complete(NCI_COMMAND_CANCELLED, NULL, 0);
+}
+
+/// @brief Remove the first command before calling its callback, so the callback can queue the next one
+void NciCommandQueue::complete(NciCommandStatus_t status, const uint8_t *response, uint16_t length) {
+  Entry entry = entries[head];
+
+  head = (head + 1) % NCI_COMMAND_QUEUE_SIZE;
+  count--;
+  waiting = false;
+  if (entry.callback != NULL)
+    entry.callback(status, response, length, entry.context);
+}
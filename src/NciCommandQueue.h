@@ -0,0 +1,86 @@
+/**
+ * Library to run NCI commands without blocking the caller
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciCommandQueue_H
+#define NciCommandQueue_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Number of commands that can be waiting to be sent, the one waiting for its response included
+ */
+#ifndef NCI_COMMAND_QUEUE_SIZE
+#define NCI_COMMAND_QUEUE_SIZE 4
+#endif
+
+typedef enum {
+  NCI_COMMAND_PENDING,
+  NCI_COMMAND_COMPLETED,  // response received, its status is in the response
+  NCI_COMMAND_TIMEOUT,
+  NCI_COMMAND_BUS_ERROR,  // the frame could not be written
+  NCI_COMMAND_CANCELLED
+} NciCommandStatus_t;
+
+// response is NULL and length 0 unless status is NCI_COMMAND_COMPLETED
+typedef void NciCommandCallback_t(NciCommandStatus_t status, const uint8_t *response, uint16_t length, void *context);
+// Notifications and data packets that do not answer a queued command
+typedef void NciFrameCallback_t(const uint8_t *frame, uint16_t length, void *context);
+
+/*
+ * Filled when the command completes, poll status from loop()
+ */
+typedef struct {
+  volatile NciCommandStatus_t status;
+  uint8_t *response;      // buffer given by the application, can be NULL
+  uint16_t responseSize;  // size of the buffer, longer responses are truncated
+  uint16_t length;        // length of the response copied
+} NciCommandFuture;
+
+/*
+ * FIFO of commands for Electroniccats_PN7150::poll(). NCI allows a single command
+ * waiting for its response, the next one is sent once it is answered or timed out.
+ * Frames are not copied, they must stay valid until their command completes.
+ */
+class NciCommandQueue {
+ private:
+  struct Entry {
+    const uint8_t *frame;
+    uint16_t length;
+    uint16_t timeout;  // ms
+    NciCommandCallback_t *callback;
+    void *context;
+  };
+  Entry entries[NCI_COMMAND_QUEUE_SIZE];
+  uint8_t head;
+  uint8_t count;
+  bool waiting;
+  unsigned long sentAt;
+  void complete(NciCommandStatus_t status, const uint8_t *response, uint16_t length);
+  static void completeFuture(NciCommandStatus_t status, const uint8_t *response, uint16_t length, void *context);
+
+ public:
+  NciCommandQueue();
+  bool push(const uint8_t *frame, uint16_t length, uint16_t timeout, NciCommandCallback_t *callback, void *context);
+  bool push(const uint8_t *frame, uint16_t length, uint16_t timeout, NciCommandFuture *future);
+  uint8_t getCount() const;
+  bool isWaiting() const;                              // the first command was sent and waits for its response
+  const uint8_t *next(uint16_t *length);               // first command if not sent yet, NULL otherwise
+  void sent(unsigned long now);                        // next() was written, start its timeout
+  bool answer(const uint8_t *frame, uint16_t length);  // true if the frame completed the command sent
+  bool expire(unsigned long now);                      // true if the command sent timed out
+  void finish(NciCommandStatus_t status);              // complete the first command without response
+  void cancel();
+};
+
+#endif
@@ -0,0 +1,149 @@
+/**
+ * Library to pack the configuration parameters of the PN7150 into few CORE_SET_CONFIG commands
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciConfigBuilder.h"
+
+#include <string.h>
+
+#define STATUS_OK 0x00
+#define STATUS_INVALID_PARAM 0x09
+
+NciConfigBuilder::NciConfigBuilder() {
+  clear();
+}
+
+uint8_t NciConfigBuilder::idLength(const uint8_t *tlv) {
+  return ((tlv[0] & 0xF0) == 0xA0) ? 2 : 1;  // NXP proprietary parameters have a 2 bytes ID
+}
+
+uint16_t NciConfigBuilder::tlvLength(const uint8_t *tlv) {
+  uint8_t id = idLength(tlv);
+  return id + 1 + tlv[id];
+}
+
+bool NciConfigBuilder::add(const uint8_t *tlv) {
+  if ((count == NCI_CONFIG_BUILDER_ENTRIES) || (1 + tlvLength(tlv) > NCI_CONFIG_MAX_PAYLOAD)) {
+    valid = false;
+    return false;
+  }
+
+  entries[count].tlv = tlv;
+  entries[count].status = NCI_CONFIG_PENDING;
+  entries[count].split = splitNext;
+  splitNext = false;
+  count++;
+  return true;
+}
+
+bool NciConfigBuilder::addFrame(const uint8_t *frame, uint16_t length) {
+  uint16_t pos = 4;
+
+  if ((length < 4) || (frame[0] != 0x20) || (frame[1] != 0x02) || (frame[2] + 3 != length)) {
+    valid = false;
+    return false;
+  }
+
+  for (uint8_t i = 0; i < frame[3]; i++) {
+    if ((pos + 2 > length) || (pos + tlvLength(&frame[pos]) > length)) {
+      valid = false;
+      return false;
+    }
+    if (!add(&frame[pos]))
+      return false;
+    pos += tlvLength(&frame[pos]);
+  }
+  return true;
+}
+
+/// @brief Parameters added after this call are sent in a new command
+void NciConfigBuilder::split() {
+  splitNext = true;
+}
+
+void NciConfigBuilder::clear() {
+  this->count = 0;
+  this->splitNext = false;
+  this->valid = true;
+}
+
+bool NciConfigBuilder::isValid() const {
+  return valid;
+}
+
+uint8_t NciConfigBuilder::getCount() const {
+  return count;
+}
+
+NciConfigStatus_t NciConfigBuilder::getStatus(uint8_t index) const {
+  return (index < count) ? entries[index].status : NCI_CONFIG_FAILED;
+}
+
+/// @brief Pack as many parameters from first as fit in one CORE_SET_CONFIG_CMD
+/// @param frame at least NCI_CONFIG_MAX_PAYLOAD + 3 bytes
+/// @param next first parameter of the following command
+/// @return length of the command, 0 if no parameter is left
+uint16_t NciConfigBuilder::buildFrame(uint8_t first, uint8_t *frame, uint8_t *next) const {
+  uint16_t length = 4;
+  uint8_t i = first;
+
+  while (i < count) {
+    uint16_t tlv = tlvLength(entries[i].tlv);
+    if ((i != first) && (entries[i].split || (length - 3 + tlv > NCI_CONFIG_MAX_PAYLOAD)))
+      break;
+    memcpy(&frame[length], entries[i].tlv, tlv);
+    length += tlv;
+    i++;
+  }
+  *next = i;
+  if (i == first)
+    return 0;
+
+  frame[0] = 0x20;
+  frame[1] = 0x02;
+  frame[2] = length - 3;
+  frame[3] = i - first;
+  return length;
+}
+
+/// @brief Update the parameters sent in one command from its response, NULL if none was received
+/// @return true if all of them were applied
+bool NciConfigBuilder::setStatus(uint8_t first, uint8_t next, const uint8_t *response, uint16_t length) {
+  bool applied = true;
+
+  if ((response == NULL) || (length < 4) || (response[0] != 0x40) || (response[1] != 0x02) ||
+      ((response[3] != STATUS_OK) && (response[3] != STATUS_INVALID_PARAM))) {
+    for (uint8_t i = first; i < next; i++)
+      entries[i].status = NCI_CONFIG_FAILED;
+    return false;
+  }
+
+  for (uint8_t i = first; i < next; i++)
+    entries[i].status = NCI_CONFIG_APPLIED;
+
+  /* The response lists the IDs of the invalid parameters, all the others were applied */
+  uint16_t pos = 5;
+  for (uint8_t n = 0; (length > 4) && (n < response[4]); n++) {
+    applied = false;
+    if (pos >= length)
+      break;
+    uint8_t id = idLength(&response[pos]);
+    if (pos + id > length)
+      break;  // truncated, 0xA0 IDs take 2 bytes
+    for (uint8_t i = first; i < next; i++) {
+      if (!memcmp(entries[i].tlv, &response[pos], id) && (idLength(entries[i].tlv) == id))
+        entries[i].status = NCI_CONFIG_INVALID;
+    }
+    pos += id;
+  }
+  return applied && (response[3] == STATUS_OK);
+}
@@ -0,0 +1,70 @@
+/**
+ * Library to pack the configuration parameters of the PN7150 into few CORE_SET_CONFIG commands
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciConfigBuilder_H
+#define NciConfigBuilder_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Number of parameters that can be gathered, the settings of configureSettings() use 25 of them
+ */
+#ifndef NCI_CONFIG_BUILDER_ENTRIES
+#define NCI_CONFIG_BUILDER_ENTRIES 32
+#endif
+
+#define NCI_CONFIG_MAX_PAYLOAD 255  // payload of one CORE_SET_CONFIG_CMD, parameter count included
+
+typedef enum {
+  NCI_CONFIG_PENDING,  // not sent yet
+  NCI_CONFIG_APPLIED,
+  NCI_CONFIG_INVALID,  // listed as invalid in the response
+  NCI_CONFIG_FAILED    // whole command rejected or not answered
+} NciConfigStatus_t;
+
+/*
+ * Gathers parameter TLVs (ID on 1 byte, or 2 bytes for the NXP proprietary 0xA0xx ones,
+ * length, value) and packs them in as few CORE_SET_CONFIG_CMD as possible. Parameters
+ * are sent in the order they were added, split() starts a new command for the ones
+ * which must only be sent once the previous ones were applied.
+ * TLVs are not copied, they must stay valid until the configuration is applied.
+ */
+class NciConfigBuilder {
+ private:
+  struct Entry {
+    const uint8_t *tlv;
+    NciConfigStatus_t status;
+    bool split;  // first parameter of a new command
+  };
+  Entry entries[NCI_CONFIG_BUILDER_ENTRIES];
+  uint8_t count;
+  bool splitNext;
+  bool valid;
+  static uint8_t idLength(const uint8_t *tlv);
+  static uint16_t tlvLength(const uint8_t *tlv);
+
+ public:
+  NciConfigBuilder();
+  bool add(const uint8_t *tlv);
+  bool addFrame(const uint8_t *frame, uint16_t length);  // every parameter of a CORE_SET_CONFIG_CMD
+  void split();
+  void clear();
+  bool isValid() const;  // false once a parameter could not be added
+  uint8_t getCount() const;
+  NciConfigStatus_t getStatus(uint8_t index) const;
+  uint16_t buildFrame(uint8_t first, uint8_t *frame, uint8_t *next) const;  // command for the parameters from first, 0 if none left
+  bool setStatus(uint8_t first, uint8_t next, const uint8_t *response, uint16_t length);
+};
+
+#endif
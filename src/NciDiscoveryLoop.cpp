@@ -0,0 +1,69 @@
+/**
+ * Library to choose the technologies of the PN7150 discovery loop at runtime
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciDiscoveryLoop.h"
+
+#include "ModeTech.h"
+
+NciDiscoveryLoop::NciDiscoveryLoop() {
+  clear();
+}
+
+/// @param frequency 1 to poll at every loop, N at every N loops, up to NCI_DISCOVERY_MAX_FREQUENCY
+/// @return false if the loop is full, the technology is already in it or the frequency is not valid
+bool NciDiscoveryLoop::add(uint8_t modeTech, uint8_t frequency) {
+  if ((getCount() == NCI_DISCOVERY_MAX_TECHS) || (frequency == 0) || (frequency > NCI_DISCOVERY_MAX_FREQUENCY))
+    return false;
+  if (((modeTech & MODE_MASK) == MODE_LISTEN) && (frequency != 1))
+    return false;
+
+  for (uint8_t i = 0; i < getCount(); i++) {
+    if (frame[4 + 2 * i] == modeTech)
+      return false;
+  }
+
+  frame[4 + 2 * frame[3]] = modeTech;
+  frame[5 + 2 * frame[3]] = frequency;
+  frame[3]++;
+  frame[2] += 2;
+  return true;
+}
+
+/// @brief Remove every technology, the total duration is set back to its default
+void NciDiscoveryLoop::clear() {
+  frame[0] = 0x21;  // RF_DISCOVER_CMD
+  frame[1] = 0x03;
+  frame[2] = 1;
+  frame[3] = 0;
+  this->totalDuration = NCI_DISCOVERY_DEFAULT_DURATION;
+}
+
+void NciDiscoveryLoop::setTotalDuration(uint16_t ms) {
+  this->totalDuration = ms;
+}
+
+uint16_t NciDiscoveryLoop::getTotalDuration() const {
+  return totalDuration;
+}
+
+uint8_t NciDiscoveryLoop::getCount() const {
+  return frame[3];
+}
+
+const uint8_t *NciDiscoveryLoop::getFrame() const {
+  return frame;
+}
+
+uint16_t NciDiscoveryLoop::getFrameLength() const {
+  return 3 + frame[2];
+}
@@ -0,0 +1,60 @@
+/**
+ * Library to choose the technologies of the PN7150 discovery loop at runtime
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciDiscoveryLoop_H
+#define NciDiscoveryLoop_H
+
+#include <stdint.h>
+
+/*
+ * Number of technologies of one loop, the PN7150 supports 4 polled and 4 listened ones
+ */
+#ifndef NCI_DISCOVERY_MAX_TECHS
+#define NCI_DISCOVERY_MAX_TECHS 8
+#endif
+
+#define NCI_DISCOVERY_DEFAULT_DURATION 256  // ms, TOTAL_DURATION of configureSettings()
+#define NCI_DISCOVERY_FAST_DURATION 20
+#define NCI_DISCOVERY_LOW_POWER_DURATION 1000
+#define NCI_DISCOVERY_LOW_POWER_FREQUENCY 4  // polling every 4 loops
+#define NCI_DISCOVERY_MAX_FREQUENCY 10
+
+typedef enum {
+  NCI_DISCOVERY_DEFAULT,    // technologies of the mode, every loop
+  NCI_DISCOVERY_FAST_NFCA,  // ISO14443A only, short loop
+  NCI_DISCOVERY_LOW_POWER,  // technologies of the mode, only NFC-A and listening at every loop, long loop
+  NCI_DISCOVERY_CUSTOM      // set with setDiscoveryLoop()
+} NciDiscoveryProfile_t;
+
+/*
+ * RF_DISCOVER_CMD and TOTAL_DURATION of a discovery loop. Each technology is a MODE_xxx | TECH_xxx
+ * value and its frequency, 1 to poll at every loop, N at every N loops. Listened technologies
+ * are always at every loop.
+ */
+class NciDiscoveryLoop {
+ private:
+  uint8_t frame[4 + 2 * NCI_DISCOVERY_MAX_TECHS];
+  uint16_t totalDuration;
+
+ public:
+  NciDiscoveryLoop();
+  bool add(uint8_t modeTech, uint8_t frequency = 1);
+  void clear();
+  void setTotalDuration(uint16_t ms);  // time of one loop, the remaining time after polling is spent listening or idle
+  uint16_t getTotalDuration() const;
+  uint8_t getCount() const;
+  const uint8_t *getFrame() const;
+  uint16_t getFrameLength() const;
+};
+
+#endif
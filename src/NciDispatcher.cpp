@@ -0,0 +1,95 @@
+/**
+ * Library to route the NCI frames received from the PN7150 to their handlers
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciDispatcher.h"
+
+#define MT_MASK 0xE0
+#define MT_DATA 0x00
+#define MT_RSP 0x40
+#define MT_NTF 0x60
+#define GID_MASK 0x0F
+#define OID_MASK 0x3F
+#define GID_CORE 0x00
+#define GID_RF 0x01
+
+NciDispatcher::NciDispatcher() {
+  this->count = 0;
+}
+
+/// @brief Call handler for every frame of the given kind, NCI_FRAME_ANY for all of them
+/// @return false if the table is full
+bool NciDispatcher::add(NciFrameKind_t kind, NciFrameHandler_t *handler, void *context) {
+  if ((count == NCI_DISPATCHER_HANDLERS) || (handler == NULL))
+    return false;
+
+  entries[count].kind = kind;
+  entries[count].handler = handler;
+  entries[count].context = context;
+  count++;
+  return true;
+}
+
+bool NciDispatcher::remove(NciFrameKind_t kind, NciFrameHandler_t *handler) {
+  for (uint8_t i = 0; i < count; i++) {
+    if ((entries[i].kind == kind) && (entries[i].handler == handler)) {
+      for (; i < count - 1; i++)
+        entries[i] = entries[i + 1];
+      count--;
+      return true;
+    }
+  }
+  return false;
+}
+
+NciFrameKind_t NciDispatcher::dispatch(const uint8_t *frame, uint16_t length) {
+  NciFrameKind_t kind = decode(frame, length);
+
+  for (uint8_t i = 0; i < count; i++) {
+    if ((entries[i].kind == kind) || (entries[i].kind == NCI_FRAME_ANY))
+      entries[i].handler(kind, frame, length, entries[i].context);
+  }
+  return kind;
+}
+
+NciFrameKind_t NciDispatcher::decode(const uint8_t *frame, uint16_t length) {
+  if (length < 3)
+    return NCI_FRAME_NONE;
+
+  switch (frame[0] & MT_MASK) {
+    case MT_DATA:
+      return NCI_FRAME_DATA;
+    case MT_RSP:
+      return NCI_FRAME_RESPONSE;
+    case MT_NTF:
+      break;
+    default:
+      return NCI_FRAME_NONE;  // commands only go to the PN7150
+  }
+
+  switch (((frame[0] & GID_MASK) << 8) | (frame[1] & OID_MASK)) {
+    case (GID_RF << 8) | 0x03:
+      return NCI_FRAME_RF_DISCOVER;
+    case (GID_RF << 8) | 0x05:
+      return NCI_FRAME_RF_INTF_ACTIVATED;
+    case (GID_RF << 8) | 0x06:
+      return NCI_FRAME_RF_DEACTIVATE;
+    case (GID_CORE << 8) | 0x06:
+      return NCI_FRAME_CORE_CONN_CREDITS;
+    case (GID_CORE << 8) | 0x07:
+      return NCI_FRAME_CORE_GENERIC_ERROR;
+    case (GID_CORE << 8) | 0x08:
+      return NCI_FRAME_CORE_INTERFACE_ERROR;
+    default:
+      return NCI_FRAME_NOTIFICATION;
+  }
+}
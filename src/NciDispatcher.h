@@ -0,0 +1,65 @@
+/**
+ * Library to route the NCI frames received from the PN7150 to their handlers
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciDispatcher_H
+#define NciDispatcher_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Number of handlers that can be registered, the driver uses 9 of them
+ */
+#ifndef NCI_DISPATCHER_HANDLERS
+#define NCI_DISPATCHER_HANDLERS 12
+#endif
+
+typedef enum {
+  NCI_FRAME_NONE,                  // nothing received
+  NCI_FRAME_DATA,                  // data packet, PBF set or not
+  NCI_FRAME_RESPONSE,              // any response
+  NCI_FRAME_RF_DISCOVER,           // RF_DISCOVER_NTF
+  NCI_FRAME_RF_INTF_ACTIVATED,     // RF_INTF_ACTIVATED_NTF
+  NCI_FRAME_RF_DEACTIVATE,         // RF_DEACTIVATE_NTF
+  NCI_FRAME_CORE_CONN_CREDITS,     // CORE_CONN_CREDITS_NTF
+  NCI_FRAME_CORE_GENERIC_ERROR,    // CORE_GENERIC_ERROR_NTF
+  NCI_FRAME_CORE_INTERFACE_ERROR,  // CORE_INTERFACE_ERROR_NTF
+  NCI_FRAME_NOTIFICATION,          // any other notification
+  NCI_FRAME_ANY                    // only to register a handler called for every frame
+} NciFrameKind_t;
+
+typedef void NciFrameHandler_t(NciFrameKind_t kind, const uint8_t *frame, uint16_t length, void *context);
+
+/*
+ * Decodes the header of each frame once and calls the handlers registered for its
+ * kind, in the order they were added.
+ */
+class NciDispatcher {
+ private:
+  struct Entry {
+    NciFrameKind_t kind;
+    NciFrameHandler_t *handler;
+    void *context;
+  };
+  Entry entries[NCI_DISPATCHER_HANDLERS];
+  uint8_t count;
+
+ public:
+  NciDispatcher();
+  bool add(NciFrameKind_t kind, NciFrameHandler_t *handler, void *context = NULL);
+  bool remove(NciFrameKind_t kind, NciFrameHandler_t *handler);
+  NciFrameKind_t dispatch(const uint8_t *frame, uint16_t length);
+  static NciFrameKind_t decode(const uint8_t *frame, uint16_t length);
+};
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * Library to queue the tag events seen by the PN7150 driver until the application handles them
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciEventQueue.h"
+
+#include <string.h>
+
+#include "ModeTech.h"
+#include "Tech.h"
+
+NciEventQueue::NciEventQueue() {
+  memset(&activeTag, 0, sizeof(activeTag));
+  clear();
+}
+
+/// @brief Event about a tag found by the discovery, the UID is read from its RF technology specific parameters
+/// @return false if the queue is full
+bool NciEventQueue::addTag(NciEventType_t type, uint32_t timestamp, uint8_t id, uint8_t protocol, uint8_t modeTech, const uint8_t *params, uint8_t paramsLength) {
+  NciEvent event;
+
+  event.type = type;
+  event.timestamp = timestamp;
+  event.id = id;
+  event.protocol = protocol;
+  event.modeTech = modeTech;
+  event.uidLength = readUid(modeTech, params, paramsLength, event.uid);
+  event.length = 0;
+  if (type == NCI_EVENT_TAG_ACTIVATED)
+    activeTag = event;
+  return push(&event);
+}
+
+/// @return false if the queue is full
+bool NciEventQueue::add(NciEventType_t type, uint32_t timestamp, uint16_t length) {
+  NciEvent event = activeTag;
+
+  event.type = type;
+  event.timestamp = timestamp;
+  event.length = length;
+  return push(&event);
+}
+
+bool NciEventQueue::push(const NciEvent *event) {
+  if (count == NCI_EVENT_QUEUE_SIZE) {
+    dropped++;
+    return false;
+  }
+
+  events[(head + count) % NCI_EVENT_QUEUE_SIZE] = *event;
+  count++;
+  return true;
+}
+
+uint8_t NciEventQueue::getCount() const {
+  return count;
+}
+
+/// @return false if there is no event
+bool NciEventQueue::pop(NciEvent *event) {
+  if (count == 0)
+    return false;
+
+  *event = events[head];
+  head = (head + 1) % NCI_EVENT_QUEUE_SIZE;
+  count--;
+  return true;
+}
+
+uint8_t NciEventQueue::pop(NciEvent *batch, uint8_t size) {
+  uint8_t i = 0;
+
+  while ((i < size) && pop(&batch[i]))
+    i++;
+  return i;
+}
+
+/// @brief Events lost because the queue was full
+uint32_t NciEventQueue::getDropped() const {
+  return dropped;
+}
+
+void NciEventQueue::clear() {
+  head = 0;
+  count = 0;
+  dropped = 0;
+}
+
+/// @return length of the UID, 0 if the parameters do not hold one
+uint8_t NciEventQueue::readUid(uint8_t modeTech, const uint8_t *params, uint8_t length, uint8_t *uid) {
+  uint8_t i;
+
+  if ((modeTech & MODE_MASK) != MODE_POLL)
+    return 0;
+
+  switch (modeTech) {
+    case TECH_PASSIVE_NFCA:  // SENS_RES, NFCID1 length, NFCID1
+      if ((length < 3) || (params[2] > NCI_EVENT_UID_SIZE) || (length < 3 + params[2]))
+        return 0;
+      memcpy(uid, &params[3], params[2]);
+      return params[2];
+
+    case TECH_PASSIVE_NFCB:  // SENSB_RES length, SENSB_RES starting with NFCID0
+      if ((length < 5) || (params[0] < 4))
+        return 0;
+      memcpy(uid, &params[1], 4);
+      return 4;
+
+    case TECH_PASSIVE_NFCF:  // bit rate, SENSF_RES length, SENSF_RES starting with NFCID2
+      if ((length < 10) || (params[1] < 8))
+        return 0;
+      memcpy(uid, &params[2], 8);
+      return 8;
+
+    case TECH_PASSIVE_15693:  // flags, DSFID, UID LSB first
+      if (length < 10)
+        return 0;
+      for (i = 0; i < 8; i++) {
+        uid[7 - i] = params[2 + i];
+      }
+      return 8;
+
+    default:
+      return 0;
+  }
+}
@@ -0,0 +1,72 @@
+/**
+ * Library to queue the tag events seen by the PN7150 driver until the application handles them
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciEventQueue_H
+#define NciEventQueue_H
+
+#include <stdint.h>
+
+/*
+ * Number of events waiting for the application, further ones are dropped and counted
+ */
+#ifndef NCI_EVENT_QUEUE_SIZE
+#define NCI_EVENT_QUEUE_SIZE 8
+#endif
+
+#define NCI_EVENT_UID_SIZE 10
+
+typedef enum {
+  NCI_EVENT_TAG_ARRIVED,    // found by the discovery
+  NCI_EVENT_TAG_ACTIVATED,  // ready to exchange data
+  NCI_EVENT_NDEF_READ,      // readNdefMessage() completed, length is the one of the message
+  NCI_EVENT_TAG_DEPARTED    // removal seen by waitForTagRemoval() or the presence monitor
+} NciEventType_t;
+
+typedef struct {
+  NciEventType_t type;
+  uint32_t timestamp;  // micros() when the driver saw it
+  uint8_t id;          // RF discovery ID
+  uint8_t protocol;    // PROT_xxx
+  uint8_t modeTech;    // MODE_xxx | TECH_xxx
+  uint8_t uidLength;
+  uint8_t uid[NCI_EVENT_UID_SIZE];  // NFCID1, NFCID0, NFCID2 or ISO15693 UID (MSB first)
+  uint16_t length;
+} NciEvent;
+
+/*
+ * FIFO of events, filled by the driver from its frame handlers and drained by the
+ * application from loop(). The events that follow an activation are about the tag
+ * activated last.
+ */
+class NciEventQueue {
+ private:
+  NciEvent events[NCI_EVENT_QUEUE_SIZE];
+  NciEvent activeTag;  // last NCI_EVENT_TAG_ACTIVATED
+  uint8_t head;
+  uint8_t count;
+  uint32_t dropped;
+  bool push(const NciEvent *event);
+  static uint8_t readUid(uint8_t modeTech, const uint8_t *params, uint8_t length, uint8_t *uid);
+
+ public:
+  NciEventQueue();
+  bool addTag(NciEventType_t type, uint32_t timestamp, uint8_t id, uint8_t protocol, uint8_t modeTech, const uint8_t *params, uint8_t paramsLength);
+  bool add(NciEventType_t type, uint32_t timestamp, uint16_t length = 0);  // about the tag activated last
+  uint8_t getCount() const;
+  bool pop(NciEvent *event);
+  uint8_t pop(NciEvent *batch, uint8_t size);  // up to size events, returns how many
+  uint32_t getDropped() const;
+  void clear();
+};
+
+#endif
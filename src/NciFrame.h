@@ -0,0 +1,114 @@
+/**
+ * Library to build constant NCI frames at compile time
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciFrame_H
+#define NciFrame_H
+
+#include <stdint.h>
+
+/*
+ * Frames are types: the compiler computes their lengths and counts, checks they fit in
+ * a frame and emits their bytes as one constant array, nothing is assembled at runtime.
+ *
+ *   typedef NciSetConfig<NciParam<0x00, 0x00, 0x01>,         // TOTAL_DURATION
+ *                        NciParam<0xA040, 0x00> > Config;     // TAG_DETECTOR_CFG
+ *   nfc.writeData(Config::data, Config::length);
+ *
+ * The arrays are const, so they stay in flash on the targets that execute from it
+ * (ARM, ESP32, RP2040). On AVR they are copied to RAM at startup like any constant.
+ */
+
+template <uint8_t... Bytes>
+struct NciBytes {
+  static const uint16_t length = sizeof...(Bytes);
+  static const uint8_t data[sizeof...(Bytes)];
+};
+
+template <uint8_t... Bytes>
+const uint8_t NciBytes<Bytes...>::data[sizeof...(Bytes)] = {Bytes...};
+
+/* Concatenation of NciBytes, the result is in type */
+template <class... Parts>
+struct NciJoin;
+
+template <uint8_t... Bytes>
+struct NciJoin<NciBytes<Bytes...> > {
+  typedef NciBytes<Bytes...> type;
+};
+
+template <uint8_t... First, uint8_t... Second, class... Rest>
+struct NciJoin<NciBytes<First...>, NciBytes<Second...>, Rest...> : NciJoin<NciBytes<First..., Second...>, Rest...> {};
+
+/* Parts may be NciBytes or any frame element below, they all derive from NciBytes */
+template <uint8_t... Bytes>
+NciBytes<Bytes...> nciBytesOf(const NciBytes<Bytes...> *);
+
+template <class Part>
+struct NciBytesOf {
+  typedef decltype(nciBytesOf((Part *)0)) type;
+};
+
+/*
+ * Command of the given GID and OID, the payload is the concatenation of the parts
+ */
+template <uint8_t Gid, uint8_t Oid, class... Parts>
+struct NciCommand : NciJoin<NciBytes<(uint8_t)(0x20 | Gid), Oid, (uint8_t)NciJoin<NciBytes<>, typename NciBytesOf<Parts>::type...>::type::length>,
+                            typename NciBytesOf<Parts>::type...>::type {
+  static_assert(Gid <= 0x0F, "GID is 4 bits");
+  static_assert(Oid <= 0x3F, "OID is 6 bits");
+  static_assert(NciJoin<NciBytes<>, typename NciBytesOf<Parts>::type...>::type::length <= 255, "payload longer than a frame");
+};
+
+/*
+ * Configuration parameter, IDs above 0xFF are the 2 bytes NXP proprietary ones (0xA0xx)
+ */
+template <uint16_t Id, bool Proprietary = (Id > 0xFF)>
+struct NciParamId : NciBytes<(uint8_t)(Id >> 8), (uint8_t)Id> {};
+
+template <uint16_t Id>
+struct NciParamId<Id, false> : NciBytes<(uint8_t)Id> {};
+
+template <uint16_t Id, uint8_t... Value>
+struct NciParam : NciJoin<typename NciBytesOf<NciParamId<Id> >::type, NciBytes<(uint8_t)sizeof...(Value), Value...> >::type {
+  static_assert(sizeof...(Value) <= 251, "value longer than a CORE_SET_CONFIG_CMD");
+};
+
+/* CORE_SET_CONFIG_CMD, the number of parameters is counted */
+template <class... Params>
+struct NciSetConfig : NciCommand<0x00, 0x02, NciBytes<(uint8_t)sizeof...(Params)>, Params...> {
+  static_assert(sizeof...(Params) <= 255, "too many parameters");
+};
+
+/* CORE_GET_CONFIG_CMD, the parameters are reported in the same order */
+template <uint16_t... Ids>
+struct NciGetConfig : NciCommand<0x00, 0x03, NciBytes<(uint8_t)sizeof...(Ids)>, NciParamId<Ids>...> {};
+
+/* RF_DISCOVER_MAP_CMD, each mapping is a NciMapping */
+template <uint8_t Protocol, uint8_t Mode, uint8_t Interface>
+struct NciMapping : NciBytes<Protocol, Mode, Interface> {};
+
+template <class... Mappings>
+struct NciDiscoverMap : NciCommand<0x01, 0x00, NciBytes<(uint8_t)sizeof...(Mappings)>, Mappings...> {};
+
+/* RF_SET_LISTEN_MODE_ROUTING_CMD, each entry is a NciRoute */
+template <uint8_t Type, uint8_t... Value>
+struct NciRoute : NciBytes<Type, (uint8_t)sizeof...(Value), Value...> {};
+
+template <class... Routes>
+struct NciRouting : NciCommand<0x01, 0x01, NciBytes<0x00, (uint8_t)sizeof...(Routes)>, Routes...> {};
+
+/* RF_DISCOVER_CMD polling or listening each technology at every discovery period */
+template <uint8_t... ModeTechs>
+struct NciDiscover : NciCommand<0x01, 0x03, NciBytes<(uint8_t)sizeof...(ModeTechs)>, NciBytes<ModeTechs, 0x01>...> {};
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * Library to keep every tag found by one discovery of the PN7150
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciInventory.h"
+
+#include <string.h>
+
+NciInventory::NciInventory() {
+  clear();
+}
+
+/// @return false if the table is full or the ID is already in it
+bool NciInventory::add(uint8_t id, uint8_t protocol, uint8_t modeTech, const uint8_t *params, uint8_t paramsLength) {
+  if ((count == NCI_INVENTORY_SIZE) || (find(id) != NCI_INVENTORY_NONE))
+    return false;
+
+  if (paramsLength > NCI_INVENTORY_PARAMS_SIZE)
+    paramsLength = NCI_INVENTORY_PARAMS_SIZE;
+  tags[count].id = id;
+  tags[count].protocol = protocol;
+  tags[count].modeTech = modeTech;
+  tags[count].paramsLength = paramsLength;
+  memcpy(tags[count].params, params, paramsLength);
+  count++;
+  return true;
+}
+
+void NciInventory::clear() {
+  this->count = 0;
+}
+
+uint8_t NciInventory::getCount() const {
+  return count;
+}
+
+const NciInventoryTag *NciInventory::getTag(uint8_t index) const {
+  return (index < count) ? &tags[index] : NULL;
+}
+
+uint8_t NciInventory::find(uint8_t id) const {
+  for (uint8_t i = 0; i < count; i++) {
+    if (tags[i].id == id)
+      return i;
+  }
+  return NCI_INVENTORY_NONE;
+}
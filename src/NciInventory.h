@@ -0,0 +1,55 @@
+/**
+ * Library to keep every tag found by one discovery of the PN7150
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciInventory_H
+#define NciInventory_H
+
+#include <stdint.h>
+
+/*
+ * Number of tags kept, further RF_DISCOVER_NTF are dropped
+ */
+#ifndef NCI_INVENTORY_SIZE
+#define NCI_INVENTORY_SIZE 5
+#endif
+
+#define NCI_INVENTORY_PARAMS_SIZE 20  // RF technology specific parameters, NFC-F ones are the longest
+#define NCI_INVENTORY_NONE 0xFF
+
+typedef struct {
+  uint8_t id;        // RF discovery ID, selects the tag
+  uint8_t protocol;  // PROT_xxx
+  uint8_t modeTech;  // MODE_xxx | TECH_xxx
+  uint8_t paramsLength;
+  uint8_t params[NCI_INVENTORY_PARAMS_SIZE];  // same layout as in RF_INTF_ACTIVATED_NTF, truncated if longer
+} NciInventoryTag;
+
+/*
+ * Tags of the current discovery, from RF_DISCOVER_NTF when several answered or from
+ * RF_INTF_ACTIVATED_NTF when only one did. The table is emptied when the discovery starts again.
+ */
+class NciInventory {
+ private:
+  NciInventoryTag tags[NCI_INVENTORY_SIZE];
+  uint8_t count;
+
+ public:
+  NciInventory();
+  bool add(uint8_t id, uint8_t protocol, uint8_t modeTech, const uint8_t *params, uint8_t paramsLength);
+  void clear();
+  uint8_t getCount() const;
+  const NciInventoryTag *getTag(uint8_t index) const;  // NULL if index is out of range
+  uint8_t find(uint8_t id) const;                     // index of the tag, NCI_INVENTORY_NONE if not found
+};
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * Library to measure the NCI command round trips of the PN7150
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciMetrics.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define MT_MASK 0xE0
+#define MT_DATA 0x00
+#define MT_CMD 0x20
+#define MT_RSP 0x40
+#define MT_NTF 0x60
+#define GID_MASK 0x0F
+#define OID_MASK 0x3F
+#define STATUS_RF_TIMEOUT 0xB2
+
+NciMetrics::NciMetrics() {
+  reset();
+}
+
+void NciMetrics::reset() {
+  memset(_opcodes, 0, sizeof(_opcodes));
+  memset(&_busWrite, 0, sizeof(_busWrite));
+  memset(&_busRead, 0, sizeof(_busRead));
+  this->_opcodeCount = 0;
+  this->_untracked = 0;
+  this->_pending = -1;
+  this->_pendingStart = 0;
+}
+
+/// @brief Start timing a command or a data packet, replaces the one still waiting if any
+void NciMetrics::commandSent(const uint8_t *frame, uint32_t timestamp) {
+  uint8_t gid = frame[0] & (MT_MASK | GID_MASK);  // PBF bit cleared
+  uint8_t oid = ((frame[0] & MT_MASK) == MT_DATA) ? 0x00 : frame[1] & OID_MASK;
+  uint8_t i;
+
+  if (gid == MT_DATA)
+    gid = 0x00;  // every logical connection together
+
+  for (i = 0; i < _opcodeCount; i++) {
+    if ((_opcodes[i].gid == gid) && (_opcodes[i].oid == oid))
+      break;
+  }
+  if (i == _opcodeCount) {
+    if (_opcodeCount == NCI_METRICS_OPCODES) {
+      _untracked++;
+      _pending = -1;
+      return;
+    }
+    _opcodes[i].gid = gid;
+    _opcodes[i].oid = oid;
+    _opcodeCount++;
+  }
+
+  _pending = i;
+  _pendingStart = timestamp;
+}
+
+void NciMetrics::complete(uint32_t timestamp) {
+  add(&_opcodes[_pending].latency, timestamp - _pendingStart);
+  _pending = -1;
+}
+
+/// @brief Match a frame read by the driver with the command waiting for its response. Notifications received
+/// meanwhile are ignored, except the interface errors that end a data exchange
+void NciMetrics::frameReceived(const uint8_t *frame, uint32_t timestamp) {
+  NciOpcodeMetrics *opcode;
+  uint8_t mt = frame[0] & MT_MASK;
+
+  if (_pending < 0)
+    return;
+  opcode = &_opcodes[_pending];
+
+  if ((opcode->gid & MT_MASK) == MT_CMD) {
+    if (mt != MT_RSP)
+      return;
+    if (((frame[0] & GID_MASK) != (opcode->gid & GID_MASK)) || ((frame[1] & OID_MASK) != opcode->oid) || ((frame[2] > 0) && (frame[3] != 0x00)))
+      opcode->unexpected++;
+    complete(timestamp);
+    return;
+  }
+
+  /* Data packet, answered by data or ended by CORE_INTERFACE_ERROR_NTF */
+  if (mt == MT_DATA) {
+    complete(timestamp);
+  } else if ((frame[0] == MT_NTF) && (frame[1] == 0x08)) {
+    if (frame[3] == STATUS_RF_TIMEOUT)
+      opcode->timeouts++;
+    else
+      opcode->unexpected++;
+    _pending = -1;
+  }
+}
+
+/// @brief The driver stopped waiting without receiving anything
+void NciMetrics::timedOut() {
+  if (_pending < 0)
+    return;
+  _opcodes[_pending].timeouts++;
+  _pending = -1;
+}
+
+void NciMetrics::busWritten(uint32_t duration) {
+  add(&_busWrite, duration);
+}
+
+void NciMetrics::busRead(uint32_t duration) {
+  add(&_busRead, duration);
+}
+
+uint8_t NciMetrics::getOpcodeCount() const {
+  return _opcodeCount;
+}
+
+const NciOpcodeMetrics *NciMetrics::getOpcode(uint8_t index) const {
+  return (index < _opcodeCount) ? &_opcodes[index] : NULL;
+}
+
+/// @brief Metrics of a command, gid is the first byte of the command, e.g. 0x20 for CORE commands
+const NciOpcodeMetrics *NciMetrics::find(uint8_t gid, uint8_t oid) const {
+  for (uint8_t i = 0; i < _opcodeCount; i++) {
+    if ((_opcodes[i].gid == gid) && (_opcodes[i].oid == oid))
+      return &_opcodes[i];
+  }
+  return NULL;
+}
+
+uint32_t NciMetrics::getUntracked() const {
+  return _untracked;
+}
+
+const NciHistogram *NciMetrics::getBusWrite() const {
+  return &_busWrite;
+}
+
+const NciHistogram *NciMetrics::getBusRead() const {
+  return &_busRead;
+}
+
+void NciMetrics::add(NciHistogram *histogram, uint32_t value) {
+  uint8_t bucket = 0;
+
+  while ((bucket < NCI_METRICS_BUCKETS - 1) && ((value >> (bucket + 1)) != 0))
+    bucket++;
+  if (histogram->buckets[bucket] != 0xFFFF)
+    histogram->buckets[bucket]++;
+  histogram->count++;
+  if (value > histogram->max)
+    histogram->max = value;
+}
+
+uint32_t NciMetrics::percentile(const NciHistogram *histogram, uint8_t percent) {
+  uint32_t total = 0;
+  uint32_t target;
+  uint32_t seen = 0;
+  uint8_t i;
+
+  for (i = 0; i < NCI_METRICS_BUCKETS; i++)
+    total += histogram->buckets[i];
+  if (total == 0)
+    return 0;
+
+  target = ((total * percent) + 99) / 100;
+  for (i = 0; i < NCI_METRICS_BUCKETS - 1; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= target)
+      return (((2UL << i) - 1) < histogram->max) ? (2UL << i) - 1 : histogram->max;
+  }
+  return histogram->max;
+}
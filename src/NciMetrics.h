@@ -0,0 +1,80 @@
+/**
+ * Library to measure the NCI command round trips of the PN7150
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciMetrics_H
+#define NciMetrics_H
+
+#include <stdint.h>
+
+/*
+ * Bucket i of a histogram counts the latencies from 2^i to 2^(i+1) - 1 us, the last
+ * bucket also counts everything above. 20 buckets go up to about one second.
+ */
+#ifndef NCI_METRICS_BUCKETS
+#define NCI_METRICS_BUCKETS 20
+#endif
+
+/*
+ * Number of different commands tracked, GID/OID pairs are added as they are first sent
+ */
+#ifndef NCI_METRICS_OPCODES
+#define NCI_METRICS_OPCODES 16
+#endif
+
+typedef struct {
+  uint16_t buckets[NCI_METRICS_BUCKETS];  // saturate at 0xFFFF
+  uint32_t count;
+  uint32_t max;  // us
+} NciHistogram;
+
+typedef struct {
+  uint8_t gid;  // first byte of the command (MT | GID), 0x00 for data packets
+  uint8_t oid;
+  NciHistogram latency;  // from the command written to its response read
+  uint16_t timeouts;     // no response, or an RF timeout for data packets
+  uint16_t unexpected;   // another response, an error status or an RF error
+} NciOpcodeMetrics;
+
+class NciMetrics {
+ private:
+  NciOpcodeMetrics _opcodes[NCI_METRICS_OPCODES];
+  uint8_t _opcodeCount;
+  uint32_t _untracked;  // commands not tracked because the table is full
+  NciHistogram _busWrite;
+  NciHistogram _busRead;
+  int8_t _pending;  // index of the command waiting for its response, -1 if none
+  uint32_t _pendingStart;
+  void complete(uint32_t timestamp);
+
+ public:
+  NciMetrics();
+  void reset();
+  void commandSent(const uint8_t *frame, uint32_t timestamp);
+  void frameReceived(const uint8_t *frame, uint32_t timestamp);
+  void timedOut();
+  void busWritten(uint32_t duration);
+  void busRead(uint32_t duration);
+
+  uint8_t getOpcodeCount() const;
+  const NciOpcodeMetrics *getOpcode(uint8_t index) const;
+  const NciOpcodeMetrics *find(uint8_t gid, uint8_t oid) const;
+  uint32_t getUntracked() const;
+  const NciHistogram *getBusWrite() const;  // time spent writing frames on the bus
+  const NciHistogram *getBusRead() const;   // time spent reading frames from the bus
+
+  static void add(NciHistogram *histogram, uint32_t value);
+  // Upper bound (us) of the bucket holding the given percentile, at most max, 0 if the histogram is empty
+  static uint32_t percentile(const NciHistogram *histogram, uint8_t percent);
+};
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * Library to queue NCI frames received from the NFC controller
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciRingBuffer.h"
+
+#define NCI_RING_BUFFER_MASK (NCI_RING_BUFFER_SLOTS - 1)
+
+#if (NCI_RING_BUFFER_SLOTS & NCI_RING_BUFFER_MASK) || (NCI_RING_BUFFER_SLOTS > 64)
+#error "NCI_RING_BUFFER_SLOTS must be a power of two not greater than 64"
+#endif
+
+NciRingBuffer::NciRingBuffer() {
+  this->head = 0;
+  this->tail = 0;
+}
+
+bool NciRingBuffer::isEmpty() const {
+  return head == tail;
+}
+
+bool NciRingBuffer::isFull() const {
+  return (uint8_t)(head - tail) >= NCI_RING_BUFFER_SLOTS;
+}
+
+uint8_t NciRingBuffer::count() const {
+  return (uint8_t)(head - tail);
+}
+
+uint8_t *NciRingBuffer::reserve() {
+  if (isFull())
+    return NULL;
+  return slots[head & NCI_RING_BUFFER_MASK].data;
+}
+
+void NciRingBuffer::commit(uint16_t length) {
+  slots[head & NCI_RING_BUFFER_MASK].length = length;
+  __sync_synchronize();  // Frame content must be visible before the new head
+  head = head + 1;
+}
+
+bool NciRingBuffer::push(const uint8_t *frame, uint16_t length) {
+  uint8_t *slot = reserve();
+
+  if ((slot == NULL) || (length > NCI_RING_BUFFER_FRAME_SIZE))
+    return false;
+
+  memcpy(slot, frame, length);
+  commit(length);
+  return true;
+}
+
+uint16_t NciRingBuffer::pop(uint8_t *frame) {
+  uint16_t length;
+
+  if (isEmpty())
+    return 0;
+
+  __sync_synchronize();  // Read the frame only after observing the head that published it
+  Slot *slot = &slots[tail & NCI_RING_BUFFER_MASK];
+  length = slot->length;
+  memcpy(frame, slot->data, length);
+  __sync_synchronize();
+  tail = tail + 1;
+  return length;
+}
+
+void NciRingBuffer::clear() {
+  tail = head;
+}
@@ -0,0 +1,55 @@
+/**
+ * Library to queue NCI frames received from the NFC controller
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciRingBuffer_H
+#define NciRingBuffer_H
+
+#include <Arduino.h>
+
+/*
+ * Number of frames the ring can hold, must be a power of two not greater than 64
+ */
+#ifndef NCI_RING_BUFFER_SLOTS
+#define NCI_RING_BUFFER_SLOTS 4
+#endif
+
+#define NCI_RING_BUFFER_FRAME_SIZE 258  // Header (3 bytes) + max payload (255 bytes)
+
+/*
+ * Single producer / single consumer ring of NCI frames. The producer (IRQ handler,
+ * host thread or driver) only moves head, the consumer (getMessage) only moves tail,
+ * so no lock is needed as long as there is one of each.
+ */
+class NciRingBuffer {
+ private:
+  struct Slot {
+    uint16_t length;
+    uint8_t data[NCI_RING_BUFFER_FRAME_SIZE];
+  };
+  Slot slots[NCI_RING_BUFFER_SLOTS];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+
+ public:
+  NciRingBuffer();
+  bool isEmpty() const;
+  bool isFull() const;
+  uint8_t count() const;
+  uint8_t *reserve();             // Producer: get the next free slot, NULL if full
+  void commit(uint16_t length);   // Producer: publish the slot returned by reserve()
+  bool push(const uint8_t *frame, uint16_t length);
+  uint16_t pop(uint8_t *frame);   // Consumer: returns the frame length, 0 if empty
+  void clear();
+};
+
+#endif
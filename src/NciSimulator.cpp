@@ -0,0 +1,1369 @@
+/**
+ * Library to simulate a PN7150 and the tags in its field, so the driver can run without hardware
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciSimulator.h"
+
+/* NCI message types */
+#define MT_DATA 0x00
+#define MT_CMD 0x20
+#define MT_RSP 0x40
+#define MT_NTF 0x60
+#define PBF_SEGMENT 0x10
+
+/* NCI group identifiers */
+#define GID_CORE 0x0
+#define GID_RF 0x1
+#define GID_PROP 0xF
+
+/* NCI status codes */
+#define STATUS_OK 0x00
+#define STATUS_REJECTED 0x01
+#define STATUS_FAILED 0x03
+#define STATUS_SYNTAX_ERROR 0x05
+#define STATUS_SEMANTIC_ERROR 0x06
+#define STATUS_ACTIVATION_FAILED 0xA1
+#define STATUS_RF_TIMEOUT 0xB2
+
+#define DEACTIVATE_IDLE 0x00
+#define DEACTIVATE_SLEEP 0x01
+#define DEACTIVATE_SLEEP_AF 0x02
+#define DEACTIVATE_DISCOVERY 0x03
+
+#define NOTIFICATION_LAST 0x00
+#define NOTIFICATION_MORE 0x02
+
+#define NO_TAG 0xFF
+#define NO_BLOCK 0xFF
+
+#define READER_MAX_READ 0xF0
+#define READER_MAX_RETRIES 3
+
+/* Answer of CORE_INIT_CMD, firmware is at [17 + rxBuffer[8]] as read by connectNCI() */
+static const uint8_t CoreInitRsp[] = {
+    0x00,                          /* Status */
+    0x03, 0x1E, 0x03, 0x00,        /* NFCC features */
+    0x05,                          /* Number of supported RF interfaces */
+    0x01, 0x02, 0x03, 0x80, 0x82,  /* Frame, ISO-DEP, NFC-DEP, Tag-CMD, proprietary */
+    0x01,                          /* Max logical connections */
+    0x00, 0x02,                    /* Max routing table size */
+    0xFF,                          /* Max control packet payload size */
+    0x00, 0x00,                    /* Max size for large parameters */
+    0x04,                          /* Manufacturer ID */
+    0x04,                          /* Manufacturer specific information length */
+    0x10, 0x08, 0x01, 0x18         /* ROM code version, FW major, FW minor, HW version */
+};
+
+static const uint8_t T4T_AID[] = {0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01};
+static const uint8_t T4T_CCFileID[] = {0xE1, 0x03};
+static const uint8_t T4T_NdefFileID[] = {0xE1, 0x04};
+static const uint8_t T4T_OK[] = {0x90, 0x00};
+static const uint8_t T4T_NotFound[] = {0x6A, 0x82};
+static const uint8_t T4T_WrongOffset[] = {0x6B, 0x00};
+static const uint8_t T4T_NotAllowed[] = {0x69, 0x86};
+static const uint8_t T4T_WrongLength[] = {0x67, 0x00};
+
+static const uint8_t ReaderSelectApp[] = {0x00, 0xA4, 0x04, 0x00, 0x07, 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01, 0x00};
+static const uint8_t ReaderSelectCC[] = {0x00, 0xA4, 0x00, 0x0C, 0x02, 0xE1, 0x03};
+
+NciSimulator::NciSimulator() {
+  this->_ven = true;
+  this->_maxDataPayload = 0xFF;
+  this->_tagCount = 0;
+  this->_reader = false;
+  this->_readerBuffer = NULL;
+  this->_readerBufferSize = 0;
+  this->_readerReceived = 0;
+  this->_irqHandler = NULL;
+  this->_irqContext = NULL;
+  this->_droppedFrames = 0;
+  this->_configLength = 0;
+  reset();
+}
+
+bool NciSimulator::begin() {
+  return true;
+}
+
+/// @brief Feed a frame written by the driver to the simulated controller, the answers are queued for readFrame()
+uint8_t NciSimulator::writeFrame(const uint8_t *frame, uint16_t length) {
+  if (this->_state == STATE_OFF)
+    return 2;  // no answer on the bus, same as an address NACK
+  if ((length < 3) || (frame[2] != length - 3))
+    return 0;  // not a valid NCI packet, the controller drops it
+
+  uint8_t mt = frame[0] & 0xE0;
+  uint8_t gid = frame[0] & 0x0F;
+  uint8_t oid = frame[1] & 0x3F;
+
+  if (mt == MT_CMD) {
+    switch (gid) {
+      case GID_CORE:
+        handleCoreCommand(oid, &frame[3], frame[2]);
+        break;
+      case GID_RF:
+        handleRfCommand(oid, &frame[3], frame[2]);
+        break;
+      case GID_PROP:
+        handlePropCommand(oid, &frame[3], frame[2]);
+        break;
+      default:
+        queueStatus(gid, oid, STATUS_SYNTAX_ERROR);
+        break;
+    }
+  } else if ((mt == MT_DATA) && ((frame[0] & PBF_SEGMENT) || (this->_segmentsLength > 0))) {
+    if (this->_segmentsLength + frame[2] <= NCI_SIMULATOR_DATA_SIZE) {
+      memcpy(&this->_segments[this->_segmentsLength], &frame[3], frame[2]);
+      this->_segmentsLength += frame[2];
+    }
+    if (frame[0] & PBF_SEGMENT) {
+      queueCredits();
+    } else {
+      handleData(this->_segments, this->_segmentsLength);
+      this->_segmentsLength = 0;
+    }
+  } else if (mt == MT_DATA) {
+    handleData(&frame[3], frame[2]);
+  }
+
+  notify();
+  return 0;
+}
+
+uint16_t NciSimulator::readFrame(uint8_t *frame) {
+  uint16_t length = this->_frames.pop(frame);
+
+  flushData();
+  return length;
+}
+
+bool NciSimulator::isIrqActive() {
+  return !this->_frames.isEmpty();
+}
+
+/// @brief Nothing arrives on its own except a reader retransmitting an unanswered command, otherwise sleep the whole timeout
+bool NciSimulator::waitForIrq(unsigned long timeout) {
+  if (isIrqActive())
+    return true;
+
+  if ((this->_state == STATE_LISTEN_ACTIVE) && (this->_readerApduLength != 0) && (this->_readerRetries < READER_MAX_RETRIES)) {
+    this->_readerRetries++;
+    queueData(this->_readerApdu, this->_readerApduLength);
+    notify();
+    return true;
+  }
+
+  delay(timeout);
+  return false;
+}
+
+bool NciSimulator::hasVen() const {
+  return true;
+}
+
+void NciSimulator::setVen(bool level) {
+  if (level && !this->_ven)
+    reset();
+  if (!level)
+    this->_state = STATE_OFF;
+  this->_ven = level;
+}
+
+bool NciSimulator::attachIrqHandler(NciTransportIrqHandler_t *handler, void *context) {
+  this->_irqHandler = handler;
+  this->_irqContext = context;
+  return true;
+}
+
+void NciSimulator::detachIrqHandler() {
+  this->_irqHandler = NULL;
+  this->_irqContext = NULL;
+}
+
+void NciSimulator::idle(unsigned long timeout) {
+  waitForIrq(timeout);
+}
+
+/// @brief Put a virtual tag in the field, it is detected by the next discovery
+/// @param tag must stay valid until it is removed
+/// @return false if the protocol is not simulated or there is no room left
+bool NciSimulator::addTag(NciVirtualTag *tag) {
+  if ((tag == NULL) || (this->_tagCount >= NCI_SIMULATOR_MAX_TAGS))
+    return false;
+
+  switch (tag->protocol) {
+    case PROT_T2T:
+    case PROT_T3T:
+    case PROT_ISODEP:
+    case PROT_ISO15693:
+    case PROT_MIFARE:
+      break;
+    default:
+      return false;
+  }
+
+  this->_presenceLeft[this->_tagCount] = tag->presenceChecks;
+  this->_tags[this->_tagCount++] = tag;
+
+  /* Controller already polling, report the new tag as a real one entering the field would be */
+  if (this->_state == STATE_DISCOVERY) {
+    queueDiscovery();
+    notify();
+  }
+  return true;
+}
+
+bool NciSimulator::removeTag(NciVirtualTag *tag) {
+  for (uint8_t i = 0; i < this->_tagCount; i++) {
+    if (this->_tags[i] != tag)
+      continue;
+
+    if (this->_activeTag == i)
+      this->_activeTag = NO_TAG;
+    else if ((this->_activeTag != NO_TAG) && (this->_activeTag > i))
+      this->_activeTag--;
+
+    for (uint8_t j = i; j < this->_tagCount - 1; j++) {
+      this->_tags[j] = this->_tags[j + 1];
+      this->_presenceLeft[j] = this->_presenceLeft[j + 1];
+    }
+    this->_tagCount--;
+    return true;
+  }
+  return false;
+}
+
+void NciSimulator::removeAllTags() {
+  this->_tagCount = 0;
+  this->_activeTag = NO_TAG;
+}
+
+uint8_t NciSimulator::getTagCount() const {
+  return this->_tagCount;
+}
+
+/// @brief Largest data packet payload announced in RF_INTF_ACTIVATED_NTF, longer answers are segmented
+void NciSimulator::setMaxDataPayload(uint8_t size) {
+  if (size == 0)
+    size = 1;
+  this->_maxDataPayload = size;
+}
+
+/// @brief Put a reader in the field. In card emulation it reads the NDEF message of the emulated T4T into buffer and leaves
+bool NciSimulator::addReader(uint8_t *buffer, uint16_t bufferSize) {
+  if (buffer == NULL)
+    return false;
+
+  this->_readerBuffer = buffer;
+  this->_readerBufferSize = bufferSize;
+  this->_readerReceived = 0;
+  this->_reader = true;
+
+  if ((this->_state == STATE_DISCOVERY) && this->_listenRequested) {
+    queueDiscovery();
+    notify();
+  }
+  return true;
+}
+
+void NciSimulator::removeReader() {
+  this->_reader = false;
+}
+
+/// @brief Length of the NDEF message read by the last reader, 0 if it could not read it
+uint16_t NciSimulator::getReaderMessageLength() const {
+  return this->_readerReceived;
+}
+
+/// @brief Frames lost because the driver did not read them fast enough, see NCI_RING_BUFFER_SLOTS
+uint32_t NciSimulator::getDroppedFrames() const {
+  return this->_droppedFrames;
+}
+
+/// @brief Fill the memory of a tag with an NDEF message using the layout of its protocol
+/// @return false if the message does not fit
+bool NciSimulator::formatTag(NciVirtualTag *tag, const uint8_t *ndef, uint16_t ndefLength) {
+  uint8_t *mem = tag->memory;
+  uint16_t size = tag->memorySize;
+  uint8_t tlvLength = (ndefLength > 0xFE) ? 4 : 2;
+  uint16_t i;
+
+  if (mem == NULL)
+    return false;
+  memset(mem, 0, size);
+
+  switch (tag->protocol) {
+    case PROT_T2T:
+      /* Header blocks, CC on block 3, NDEF TLV from block 4 */
+      if (size < 16 + tlvLength + ndefLength + 1)
+        return false;
+      memcpy(mem, tag->uid, tag->uidLength);
+      mem[12] = 0xE1;
+      mem[13] = 0x10;
+      mem[14] = ((size - 16) / 8 > 0xFF) ? 0xFF : (size - 16) / 8;
+      mem[15] = 0x00;
+      i = 16;
+      break;
+
+    case PROT_ISODEP:
+      if (size < ndefLength + 2)
+        return false;
+      mem[0] = ndefLength >> 8;
+      mem[1] = ndefLength & 0xFF;
+      memcpy(&mem[2], ndef, ndefLength);
+      return true;
+
+    case PROT_MIFARE: {
+      /* MAD in sector 0 maps every sector to the NDEF application, NDEF TLV from block 4 skipping sector trailers */
+      static const uint8_t madTrailer[] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0x78, 0x77, 0x88, 0xC1, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+      static const uint8_t ndefTrailer[] = {0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7, 0x7F, 0x07, 0x88, 0x40, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+      uint16_t capacity = ((size / 64) - 1) * 48;
+      uint16_t block = 4;
+      uint16_t pos = 0;
+      uint8_t tlv[4] = {0x03, (uint8_t)ndefLength, 0, 0};
+
+      if ((size < 128) || (capacity < tlvLength + ndefLength + 1))
+        return false;
+      memcpy(mem, tag->uid, tag->uidLength);
+      mem[17] = 0x01;  // MAD info byte, CRC is not checked by the reader
+      for (i = 18; i < 48; i += 2) {
+        mem[i] = 0x03;  // NDEF application identifier
+        mem[i + 1] = 0xE1;
+      }
+      memcpy(&mem[48], madTrailer, sizeof(madTrailer));
+      for (i = 1; i < size / 64; i++)
+        memcpy(&mem[(i * 64) + 48], ndefTrailer, sizeof(ndefTrailer));
+
+      if (tlvLength == 4) {
+        tlv[1] = 0xFF;
+        tlv[2] = ndefLength >> 8;
+        tlv[3] = ndefLength & 0xFF;
+      }
+      for (i = 0; i < tlvLength + ndefLength + 1; i++) {
+        uint8_t value;
+        if (i < tlvLength)
+          value = tlv[i];
+        else if (i < tlvLength + ndefLength)
+          value = ndef[i - tlvLength];
+        else
+          value = 0xFE;
+
+        if ((block % 4) == 3)
+          block++;  // sector trailer
+        mem[(block * 16) + pos] = value;
+        if (++pos == 16) {
+          pos = 0;
+          block++;
+        }
+      }
+      return true;
+    }
+
+    case PROT_T3T: {
+      /* Attribute information block followed by the NDEF blocks */
+      uint16_t blocks = (size / 16) - 1;
+      uint16_t checksum = 0;
+
+      if ((size < 32) || (blocks * 16 < ndefLength))
+        return false;
+      mem[0] = 0x10;  // Version 1.0
+      mem[1] = 0x04;  // Nbr
+      mem[2] = 0x01;  // Nbw
+      mem[3] = blocks >> 8;
+      mem[4] = blocks & 0xFF;
+      mem[9] = 0x00;   // WriteF
+      mem[10] = 0x01;  // RWFlag
+      mem[11] = 0x00;
+      mem[12] = ndefLength >> 8;
+      mem[13] = ndefLength & 0xFF;
+      for (i = 0; i < 14; i++)
+        checksum += mem[i];
+      mem[14] = checksum >> 8;
+      mem[15] = checksum & 0xFF;
+      memcpy(&mem[16], ndef, ndefLength);
+      return true;
+    }
+
+    case PROT_ISO15693:
+      /* Type 5 CC on block 0, NDEF TLV from block 1 */
+      if (size < 4 + tlvLength + ndefLength + 1)
+        return false;
+      mem[0] = 0xE1;
+      mem[1] = 0x40;
+      mem[2] = size / 8;
+      mem[3] = 0x01;
+      i = 4;
+      break;
+
+    default:
+      return false;
+  }
+
+  /* NDEF TLV for T2T and ISO15693 */
+  mem[i++] = 0x03;
+  if (tlvLength == 4) {
+    mem[i++] = 0xFF;
+    mem[i++] = ndefLength >> 8;
+  }
+  mem[i++] = ndefLength & 0xFF;
+  memcpy(&mem[i], ndef, ndefLength);
+  mem[i + ndefLength] = 0xFE;
+  return true;
+}
+
+void NciSimulator::queue(const uint8_t *frame, uint16_t length) {
+  if (!this->_frames.push(frame, length))
+    this->_droppedFrames++;
+}
+
+void NciSimulator::queueControl(uint8_t mt, uint8_t gid, uint8_t oid, const uint8_t *payload, uint8_t length) {
+  uint8_t *slot = this->_frames.reserve();
+
+  if (slot == NULL) {
+    this->_droppedFrames++;
+    return;
+  }
+  slot[0] = mt | gid;
+  slot[1] = oid;
+  slot[2] = length;
+  memcpy(&slot[3], payload, length);
+  this->_frames.commit(length + 3);
+}
+
+void NciSimulator::queueStatus(uint8_t gid, uint8_t oid, uint8_t status) {
+  queueControl(MT_RSP, gid, oid, &status, 1);
+}
+
+/// @brief Queue an answer from the remote device, split in several packets if longer than the max data payload.
+/// Like the PN7150, packets that do not fit in the frame ring wait until the driver reads the previous ones
+void NciSimulator::queueData(const uint8_t *payload, uint16_t length) {
+  uint8_t frame[3] = {MT_DATA, 0x00, 0x00};
+
+  if (length == 0) {
+    queue(frame, sizeof(frame));
+    return;
+  }
+  if (this->_answerSent < this->_answerLength)
+    this->_droppedFrames++;  // previous answer not read yet
+
+  this->_answerLength = (length > NCI_SIMULATOR_DATA_SIZE) ? NCI_SIMULATOR_DATA_SIZE : length;
+  this->_answerSent = 0;
+  memcpy(this->_answer, payload, this->_answerLength);
+  flushData();
+}
+
+void NciSimulator::flushData() {
+  uint8_t frame[NCI_RING_BUFFER_FRAME_SIZE];
+
+  while ((this->_answerSent < this->_answerLength) && !this->_frames.isFull()) {
+    uint16_t length = this->_answerLength - this->_answerSent;
+    uint8_t size = (length > this->_maxDataPayload) ? this->_maxDataPayload : length;
+    frame[0] = MT_DATA | ((length > size) ? PBF_SEGMENT : 0x00);
+    frame[1] = 0x00;
+    frame[2] = size;
+    memcpy(&frame[3], &this->_answer[this->_answerSent], size);
+    queue(frame, size + 3);
+    this->_answerSent += size;
+  }
+}
+
+void NciSimulator::queueCredits() {
+  const uint8_t credits[] = {0x01, 0x00, 0x01};  // 1 entry, static connection, 1 credit
+  queueControl(MT_NTF, GID_CORE, 0x06, credits, sizeof(credits));
+}
+
+void NciSimulator::queueInterfaceError(uint8_t status) {
+  const uint8_t error[] = {status, 0x00};
+  queueControl(MT_NTF, GID_CORE, 0x08, error, sizeof(error));
+}
+
+uint8_t NciSimulator::techOf(uint8_t index) const {
+  switch (this->_tags[index]->protocol) {
+    case PROT_T3T:
+      return TECH_PASSIVE_NFCF;
+    case PROT_ISO15693:
+      return TECH_PASSIVE_15693;
+    default:
+      return TECH_PASSIVE_NFCA;
+  }
+}
+
+uint8_t NciSimulator::interfaceOf(uint8_t index) const {
+  switch (this->_tags[index]->protocol) {
+    case PROT_ISODEP:
+      return INTF_ISODEP;
+    case PROT_MIFARE:
+      return INTF_TAGCMD;
+    default:
+      return INTF_FRAME;
+  }
+}
+
+bool NciSimulator::isTagPolled(uint8_t index) const {
+  return (this->_pollTechs & (1 << techOf(index))) != 0;
+}
+
+/// @brief RF_INTF_ACTIVATED_NTF for a polled tag, or for the reader if index is NO_TAG
+void NciSimulator::queueActivation(uint8_t index) {
+  uint8_t ntf[40];
+  uint8_t len = 0;
+
+  if (index == NO_TAG) {
+    ntf[len++] = 0x01;
+    ntf[len++] = INTF_ISODEP;
+    ntf[len++] = PROT_ISODEP;
+    ntf[len++] = MODE_LISTEN | TECH_PASSIVE_NFCA;
+    ntf[len++] = this->_maxDataPayload;
+    ntf[len++] = 0x01;  // Initial credits
+    ntf[len++] = 0x00;  // No RF technology specific parameters
+    ntf[len++] = MODE_LISTEN | TECH_PASSIVE_NFCA;
+    ntf[len++] = 0x00;
+    ntf[len++] = 0x00;
+    ntf[len++] = 0x01;  // Activation parameters: RATS parameter byte
+    ntf[len++] = 0x80;
+    queueControl(MT_NTF, GID_RF, 0x05, ntf, len);
+    return;
+  }
+
+  NciVirtualTag *tag = this->_tags[index];
+  uint8_t tech = techOf(index);
+  uint8_t paramsLength;
+
+  ntf[len++] = index + 1;
+  ntf[len++] = interfaceOf(index);
+  ntf[len++] = tag->protocol;
+  ntf[len++] = MODE_POLL | tech;
+  ntf[len++] = this->_maxDataPayload;
+  ntf[len++] = 0x01;  // Initial credits
+  paramsLength = len++;
+
+  if (tech == TECH_PASSIVE_NFCA) {
+    ntf[len++] = (tag->uidLength > 4) ? 0x44 : 0x04;  // SENS_RES
+    ntf[len++] = 0x00;
+    ntf[len++] = tag->uidLength;
+    memcpy(&ntf[len], tag->uid, tag->uidLength);
+    len += tag->uidLength;
+    ntf[len++] = 0x01;  // SEL_RES
+    ntf[len++] = (tag->protocol == PROT_ISODEP) ? 0x20 : (tag->protocol == PROT_MIFARE) ? 0x08
+                                                                                          : 0x00;
+  } else if (tech == TECH_PASSIVE_NFCF) {
+    ntf[len++] = 0x01;  // 212 kbps
+    ntf[len++] = 0x11;  // SENSF_RES: response code, NFCID2, PAD0/PAD1/MRTI/IC
+    ntf[len++] = 0x01;
+    memcpy(&ntf[len], tag->uid, 8);
+    len += 8;
+    memset(&ntf[len], 0xFF, 8);
+    len += 8;
+  } else {
+    ntf[len++] = 0x00;  // RES_FLAG
+    ntf[len++] = 0x00;  // DSFID
+    memcpy(&ntf[len], tag->uid, 8);
+    len += 8;
+  }
+  ntf[paramsLength] = len - paramsLength - 1;
+
+  ntf[len++] = MODE_POLL | tech;  // Data exchange RF technology and mode
+  ntf[len++] = 0x00;              // Data exchange transmit bit rate
+  ntf[len++] = 0x00;              // Data exchange receive bit rate
+  if (tag->protocol == PROT_ISODEP) {
+    const uint8_t ats[] = {0x05, 0x78, 0x80, 0x70, 0x02};
+    ntf[len++] = sizeof(ats) + 1;
+    ntf[len++] = sizeof(ats);
+    memcpy(&ntf[len], ats, sizeof(ats));
+    len += sizeof(ats);
+  } else {
+    ntf[len++] = 0x00;
+  }
+  queueControl(MT_NTF, GID_RF, 0x05, ntf, len);
+
+  this->_activeTag = index;
+  this->_mifareSector = NO_BLOCK;
+  this->_mifareWriteBlock = NO_BLOCK;
+  this->_t4tFile = 0;
+  this->_t2tMuted = false;
+  this->_t2tSector = 0;
+  this->_t2tSectorSelect = false;
+}
+
+/// @brief Report what is in the field: activate a lone tag, list several ones, or let the reader in
+void NciSimulator::queueDiscovery() {
+  uint8_t polled[NCI_SIMULATOR_MAX_TAGS];
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < this->_tagCount; i++) {
+    if (isTagPolled(i))
+      polled[count++] = i;
+  }
+
+  if (count == 1) {
+    queueActivation(polled[0]);
+    this->_state = STATE_POLL_ACTIVE;
+  } else if (count > 1) {
+    for (uint8_t i = 0; i < count; i++) {
+      uint8_t ntf[8];
+      ntf[0] = polled[i] + 1;
+      ntf[1] = this->_tags[polled[i]]->protocol;
+      ntf[2] = MODE_POLL | techOf(polled[i]);
+      ntf[3] = 0x00;  // No RF technology specific parameters
+      ntf[4] = (i == count - 1) ? NOTIFICATION_LAST : NOTIFICATION_MORE;
+      queueControl(MT_NTF, GID_RF, 0x03, ntf, 5);
+    }
+    this->_state = STATE_W4_HOST_SELECT;
+  } else if (this->_listenRequested && this->_reader) {
+    queueActivation(NO_TAG);
+    this->_state = STATE_LISTEN_ACTIVE;
+    this->_readerStep = 0;
+    this->_readerRestarts = 0;
+    this->_readerReceived = 0;
+    readerNext(NULL, 0);
+  }
+}
+
+void NciSimulator::reset() {
+  this->_frames.clear();
+  this->_state = STATE_IDLE;
+  this->_activeTag = NO_TAG;
+  this->_pollTechs = 0;
+  this->_listenRequested = false;
+  this->_mifareSector = NO_BLOCK;
+  this->_mifareWriteBlock = NO_BLOCK;
+  this->_t4tFile = 0;
+  this->_t2tMuted = false;
+  this->_t2tSector = 0;
+  this->_t2tSectorSelect = false;
+  this->_readerApduLength = 0;
+  this->_segmentsLength = 0;
+  this->_answerLength = 0;
+  this->_answerSent = 0;
+}
+
+bool NciSimulator::checkPresence() {
+  if (this->_activeTag == NO_TAG)
+    return false;
+  if (this->_tags[this->_activeTag]->presenceChecks == 0)
+    return true;
+  if (this->_presenceLeft[this->_activeTag] > 0) {
+    this->_presenceLeft[this->_activeTag]--;
+    return true;
+  }
+  removeActiveTag();
+  return false;
+}
+
+void NciSimulator::removeActiveTag() {
+  if (this->_activeTag != NO_TAG)
+    removeTag(this->_tags[this->_activeTag]);
+}
+
+void NciSimulator::setConfig(const uint8_t *payload, uint8_t length) {
+  uint8_t count = payload[0];
+  uint8_t pos = 1;
+  const uint8_t rsp[] = {STATUS_OK, 0x00};
+
+  while ((count-- > 0) && (pos < length)) {
+    uint8_t idLength = ((payload[pos] & 0xF0) == 0xA0) ? 2 : 1;  // NXP proprietary parameters have a 2 bytes ID
+    uint8_t entryLength = idLength + 1 + payload[pos + idLength];
+    uint8_t i = 0;
+
+    /* Drop the old value of this parameter */
+    while (i < this->_configLength) {
+      uint8_t storedIdLength = ((this->_config[i] & 0xF0) == 0xA0) ? 2 : 1;
+      uint8_t storedLength = storedIdLength + 1 + this->_config[i + storedIdLength];
+      if (!memcmp(&this->_config[i], &payload[pos], idLength) && (storedIdLength == idLength)) {
+        memmove(&this->_config[i], &this->_config[i + storedLength], this->_configLength - i - storedLength);
+        this->_configLength -= storedLength;
+        break;
+      }
+      i += storedLength;
+    }
+
+    if (this->_configLength + entryLength > NCI_SIMULATOR_CONFIG_SIZE) {
+      queueStatus(GID_CORE, 0x02, STATUS_FAILED);
+      return;
+    }
+    memcpy(&this->_config[this->_configLength], &payload[pos], entryLength);
+    this->_configLength += entryLength;
+    pos += entryLength;
+  }
+  queueControl(MT_RSP, GID_CORE, 0x02, rsp, sizeof(rsp));
+}
+
+/// @brief Drop the NCI parameters, the NXP proprietary ones are kept in EEPROM by the PN7150
+void NciSimulator::resetConfig() {
+  uint8_t i = 0;
+
+  while (i < this->_configLength) {
+    uint8_t storedIdLength = ((this->_config[i] & 0xF0) == 0xA0) ? 2 : 1;
+    uint8_t storedLength = storedIdLength + 1 + this->_config[i + storedIdLength];
+    if (storedIdLength == 1) {
+      memmove(&this->_config[i], &this->_config[i + storedLength], this->_configLength - i - storedLength);
+      this->_configLength -= storedLength;
+    } else {
+      i += storedLength;
+    }
+  }
+}
+
+void NciSimulator::getConfig(const uint8_t *payload, uint8_t length) {
+  uint8_t rsp[NCI_RING_BUFFER_FRAME_SIZE];
+  uint8_t count = payload[0];
+  uint8_t pos = 1;
+  uint16_t len = 2;
+
+  rsp[0] = STATUS_OK;
+  rsp[1] = count;
+  while ((count-- > 0) && (pos < length)) {
+    uint8_t idLength = ((payload[pos] & 0xF0) == 0xA0) ? 2 : 1;
+    uint8_t i = 0;
+    bool found = false;
+
+    while (i < this->_configLength) {
+      uint8_t storedIdLength = ((this->_config[i] & 0xF0) == 0xA0) ? 2 : 1;
+      uint8_t storedLength = storedIdLength + 1 + this->_config[i + storedIdLength];
+      if ((storedIdLength == idLength) && !memcmp(&this->_config[i], &payload[pos], idLength)) {
+        if (len + storedLength > 255)
+          break;
+        memcpy(&rsp[len], &this->_config[i], storedLength);
+        len += storedLength;
+        found = true;
+        break;
+      }
+      i += storedLength;
+    }
+
+    /* Parameter never written, report it empty */
+    if (!found && (len + idLength + 1 <= 255)) {
+      memcpy(&rsp[len], &payload[pos], idLength);
+      len += idLength;
+      rsp[len++] = 0x00;
+    }
+    pos += idLength;
+  }
+  queueControl(MT_RSP, GID_CORE, 0x03, rsp, len);
+}
+
+void NciSimulator::handleCoreCommand(uint8_t oid, const uint8_t *payload, uint8_t length) {
+  switch (oid) {
+    case 0x00: { /* CORE_RESET */
+      uint8_t rsp[] = {STATUS_OK, 0x10, 0x00};  // NCI 1.0
+      reset();
+      if ((length > 0) && (payload[0] == 0x01)) {
+        resetConfig();
+        rsp[2] = 0x01;  // Configuration reset
+      }
+      queueControl(MT_RSP, GID_CORE, oid, rsp, sizeof(rsp));
+      break;
+    }
+
+    case 0x01: /* CORE_INIT */
+      queueControl(MT_RSP, GID_CORE, oid, CoreInitRsp, sizeof(CoreInitRsp));
+      break;
+
+    case 0x02: /* CORE_SET_CONFIG */
+      if (length == 0)
+        queueStatus(GID_CORE, oid, STATUS_SYNTAX_ERROR);
+      else
+        setConfig(payload, length);
+      break;
+
+    case 0x03: /* CORE_GET_CONFIG */
+      if (length == 0)
+        queueStatus(GID_CORE, oid, STATUS_SYNTAX_ERROR);
+      else
+        getConfig(payload, length);
+      break;
+
+    default:
+      queueStatus(GID_CORE, oid, STATUS_SYNTAX_ERROR);
+      break;
+  }
+}
+
+void NciSimulator::startDiscovery(const uint8_t *payload, uint8_t length) {
+  this->_pollTechs = 0;
+  this->_listenRequested = false;
+  for (uint8_t i = 0; (i < payload[0]) && (1 + (2 * i) < length); i++) {
+    uint8_t mode = payload[1 + (2 * i)];
+    if (mode & MODE_LISTEN)
+      this->_listenRequested = true;
+    else
+      this->_pollTechs |= 1 << (mode & 0x0F);
+  }
+
+  queueStatus(GID_RF, 0x03, STATUS_OK);
+  this->_state = STATE_DISCOVERY;
+  queueDiscovery();
+}
+
+void NciSimulator::handleRfCommand(uint8_t oid, const uint8_t *payload, uint8_t length) {
+  switch (oid) {
+    case 0x00: /* RF_DISCOVER_MAP */
+    case 0x01: /* RF_SET_LISTEN_MODE_ROUTING */
+      queueStatus(GID_RF, oid, STATUS_OK);
+      break;
+
+    case 0x03: /* RF_DISCOVER */
+      if (this->_state != STATE_IDLE)
+        queueStatus(GID_RF, oid, STATUS_SEMANTIC_ERROR);
+      else if (length == 0)
+        queueStatus(GID_RF, oid, STATUS_SYNTAX_ERROR);
+      else
+        startDiscovery(payload, length);
+      break;
+
+    case 0x04: { /* RF_DISCOVER_SELECT */
+      uint8_t index = (length > 0) ? payload[0] - 1 : NO_TAG;
+
+      if (((this->_state != STATE_W4_HOST_SELECT) && (this->_state != STATE_SLEEP)) || (length < 3)) {
+        queueStatus(GID_RF, oid, STATUS_SEMANTIC_ERROR);
+        break;
+      }
+      queueStatus(GID_RF, oid, STATUS_OK);
+
+      /* MIFARE presence check is a re-selection */
+      this->_activeTag = (index < this->_tagCount) ? index : NO_TAG;
+      if ((this->_activeTag != NO_TAG) && (this->_tags[index]->protocol == PROT_MIFARE) && (this->_state == STATE_SLEEP))
+        checkPresence();
+
+      if (this->_activeTag == NO_TAG) {
+        uint8_t status = STATUS_ACTIVATION_FAILED;
+        queueControl(MT_NTF, GID_CORE, 0x07, &status, 1);
+        this->_state = STATE_DISCOVERY;
+      } else {
+        queueActivation(index);
+        this->_state = STATE_POLL_ACTIVE;
+      }
+      break;
+    }
+
+    case 0x06: { /* RF_DEACTIVATE */
+      uint8_t type = (length > 0) ? payload[0] : DEACTIVATE_IDLE;
+      uint8_t ntf[] = {type, 0x00};  // DH request
+
+      queueStatus(GID_RF, oid, STATUS_OK);
+      if ((this->_state == STATE_IDLE) || (this->_state == STATE_DISCOVERY)) {
+        this->_state = STATE_IDLE;  // nothing activated, no notification
+        break;
+      }
+
+      queueControl(MT_NTF, GID_RF, oid, ntf, sizeof(ntf));
+      if (type == DEACTIVATE_IDLE) {
+        this->_state = STATE_IDLE;
+      } else if (((type == DEACTIVATE_SLEEP) || (type == DEACTIVATE_SLEEP_AF)) && (this->_state == STATE_POLL_ACTIVE)) {
+        this->_state = STATE_SLEEP;
+      } else {
+        this->_state = STATE_DISCOVERY;
+        queueDiscovery();
+      }
+      break;
+    }
+
+    case 0x08: { /* RF_T3T_POLLING, T3T presence check */
+      bool present = (this->_state == STATE_POLL_ACTIVE) && (this->_activeTag != NO_TAG) &&
+                     (this->_tags[this->_activeTag]->protocol == PROT_T3T) && checkPresence();
+
+      queueStatus(GID_RF, oid, STATUS_OK);
+      if (present) {
+        uint8_t ntf[2 + 1 + 17];
+        ntf[0] = STATUS_OK;
+        ntf[1] = 0x01;  // Number of responses
+        ntf[2] = 0x11;
+        ntf[3] = 0x01;
+        memcpy(&ntf[4], this->_tags[this->_activeTag]->uid, 8);
+        memset(&ntf[12], 0xFF, 8);
+        queueControl(MT_NTF, GID_RF, oid, ntf, sizeof(ntf));
+      } else {
+        uint8_t ntf[] = {STATUS_RF_TIMEOUT, 0x00};
+        queueControl(MT_NTF, GID_RF, oid, ntf, sizeof(ntf));
+      }
+      break;
+    }
+
+    default:
+      queueStatus(GID_RF, oid, STATUS_SYNTAX_ERROR);
+      break;
+  }
+}
+
+void NciSimulator::handlePropCommand(uint8_t oid, const uint8_t *payload, uint8_t length) {
+  (void)payload;
+  (void)length;
+
+  switch (oid) {
+    case 0x00: /* Standby */
+    case 0x02: /* Proprietary RF interface activation */
+      queueStatus(GID_PROP, oid, STATUS_OK);
+      break;
+
+    case 0x11: { /* ISO-DEP presence check */
+      uint8_t present = ((this->_state == STATE_POLL_ACTIVE) && (this->_activeTag != NO_TAG) && checkPresence()) ? 0x01 : 0x00;
+      queueStatus(GID_PROP, oid, STATUS_OK);
+      queueControl(MT_NTF, GID_PROP, oid, &present, 1);
+      break;
+    }
+
+    default:
+      queueStatus(GID_PROP, oid, STATUS_SYNTAX_ERROR);
+      break;
+  }
+}
+
+void NciSimulator::handleData(const uint8_t *payload, uint16_t length) {
+  uint8_t rsp[NCI_SIMULATOR_DATA_SIZE];
+  uint16_t rspLength = 0;
+
+  if (this->_state == STATE_LISTEN_ACTIVE) {
+    queueCredits();
+    readerNext(payload, length);
+    return;
+  }
+  if (this->_state != STATE_POLL_ACTIVE)
+    return;
+
+  queueCredits();
+  if (this->_activeTag != NO_TAG) {
+    NciVirtualTag *tag = this->_tags[this->_activeTag];
+    switch (tag->protocol) {
+      case PROT_T2T:
+        rspLength = transceiveT2T(tag, payload, length, rsp);
+        break;
+      case PROT_ISODEP:
+        rspLength = transceiveT4T(tag, payload, length, rsp);
+        break;
+      case PROT_MIFARE:
+        rspLength = transceiveMifare(tag, payload, length, rsp);
+        break;
+      case PROT_T3T:
+        rspLength = transceiveT3T(tag, payload, length, rsp);
+        break;
+      case PROT_ISO15693:
+        rspLength = transceiveIso15693(tag, payload, length, rsp);
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (rspLength == 0)
+    queueInterfaceError(STATUS_RF_TIMEOUT);  // silent or gone tag
+  else
+    queueData(rsp, rspLength);
+}
+
+/// @brief READ (16 bytes, rolls over) and WRITE (4 bytes) of a Type 2 Tag, READ of block 0 is the driver presence check.
+/// GET_VERSION and FAST_READ when the tag has a version, any other command mutes the tag like a NAK would.
+/// A memory larger than 1024 bytes is split in sectors of 256 blocks, selected with SECTOR_SELECT
+uint16_t NciSimulator::transceiveT2T(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp) {
+  uint8_t *memory = &tag->memory[this->_t2tSector * 1024];
+  uint16_t blocks = (tag->memorySize - this->_t2tSector * 1024) / 4;
+
+  if (blocks > 256)
+    blocks = 256;
+  if (this->_t2tMuted)
+    return 0;
+
+  /* Second packet of SECTOR_SELECT, acknowledged by staying silent */
+  if (this->_t2tSectorSelect) {
+    this->_t2tSectorSelect = false;
+    if ((length == 4) && ((uint32_t)cmd[0] * 1024 < tag->memorySize)) {
+      this->_t2tSector = cmd[0];
+      return 0;
+    }
+    this->_t2tMuted = true;
+    return 0;
+  }
+
+  if ((length == 2) && (cmd[0] == 0xC2) && (cmd[1] == 0xFF) && (tag->memorySize > 1024)) {
+    this->_t2tSectorSelect = true;
+    rsp[0] = 0x0A;  // ACK
+    rsp[1] = STATUS_OK;
+    return 2;
+  }
+
+  if ((length == 1) && (cmd[0] == 0x60) && (tag->version != NULL)) {
+    memcpy(rsp, tag->version, 8);
+    rsp[8] = STATUS_OK;
+    return 9;
+  }
+
+  if ((length == 3) && (cmd[0] == 0x3A) && (tag->version != NULL)) {
+    if ((cmd[1] > cmd[2]) || (cmd[2] >= blocks) || ((cmd[2] - cmd[1] + 1) * 4 > NCI_RING_BUFFER_FRAME_SIZE))
+      return 0;
+    memcpy(rsp, &memory[cmd[1] * 4], (cmd[2] - cmd[1] + 1) * 4);
+    rsp[(cmd[2] - cmd[1] + 1) * 4] = STATUS_OK;
+    return (cmd[2] - cmd[1] + 1) * 4 + 1;
+  }
+
+  if ((length == 2) && (cmd[0] == 0x30)) {
+    if ((cmd[1] == 0x00) && !checkPresence())
+      return 0;
+    if (cmd[1] >= blocks)
+      return 0;
+    for (uint8_t i = 0; i < 16; i++)
+      rsp[i] = memory[((cmd[1] * 4) + i) % (blocks * 4)];
+    rsp[16] = STATUS_OK;
+    return 17;
+  }
+
+  if ((length == 6) && (cmd[0] == 0xA2)) {
+    if (((this->_t2tSector == 0) && (cmd[1] < 2)) || (cmd[1] >= blocks))
+      return 0;
+    memcpy(&memory[cmd[1] * 4], &cmd[2], 4);
+    rsp[0] = 0x0A;  // ACK
+    rsp[1] = STATUS_OK;
+    return 2;
+  }
+
+  this->_t2tMuted = true;
+  return 0;
+}
+
+/// @brief NDEF application of a Type 4 Tag: SELECT, READ BINARY and UPDATE BINARY on the CC and NDEF files
+uint16_t NciSimulator::transceiveT4T(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp) {
+  const uint8_t *sw = T4T_OK;
+  uint16_t len = 0;
+
+  if ((length < 4) || (cmd[0] != 0x00)) {
+    sw = T4T_NotAllowed;
+  } else if (cmd[1] == 0xA4) {
+    /* SELECT by name or by file identifier */
+    if ((cmd[2] == 0x04) && (length >= 5 + sizeof(T4T_AID)) && (cmd[4] == sizeof(T4T_AID)) && !memcmp(&cmd[5], T4T_AID, sizeof(T4T_AID))) {
+      this->_t4tFile = 0;
+    } else if ((cmd[2] == 0x00) && (length >= 7) && (cmd[4] == 2) && !memcmp(&cmd[5], T4T_CCFileID, 2)) {
+      this->_t4tFile = 1;
+    } else if ((cmd[2] == 0x00) && (length >= 7) && (cmd[4] == 2) && !memcmp(&cmd[5], T4T_NdefFileID, 2)) {
+      this->_t4tFile = 2;
+    } else {
+      sw = T4T_NotFound;
+    }
+  } else if ((cmd[1] == 0xB0) && ((length == 5) || ((length == 7) && (cmd[4] == 0x00)))) {
+    /* READ BINARY, Le of a short or an extended APDU */
+    uint16_t offset = (cmd[2] << 8) | cmd[3];
+    uint16_t le = (length == 7) ? ((cmd[5] << 8) | cmd[6]) : ((cmd[4] == 0) ? 256 : cmd[4]);
+    uint8_t cc[15] = {0x00, 0x0F, 0x20, NCI_SIMULATOR_T4T_MLE >> 8, NCI_SIMULATOR_T4T_MLE & 0xFF, NCI_SIMULATOR_T4T_MLC >> 8, NCI_SIMULATOR_T4T_MLC & 0xFF, 0x04, 0x06,
+                      T4T_NdefFileID[0], T4T_NdefFileID[1], (uint8_t)(tag->memorySize >> 8), (uint8_t)(tag->memorySize & 0xFF), 0x00, 0x00};
+    const uint8_t *file = (this->_t4tFile == 1) ? cc : tag->memory;
+    uint16_t fileSize = (this->_t4tFile == 1) ? sizeof(cc) : tag->memorySize;
+
+    if (this->_t4tFile == 0) {
+      sw = T4T_NotAllowed;
+    } else if ((le > NCI_SIMULATOR_T4T_MLE) || (le + 2 > NCI_SIMULATOR_DATA_SIZE)) {
+      sw = T4T_WrongLength;
+    } else if (offset >= fileSize) {
+      sw = T4T_WrongOffset;
+    } else {
+      len = (le > fileSize - offset) ? fileSize - offset : le;
+      memcpy(rsp, &file[offset], len);
+    }
+  } else if ((cmd[1] == 0xD6) && (length >= 5) && ((length == 5 + cmd[4]) || ((length >= 7) && (cmd[4] == 0x00)))) {
+    /* UPDATE BINARY, Lc of a short or an extended APDU */
+    uint16_t offset = (cmd[2] << 8) | cmd[3];
+    bool extended = (length != 5 + cmd[4]);
+    uint16_t lc = extended ? ((cmd[5] << 8) | cmd[6]) : cmd[4];
+    const uint8_t *data = extended ? &cmd[7] : &cmd[5];
+
+    if (this->_t4tFile != 2)
+      sw = T4T_NotAllowed;
+    else if ((lc > NCI_SIMULATOR_T4T_MLC) || (length != (data - cmd) + lc))
+      sw = T4T_WrongLength;
+    else if (offset + lc > tag->memorySize)
+      sw = T4T_WrongOffset;
+    else
+      memcpy(&tag->memory[offset], data, lc);
+  } else {
+    sw = T4T_NotAllowed;
+  }
+
+  memcpy(&rsp[len], sw, 2);
+  return len + 2;
+}
+
+/// @brief MIFARE Classic through the Tag-CMD interface: authenticate a sector, then READ or two steps WRITE in it
+uint16_t NciSimulator::transceiveMifare(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp) {
+  uint16_t blocks = tag->memorySize / 16;
+
+  if ((length >= 3) && (cmd[0] == 0x40)) {
+    /* Authenticate, keys are not checked */
+    rsp[0] = 0x40;
+    if (cmd[1] < blocks / 4) {
+      this->_mifareSector = cmd[1];
+      rsp[1] = STATUS_OK;
+    } else {
+      this->_mifareSector = NO_BLOCK;
+      rsp[1] = STATUS_FAILED;
+    }
+    this->_mifareWriteBlock = NO_BLOCK;
+    return 2;
+  }
+
+  if ((length == 17) && (cmd[0] == 0x10) && (this->_mifareWriteBlock != NO_BLOCK)) {
+    /* Second step of WRITE */
+    memcpy(&tag->memory[this->_mifareWriteBlock * 16], &cmd[1], 16);
+    this->_mifareWriteBlock = NO_BLOCK;
+    rsp[0] = 0x10;
+    rsp[1] = 0x0A;
+    rsp[2] = STATUS_OK;
+    return 3;
+  }
+
+  if ((length == 3) && (cmd[0] == 0x10)) {
+    if ((cmd[2] >= blocks) || ((cmd[2] / 4) != this->_mifareSector))
+      return 0;  // not authenticated, the tag does not answer
+
+    if (cmd[1] == 0x30) {
+      rsp[0] = 0x10;
+      memcpy(&rsp[1], &tag->memory[cmd[2] * 16], 16);
+      rsp[17] = STATUS_OK;
+      return 18;
+    }
+    if ((cmd[1] == 0xA0) && (cmd[2] != 0)) {
+      this->_mifareWriteBlock = cmd[2];
+      rsp[0] = 0x10;
+      rsp[1] = 0x0A;
+      rsp[2] = STATUS_OK;
+      return 3;
+    }
+  }
+  return 0;
+}
+
+/// @brief CHECK and UPDATE of a Type 3 Tag, the service code is not checked
+uint16_t NciSimulator::transceiveT3T(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp) {
+  uint16_t blocks = tag->memorySize / 16;
+  uint8_t count, pos, i;
+  uint8_t list[15];
+
+  if ((length < 14) || (cmd[0] != length) || ((cmd[1] != 0x06) && (cmd[1] != 0x08)))
+    return 0;
+  if (memcmp(&cmd[2], tag->uid, 8) && memcmp(&cmd[2], "\0\0\0\0\0\0\0\0", 8))
+    return 0;  // addressed to another IDm, the driver never sets it so zeros are accepted too
+
+  pos = 11 + (2 * cmd[10]);
+  count = cmd[pos++];
+  if (count > sizeof(list))
+    return 0;
+
+  rsp[1] = cmd[1] + 1;
+  memcpy(&rsp[2], &cmd[2], 8);
+  rsp[10] = 0x00;
+  rsp[11] = 0x00;
+  for (i = 0; i < count; i++) {
+    if (pos + 2 > length)
+      return 0;
+    if (cmd[pos] & 0x80) {  // 2 bytes block list element
+      list[i] = cmd[pos + 1];
+      pos += 2;
+    } else {  // 3 bytes block list element
+      list[i] = cmd[pos + 1];
+      pos += 3;
+    }
+    if (list[i] >= blocks) {
+      rsp[10] = 0x01;
+      rsp[11] = 0xA8;  // illegal block number
+    }
+  }
+
+  if (rsp[10] != 0x00) {
+    rsp[0] = 12;
+    rsp[12] = STATUS_OK;
+    return 13;
+  }
+
+  if (cmd[1] == 0x06) {
+    rsp[12] = count;
+    for (i = 0; i < count; i++)
+      memcpy(&rsp[13 + (16 * i)], &tag->memory[list[i] * 16], 16);
+    rsp[0] = 13 + (16 * count);
+  } else {
+    if (pos + (16 * count) > length)
+      return 0;
+    for (i = 0; i < count; i++)
+      memcpy(&tag->memory[list[i] * 16], &cmd[pos + (16 * i)], 16);
+    rsp[0] = 12;
+  }
+  rsp[rsp[0]] = STATUS_OK;
+  return rsp[0] + 1;
+}
+
+/// @brief INVENTORY (the driver presence check), READ SINGLE BLOCK and WRITE SINGLE BLOCK of an ISO15693 tag
+uint16_t NciSimulator::transceiveIso15693(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp) {
+  uint16_t blocks = tag->memorySize / 4;
+  uint8_t pos = 2;
+
+  if (length < 2)
+    return 0;
+
+  if (cmd[1] == 0x01) {
+    if (!checkPresence())
+      return 0;
+    rsp[0] = 0x00;  // flags
+    rsp[1] = 0x00;  // DSFID
+    memcpy(&rsp[2], tag->uid, 8);
+    rsp[10] = STATUS_OK;
+    return 11;
+  }
+
+  if (cmd[0] & 0x20) {  // addressed
+    if ((length < 10) || memcmp(&cmd[2], tag->uid, 8))
+      return 0;
+    pos = 10;
+  }
+
+  if ((cmd[1] == 0x20) && (length > pos)) {
+    if (cmd[pos] >= blocks)
+      return 0;
+    rsp[0] = 0x00;
+    memcpy(&rsp[1], &tag->memory[cmd[pos] * 4], 4);
+    rsp[5] = STATUS_OK;
+    return 6;
+  }
+
+  if ((cmd[1] == 0x21) && (length >= pos + 5)) {
+    if (cmd[pos] >= blocks)
+      return 0;
+    memcpy(&tag->memory[cmd[pos] * 4], &cmd[pos + 1], 4);
+    rsp[0] = 0x00;
+    rsp[1] = STATUS_OK;
+    return 2;
+  }
+
+  rsp[0] = 0x01;  // error flag
+  rsp[1] = 0x01;  // command not supported
+  rsp[2] = STATUS_OK;
+  return 3;
+}
+
+void NciSimulator::readerSend(const uint8_t *apdu, uint8_t length) {
+  memcpy(this->_readerApdu, apdu, length);
+  this->_readerApduLength = length;
+  this->_readerRetries = 0;
+  queueData(apdu, length);
+}
+
+/// @brief The reader got what it wanted, or gave up, and takes its field away
+void NciSimulator::readerLeave() {
+  uint8_t ntf[] = {DEACTIVATE_DISCOVERY, 0x02};  // RF link loss
+
+  this->_readerApduLength = 0;
+  this->_reader = false;
+  queueControl(MT_NTF, GID_RF, 0x06, ntf, sizeof(ntf));
+  this->_state = STATE_DISCOVERY;
+}
+
+/// @brief Reader side of the T4T NDEF read procedure, run against the card emulated by the driver
+void NciSimulator::readerNext(const uint8_t *rsp, uint16_t length) {
+  uint8_t apdu[13];
+  bool ok = (rsp != NULL) && (length >= 2) && !memcmp(&rsp[length - 2], T4T_OK, 2);
+
+  switch (this->_readerStep) {
+    case 0:
+      readerSend(ReaderSelectApp, sizeof(ReaderSelectApp));
+      break;
+
+    case 1:
+      if (!ok)
+        break;
+      readerSend(ReaderSelectCC, sizeof(ReaderSelectCC));
+      break;
+
+    case 2:
+      if (!ok)
+        break;
+      apdu[0] = 0x00;
+      apdu[1] = 0xB0;
+      apdu[2] = 0x00;
+      apdu[3] = 0x00;
+      apdu[4] = 0x0F;
+      readerSend(apdu, 5);
+      break;
+
+    case 3:
+      if (!ok || (length != 15 + 2)) {
+        ok = false;
+        break;
+      }
+      this->_readerMLe = (rsp[3] << 8) | rsp[4];
+      memcpy(apdu, ReaderSelectCC, sizeof(ReaderSelectCC));
+      apdu[5] = rsp[9];
+      apdu[6] = rsp[10];
+      readerSend(apdu, sizeof(ReaderSelectCC));
+      break;
+
+    case 4:
+      if (!ok)
+        break;
+      apdu[0] = 0x00;
+      apdu[1] = 0xB0;
+      apdu[2] = 0x00;
+      apdu[3] = 0x00;
+      apdu[4] = 0x02;
+      readerSend(apdu, 5);
+      break;
+
+    case 5:
+      if (!ok || (length != 2 + 2)) {
+        ok = false;
+        break;
+      }
+      this->_readerNdefSize = (rsp[0] << 8) | rsp[1];
+      this->_readerNdefPtr = 0;
+      if ((this->_readerNdefSize == 0) || (this->_readerNdefSize > this->_readerBufferSize)) {
+        ok = false;
+        break;
+      }
+      break;
+
+    default:
+      if (!ok || (this->_readerNdefPtr + length - 2 > this->_readerBufferSize)) {
+        ok = false;
+        break;
+      }
+      memcpy(&this->_readerBuffer[this->_readerNdefPtr], rsp, length - 2);
+      this->_readerNdefPtr += length - 2;
+      break;
+  }
+
+  /* Like a phone, start the procedure again from the application selection before giving up */
+  if ((this->_readerStep > 0) && !ok) {
+    if (this->_readerRestarts++ < READER_MAX_RETRIES) {
+      readerSend(ReaderSelectApp, sizeof(ReaderSelectApp));
+      this->_readerStep = 1;
+    } else {
+      readerLeave();
+    }
+    return;
+  }
+
+  /* Read the NDEF message in chunks after its length */
+  if (this->_readerStep >= 5) {
+    uint16_t remaining = this->_readerNdefSize - this->_readerNdefPtr;
+    uint16_t chunk = (this->_readerMLe > READER_MAX_READ) ? READER_MAX_READ : this->_readerMLe;
+
+    if (remaining == 0) {
+      this->_readerReceived = this->_readerNdefSize;
+      readerLeave();
+      return;
+    }
+    apdu[0] = 0x00;
+    apdu[1] = 0xB0;
+    apdu[2] = (this->_readerNdefPtr + 2) >> 8;
+    apdu[3] = (this->_readerNdefPtr + 2) & 0xFF;
+    apdu[4] = (remaining > chunk) ? chunk : remaining;
+    readerSend(apdu, 5);
+  }
+  this->_readerStep++;
+}
+
+void NciSimulator::notify() {
+  if ((this->_irqHandler != NULL) && !this->_frames.isEmpty())
+    this->_irqHandler(this->_irqContext);
+}
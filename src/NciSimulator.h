@@ -0,0 +1,183 @@
+/**
+ * Library to simulate a PN7150 and the tags in its field, so the driver can run without hardware
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciSimulator_H
+#define NciSimulator_H
+
+#include <Arduino.h>
+
+#include "Interface.h"
+#include "ModeTech.h"
+#include "NciRingBuffer.h"
+#include "NciTransport.h"
+#include "Protocol.h"
+#include "Tech.h"
+
+/*
+ * Number of virtual tags that can be in the field at the same time, the discovery
+ * notifications of all of them must fit in the frame ring
+ */
+#ifndef NCI_SIMULATOR_MAX_TAGS
+#define NCI_SIMULATOR_MAX_TAGS 3
+#endif
+
+#define NCI_SIMULATOR_CONFIG_SIZE 128  // Bytes kept for the TLVs written with CORE_SET_CONFIG
+
+/*
+ * Bytes of a chained data packet put back together or split, extended APDUs need more
+ */
+#ifndef NCI_SIMULATOR_DATA_SIZE
+#define NCI_SIMULATOR_DATA_SIZE 512
+#endif
+
+/*
+ * Longest READ BINARY answer and UPDATE BINARY data of the Type 4 Tags, given in their CC file.
+ * The default ones are those of a MIFARE DESFire EV1, above 255 the tags take extended APDUs
+ */
+#ifndef NCI_SIMULATOR_T4T_MLE
+#define NCI_SIMULATOR_T4T_MLE 0x003B
+#endif
+#ifndef NCI_SIMULATOR_T4T_MLC
+#define NCI_SIMULATOR_T4T_MLC 0x0034
+#endif
+
+/*
+ * A tag in the field of the simulator. The memory is owned by the application and its
+ * layout depends on the protocol:
+ *   PROT_T2T      : raw memory from block 0, the capability container is block 3, sectors of 1024 bytes follow each other
+ *   PROT_ISODEP   : content of the NDEF file (2 bytes length + message), CC file is generated
+ *   PROT_MIFARE   : raw MIFARE Classic 1K memory, 64 blocks of 16 bytes
+ *   PROT_T3T      : attribute information block followed by the NDEF blocks, 16 bytes each
+ *   PROT_ISO15693 : raw memory, blocks of 4 bytes
+ * Use NciSimulator::formatTag() to build a valid layout around a NDEF message.
+ */
+typedef struct {
+  uint8_t protocol;
+  uint8_t uid[8];  // NFCID1 (4 or 7 bytes), NFCID2 (8 bytes) or ISO15693 UID (8 bytes, LSB first)
+  uint8_t uidLength;
+  uint8_t *memory;
+  uint16_t memorySize;
+  uint16_t presenceChecks;  // The tag leaves the field after answering this many presence checks, 0 to stay
+  const uint8_t *version;   // PROT_T2T: answer to GET_VERSION (8 bytes) of a tag with FAST_READ, NULL if it has neither
+} NciVirtualTag;
+
+class NciSimulator : public NciTransport {
+ private:
+  typedef enum {
+    STATE_OFF,
+    STATE_IDLE,
+    STATE_DISCOVERY,
+    STATE_W4_HOST_SELECT,
+    STATE_POLL_ACTIVE,
+    STATE_LISTEN_ACTIVE,
+    STATE_SLEEP
+  } State_t;
+
+  NciRingBuffer _frames;  // frames waiting to be read by the driver
+  State_t _state;
+  bool _ven;
+  uint8_t _maxDataPayload;
+  NciVirtualTag *_tags[NCI_SIMULATOR_MAX_TAGS];
+  uint8_t _tagCount;
+  uint8_t _activeTag;
+  uint16_t _presenceLeft[NCI_SIMULATOR_MAX_TAGS];
+  uint8_t _pollTechs;  // bit per technology requested in RF_DISCOVER_CMD
+  bool _listenRequested;
+  uint8_t _mifareSector;      // sector authenticated on the active MIFARE tag, 0xFF if none
+  uint8_t _mifareWriteBlock;  // block announced by a MIFARE WRITE, 0xFF if none
+  uint8_t _t4tFile;           // 0: none, 1: CC file, 2: NDEF file
+  bool _t2tMuted;             // the active T2T got a command it does not know, silent until activated again
+  uint8_t _t2tSector;         // sector selected on the active T2T
+  bool _t2tSectorSelect;      // first packet of SECTOR_SELECT received, the sector number comes next
+  uint8_t _config[NCI_SIMULATOR_CONFIG_SIZE];
+  uint8_t _configLength;
+  uint8_t _segments[NCI_SIMULATOR_DATA_SIZE];  // data packets received with the PBF bit set
+  uint16_t _segmentsLength;
+  uint8_t _answer[NCI_SIMULATOR_DATA_SIZE];  // answer of the remote device, packets are queued as the driver reads
+  uint16_t _answerLength;
+  uint16_t _answerSent;
+  bool _reader;
+  uint8_t _readerStep;
+  uint8_t _readerApdu[13];
+  uint8_t _readerApduLength;
+  uint8_t _readerRetries;   // retransmissions of the last command
+  uint8_t _readerRestarts;  // times the NDEF read procedure was started again
+  uint16_t _readerMLe;
+  uint16_t _readerNdefSize;
+  uint16_t _readerNdefPtr;
+  uint8_t *_readerBuffer;
+  uint16_t _readerBufferSize;
+  uint16_t _readerReceived;
+  NciTransportIrqHandler_t *_irqHandler;
+  void *_irqContext;
+  uint32_t _droppedFrames;
+
+  void queue(const uint8_t *frame, uint16_t length);
+  void queueControl(uint8_t mt, uint8_t gid, uint8_t oid, const uint8_t *payload, uint8_t length);
+  void queueStatus(uint8_t gid, uint8_t oid, uint8_t status);
+  void queueData(const uint8_t *payload, uint16_t length);
+  void flushData();
+  void queueCredits();
+  void queueActivation(uint8_t index);
+  void queueDiscovery();
+  void queueInterfaceError(uint8_t status);
+  void reset();
+  void startDiscovery(const uint8_t *payload, uint8_t length);
+  bool isTagPolled(uint8_t index) const;
+  bool checkPresence();
+  void removeActiveTag();
+  uint8_t techOf(uint8_t index) const;
+  uint8_t interfaceOf(uint8_t index) const;
+  void setConfig(const uint8_t *payload, uint8_t length);
+  void getConfig(const uint8_t *payload, uint8_t length);
+  void resetConfig();
+  void handleCoreCommand(uint8_t oid, const uint8_t *payload, uint8_t length);
+  void handleRfCommand(uint8_t oid, const uint8_t *payload, uint8_t length);
+  void handlePropCommand(uint8_t oid, const uint8_t *payload, uint8_t length);
+  void handleData(const uint8_t *payload, uint16_t length);
+  uint16_t transceiveT2T(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp);
+  uint16_t transceiveT4T(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp);
+  uint16_t transceiveMifare(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp);
+  uint16_t transceiveT3T(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp);
+  uint16_t transceiveIso15693(NciVirtualTag *tag, const uint8_t *cmd, uint16_t length, uint8_t *rsp);
+  void readerNext(const uint8_t *rsp, uint16_t length);
+  void readerSend(const uint8_t *apdu, uint8_t length);
+  void readerLeave();
+  void notify();
+
+ public:
+  NciSimulator();
+  bool begin();
+  uint8_t writeFrame(const uint8_t *frame, uint16_t length);
+  uint16_t readFrame(uint8_t *frame);
+  bool isIrqActive();
+  bool waitForIrq(unsigned long timeout);
+  bool hasVen() const;
+  void setVen(bool level);
+  bool attachIrqHandler(NciTransportIrqHandler_t *handler, void *context);
+  void detachIrqHandler();
+  void idle(unsigned long timeout);
+
+  bool addTag(NciVirtualTag *tag);
+  bool removeTag(NciVirtualTag *tag);
+  void removeAllTags();
+  uint8_t getTagCount() const;
+  void setMaxDataPayload(uint8_t size);
+  bool addReader(uint8_t *buffer, uint16_t bufferSize);
+  void removeReader();
+  uint16_t getReaderMessageLength() const;
+  uint32_t getDroppedFrames() const;
+  static bool formatTag(NciVirtualTag *tag, const uint8_t *ndef, uint16_t ndefLength);
+};
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ * Library to capture the NCI traffic between the DeviceHost and the PN7150
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciTrace.h"
+
+#include <string.h>
+
+#if !defined(__linux__)
+#include <Arduino.h>
+#endif
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/sync.h>
+#elif defined(ESP32)
+static portMUX_TYPE traceSpinlock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+void NciTrace::encodeHeader(uint8_t *header, uint8_t direction, uint32_t timestamp, uint16_t length) {
+  header[0] = direction;
+  header[1] = timestamp & 0xFF;
+  header[2] = (timestamp >> 8) & 0xFF;
+  header[3] = (timestamp >> 16) & 0xFF;
+  header[4] = (timestamp >> 24) & 0xFF;
+  header[5] = length & 0xFF;
+  header[6] = length >> 8;
+}
+
+uint32_t NciTrace::decode(const uint8_t *data, uint32_t size, uint8_t *direction, uint32_t *timestamp, const uint8_t **frame, uint16_t *length) {
+  uint16_t frameLength;
+
+  if (size < NCI_TRACE_HEADER_SIZE)
+    return 0;
+  if ((data[0] != NCI_TRACE_TX) && (data[0] != NCI_TRACE_RX))
+    return 0;
+
+  frameLength = data[5] | (data[6] << 8);
+  if (size - NCI_TRACE_HEADER_SIZE < frameLength)
+    return 0;
+
+  *direction = data[0];
+  *timestamp = (uint32_t)data[1] | ((uint32_t)data[2] << 8) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 24);
+  *frame = &data[NCI_TRACE_HEADER_SIZE];
+  *length = frameLength;
+  return NCI_TRACE_HEADER_SIZE + frameLength;
+}
+
+NciTraceBuffer::NciTraceBuffer(uint8_t *buffer, uint32_t size) : _buffer(buffer), _size(size) {
+  this->_head = 0;
+  this->_tail = 0;
+  this->_used = 0;
+  this->_droppedRecords = 0;
+#if defined(__linux__)
+  pthread_mutex_init(&_mutex, NULL);
+#else
+  this->_interruptState = 0;
+#endif
+}
+
+NciTraceBuffer::~NciTraceBuffer() {
+#if defined(__linux__)
+  pthread_mutex_destroy(&_mutex);
+#endif
+}
+
+/// @brief Records come from the main context and from the IRQ handler (ISR or host thread). The interrupts are
+/// masked and the mask is put back as it was by unlock(), so a caller which had them disabled keeps them disabled
+void NciTraceBuffer::lock() {
+#if defined(__linux__)
+  pthread_mutex_lock(&_mutex);
+#elif defined(ARDUINO_ARCH_AVR)
+  uint8_t state = SREG;
+  cli();
+  this->_interruptState = state;  // stored once masked, an interrupt recording now cannot overwrite it
+#elif defined(ARDUINO_ARCH_RP2040)
+  uint32_t state = save_and_disable_interrupts();
+  this->_interruptState = state;
+#elif defined(ESP32)
+  portENTER_CRITICAL_SAFE(&traceSpinlock);  // nests and works from an ISR, on both cores
+#elif defined(ESP8266)
+  uint32_t state = xt_rsil(15);
+  this->_interruptState = state;
+#elif defined(__arm__)
+  uint32_t state = __get_PRIMASK();
+  __disable_irq();
+  this->_interruptState = state;
+#else
+  noInterrupts();  // the mask cannot be read on this core, unlock() enables the interrupts
+#endif
+}
+
+void NciTraceBuffer::unlock() {
+#if defined(__linux__)
+  pthread_mutex_unlock(&_mutex);
+#elif defined(ARDUINO_ARCH_AVR)
+  SREG = (uint8_t)this->_interruptState;
+#elif defined(ARDUINO_ARCH_RP2040)
+  restore_interrupts(this->_interruptState);
+#elif defined(ESP32)
+  portEXIT_CRITICAL_SAFE(&traceSpinlock);
+#elif defined(ESP8266)
+  xt_wsr_ps(this->_interruptState);
+#elif defined(__arm__)
+  __set_PRIMASK(this->_interruptState);
+#else
+  interrupts();
+#endif
+}
+
+void NciTraceBuffer::put(const uint8_t *data, uint32_t length) {
+  uint32_t first = _size - _head;
+
+  if (first > length)
+    first = length;
+  memcpy(&_buffer[_head], data, first);
+  memcpy(_buffer, &data[first], length - first);
+  _head = (_head + length) % _size;
+  _used += length;
+}
+
+void NciTraceBuffer::get(uint32_t offset, uint8_t *data, uint32_t length) const {
+  uint32_t first = _size - offset;
+
+  if (first > length)
+    first = length;
+  memcpy(data, &_buffer[offset], first);
+  memcpy(&data[first], _buffer, length - first);
+}
+
+uint32_t NciTraceBuffer::recordSizeAt(uint32_t offset) const {
+  uint8_t header[NCI_TRACE_HEADER_SIZE];
+
+  get(offset, header, sizeof(header));
+  return NCI_TRACE_HEADER_SIZE + (header[5] | (header[6] << 8));
+}
+
+void NciTraceBuffer::record(uint8_t direction, uint32_t timestamp, const uint8_t *frame, uint16_t length) {
+  uint8_t header[NCI_TRACE_HEADER_SIZE];
+  uint32_t needed = NCI_TRACE_HEADER_SIZE + length;
+
+  if ((_buffer == NULL) || (needed > _size)) {
+    _droppedRecords++;
+    return;
+  }
+
+  encodeHeader(header, direction, timestamp, length);
+  lock();
+  /* Make room by dropping the oldest records */
+  while (_size - _used < needed) {
+    uint32_t oldest = recordSizeAt(_tail);
+    _tail = (_tail + oldest) % _size;
+    _used -= oldest;
+    _droppedRecords++;
+  }
+  put(header, sizeof(header));
+  put(frame, length);
+  unlock();
+}
+
+uint32_t NciTraceBuffer::available() const {
+  return _used;
+}
+
+uint32_t NciTraceBuffer::read(uint8_t *data, uint32_t size) {
+  uint32_t copied = 0;
+
+  lock();
+  while (_used > 0) {
+    uint32_t length = recordSizeAt(_tail);
+    if (copied + length > size)
+      break;
+    get(_tail, &data[copied], length);
+    copied += length;
+    _tail = (_tail + length) % _size;
+    _used -= length;
+  }
+  unlock();
+  return copied;
+}
+
+void NciTraceBuffer::clear() {
+  lock();
+  _tail = _head;
+  _used = 0;
+  unlock();
+}
+
+uint32_t NciTraceBuffer::getDroppedRecords() const {
+  return _droppedRecords;
+}
+
+#if defined(__linux__)
+
+NciTraceFile::NciTraceFile() {
+  this->_file = NULL;
+  pthread_mutex_init(&_mutex, NULL);
+}
+
+NciTraceFile::~NciTraceFile() {
+  close();
+  pthread_mutex_destroy(&_mutex);
+}
+
+bool NciTraceFile::open(const char *path, bool append) {
+  close();
+  _file = fopen(path, append ? "ab" : "wb");
+  return _file != NULL;
+}
+
+void NciTraceFile::close() {
+  pthread_mutex_lock(&_mutex);
+  if (_file != NULL)
+    fclose(_file);
+  _file = NULL;
+  pthread_mutex_unlock(&_mutex);
+}
+
+void NciTraceFile::flush() {
+  pthread_mutex_lock(&_mutex);
+  if (_file != NULL)
+    fflush(_file);
+  pthread_mutex_unlock(&_mutex);
+}
+
+void NciTraceFile::record(uint8_t direction, uint32_t timestamp, const uint8_t *frame, uint16_t length) {
+  uint8_t header[NCI_TRACE_HEADER_SIZE];
+
+  encodeHeader(header, direction, timestamp, length);
+  pthread_mutex_lock(&_mutex);
+  if (_file != NULL) {
+    fwrite(header, 1, sizeof(header), _file);
+    fwrite(frame, 1, length, _file);
+  }
+  pthread_mutex_unlock(&_mutex);
+}
+
+uint32_t NciTraceFile::load(const char *path, uint8_t *buffer, uint32_t size) {
+  FILE *file = fopen(path, "rb");
+  size_t length;
+
+  if (file == NULL)
+    return 0;
+  length = fread(buffer, 1, size, file);
+  if (fgetc(file) != EOF)
+    length = 0;  // does not fit
+  fclose(file);
+  return length;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * Library to capture the NCI traffic between the DeviceHost and the PN7150
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciTrace_H
+#define NciTrace_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <stdio.h>
+#endif
+
+/*
+ * Binary trace format, a sequence of records with no file header:
+ *   direction (1 byte)    : NCI_TRACE_TX or NCI_TRACE_RX
+ *   timestamp (4 bytes)   : micros() when the frame was written or read, little endian
+ *   length    (2 bytes)   : length of the frame, little endian
+ *   frame     (length)    : raw NCI frame as seen on the bus
+ */
+#define NCI_TRACE_TX 'W'  // DeviceHost to PN7150
+#define NCI_TRACE_RX 'R'  // PN7150 to DeviceHost
+#define NCI_TRACE_HEADER_SIZE 7
+
+class NciTrace {
+ public:
+  virtual ~NciTrace() {}
+
+  // Append one frame, called by the driver on every writeData() and readData(). Must not block
+  virtual void record(uint8_t direction, uint32_t timestamp, const uint8_t *frame, uint16_t length) = 0;
+
+  static void encodeHeader(uint8_t *header, uint8_t direction, uint32_t timestamp, uint16_t length);
+  // Decode the record at the start of data, returns its total size or 0 if it is truncated or invalid
+  static uint32_t decode(const uint8_t *data, uint32_t size, uint8_t *direction, uint32_t *timestamp, const uint8_t **frame, uint16_t *length);
+};
+
+/*
+ * Keeps the last records in a buffer provided by the application, the oldest records are
+ * dropped to make room. Safe to record from the IRQ handler.
+ */
+class NciTraceBuffer : public NciTrace {
+ private:
+  uint8_t *_buffer;
+  uint32_t _size;
+  uint32_t _head;  // next byte to write
+  uint32_t _tail;  // first byte of the oldest record
+  uint32_t _used;
+  uint32_t _droppedRecords;
+#if defined(__linux__)
+  pthread_mutex_t _mutex;
+#else
+  uint32_t _interruptState;  // interrupt mask before lock(), put back by unlock()
+#endif
+  void lock();
+  void unlock();
+  void put(const uint8_t *data, uint32_t length);
+  void get(uint32_t offset, uint8_t *data, uint32_t length) const;
+  uint32_t recordSizeAt(uint32_t offset) const;
+
+ public:
+  NciTraceBuffer(uint8_t *buffer, uint32_t size);
+  ~NciTraceBuffer();
+  void record(uint8_t direction, uint32_t timestamp, const uint8_t *frame, uint16_t length);
+  uint32_t available() const;                   // bytes of trace in the buffer
+  uint32_t read(uint8_t *data, uint32_t size);  // move out as many whole records as fit, returns the bytes copied
+  void clear();
+  uint32_t getDroppedRecords() const;
+};
+
+#if defined(__linux__)
+/*
+ * Appends the records to a file on the host. Writes go through the stdio buffer so the
+ * driver never waits for the disk.
+ */
+class NciTraceFile : public NciTrace {
+ private:
+  FILE *_file;
+  pthread_mutex_t _mutex;
+
+ public:
+  NciTraceFile();
+  ~NciTraceFile();
+  bool open(const char *path, bool append = false);
+  void close();
+  void flush();
+  void record(uint8_t direction, uint32_t timestamp, const uint8_t *frame, uint16_t length);
+  // Read a whole trace file into buffer, returns its length or 0 if it does not fit
+  static uint32_t load(const char *path, uint8_t *buffer, uint32_t size);
+};
+#endif
+
+#endif
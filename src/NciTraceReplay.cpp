@@ -0,0 +1,131 @@
+/**
+ * Library to feed a recorded NCI trace back through the driver
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NciTraceReplay.h"
+
+#include <Arduino.h>
+
+NciTraceReplay::NciTraceReplay(const uint8_t *trace, uint32_t length) : _trace(trace), _length(length) {
+  rewind();
+}
+
+bool NciTraceReplay::begin() {
+  return _trace != NULL;
+}
+
+/// @brief Start again from the first record and clear the counters
+void NciTraceReplay::rewind() {
+  uint8_t direction;
+  const uint8_t *frame;
+  uint16_t length;
+
+  this->_position = 0;
+  this->_mismatches = 0;
+  this->_skippedFrames = 0;
+  this->_firstTimestamp = 0;
+  if ((_trace == NULL) || !NciTrace::decode(_trace, _length, &direction, &_firstTimestamp, &frame, &length))
+    this->_length = 0;
+  this->_lastTimestamp = this->_firstTimestamp;
+}
+
+/// @brief Decode the record at the current position without consuming it
+bool NciTraceReplay::next(uint8_t *direction, const uint8_t **frame, uint16_t *length, uint32_t *recordSize) {
+  if (_position >= _length)
+    return false;
+
+  *recordSize = NciTrace::decode(&_trace[_position], _length - _position, direction, &_nextTimestamp, frame, length);
+  if (*recordSize == 0) {
+    _position = _length;  // truncated or corrupted, nothing after it can be trusted
+    return false;
+  }
+  return true;
+}
+
+/// @brief Consume the next recorded write, received frames the driver did not read before writing are skipped
+uint8_t NciTraceReplay::writeFrame(const uint8_t *frame, uint16_t length) {
+  uint8_t direction;
+  const uint8_t *recorded;
+  uint16_t recordedLength;
+  uint32_t recordSize;
+
+  while (next(&direction, &recorded, &recordedLength, &recordSize)) {
+    _position += recordSize;
+    _lastTimestamp = _nextTimestamp;
+    if (direction == NCI_TRACE_TX) {
+      if ((recordedLength != length) || memcmp(recorded, frame, length))
+        _mismatches++;
+      return 0;
+    }
+    _skippedFrames++;
+  }
+
+  _mismatches++;  // the driver goes further than the trace
+  return 0;
+}
+
+uint16_t NciTraceReplay::readFrame(uint8_t *frame) {
+  uint8_t direction;
+  const uint8_t *recorded;
+  uint16_t length;
+  uint32_t recordSize;
+
+  if (!next(&direction, &recorded, &length, &recordSize) || (direction != NCI_TRACE_RX))
+    return 0;
+
+  memcpy(frame, recorded, length);
+  _position += recordSize;
+  _lastTimestamp = _nextTimestamp;
+  return length;
+}
+
+bool NciTraceReplay::isIrqActive() {
+  uint8_t direction;
+  const uint8_t *frame;
+  uint16_t length;
+  uint32_t recordSize;
+
+  return next(&direction, &frame, &length, &recordSize) && (direction == NCI_TRACE_RX);
+}
+
+/// @brief A frame is either there or it never came in the recording, in which case the driver timed out as well
+bool NciTraceReplay::waitForIrq(unsigned long timeout) {
+  if (isIrqActive())
+    return true;
+
+  delay(timeout);
+  return false;
+}
+
+bool NciTraceReplay::hasVen() const {
+  return false;
+}
+
+void NciTraceReplay::setVen(bool level) {
+  (void)level;
+}
+
+bool NciTraceReplay::isFinished() const {
+  return _position >= _length;
+}
+
+uint32_t NciTraceReplay::getMismatches() const {
+  return _mismatches;
+}
+
+uint32_t NciTraceReplay::getSkippedFrames() const {
+  return _skippedFrames;
+}
+
+uint32_t NciTraceReplay::getRecordedTime() const {
+  return _lastTimestamp - _firstTimestamp;
+}
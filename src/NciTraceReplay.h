@@ -0,0 +1,55 @@
+/**
+ * Library to feed a recorded NCI trace back through the driver
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciTraceReplay_H
+#define NciTraceReplay_H
+
+#include "NciTrace.h"
+#include "NciTransport.h"
+
+/*
+ * Transport that plays the PN7150 side of a trace recorded with NciTraceBuffer or
+ * NciTraceFile. Received frames are delivered as soon as the driver asks for them, so
+ * the driver runs at full speed and the recorded timestamps are only reported.
+ * Frames written by the driver are checked against the recorded ones.
+ */
+class NciTraceReplay : public NciTransport {
+ private:
+  const uint8_t *_trace;
+  uint32_t _length;
+  uint32_t _position;
+  uint32_t _firstTimestamp;
+  uint32_t _lastTimestamp;
+  uint32_t _nextTimestamp;  // timestamp of the record decoded by next()
+  uint32_t _mismatches;
+  uint32_t _skippedFrames;
+  bool next(uint8_t *direction, const uint8_t **frame, uint16_t *length, uint32_t *recordSize);
+
+ public:
+  NciTraceReplay(const uint8_t *trace, uint32_t length);
+  bool begin();
+  uint8_t writeFrame(const uint8_t *frame, uint16_t length);
+  uint16_t readFrame(uint8_t *frame);
+  bool isIrqActive();
+  bool waitForIrq(unsigned long timeout);
+  bool hasVen() const;
+  void setVen(bool level);
+
+  void rewind();
+  bool isFinished() const;
+  uint32_t getMismatches() const;     // frames written by the driver that differ from the trace
+  uint32_t getSkippedFrames() const;  // received frames the driver never read
+  uint32_t getRecordedTime() const;   // us between the first record and the last one replayed
+};
+
+#endif
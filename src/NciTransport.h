@@ -0,0 +1,58 @@
+/**
+ * Interface between the NCI driver and the bus/pins wired to the NFC controller
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NciTransport_H
+#define NciTransport_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void NciTransportIrqHandler_t(void *context);
+
+class NciTransport {
+ public:
+  virtual ~NciTransport() {}
+
+  // Open the bus, returns true on success
+  virtual bool begin() = 0;
+  // Send one NCI frame, returns 0 on success (same codes as Wire::endTransmission())
+  virtual uint8_t writeFrame(const uint8_t *frame, uint16_t length) = 0;
+  // Read one NCI frame into a buffer of at least 258 bytes, returns its length or 0 if none is ready
+  virtual uint16_t readFrame(uint8_t *frame) = 0;
+  // The controller drives IRQ high while it has a frame for the host
+  virtual bool isIrqActive() = 0;
+  // Block until IRQ is active or the timeout (ms) expires, returns isIrqActive()
+  virtual bool waitForIrq(unsigned long timeout) = 0;
+
+  virtual bool hasVen() const = 0;
+  virtual void setVen(bool level) = 0;
+
+  // Call handler on every IRQ rising edge, returns false if not supported
+  virtual bool attachIrqHandler(NciTransportIrqHandler_t *handler, void *context) {
+    (void)handler;
+    (void)context;
+    return false;
+  }
+  virtual void detachIrqHandler() {}
+  // true if the handler runs in its own thread and may use the bus, false if it runs in an ISR
+  virtual bool isIrqHandlerThreaded() const { return false; }
+  // Give the CPU away for at most timeout ms while waiting for the IRQ handler
+  virtual void idle(unsigned long timeout) { (void)timeout; }
+  // The driver took a frame the IRQ handler queued, a threaded handler waiting for room can run again
+  virtual void resumeIrqHandler() {}
+  // Around the driver state a threaded IRQ handler updates too (trace, metrics)
+  virtual void lock() {}
+  virtual void unlock() {}
+};
+
+#endif
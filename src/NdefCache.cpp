@@ -0,0 +1,104 @@
+/**
+ * Library to keep the last NDEF message read from each tag
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "NdefCache.h"
+
+#include <string.h>
+
+NdefCache::NdefCache() {
+  clear();
+}
+
+NdefCache::Entry *NdefCache::find(const uint8_t *uid, uint8_t uidLength) {
+  for (uint8_t i = 0; i < NDEF_CACHE_ENTRIES; i++) {
+    if ((entries[i].uidLength == uidLength) && !memcmp(entries[i].uid, uid, uidLength))
+      return &entries[i];
+  }
+  return NULL;
+}
+
+/// @brief Cached message of the tag if its indicator did not change
+/// @param message receives the message, at least size bytes
+/// @return length of the message, 0 if it must be read from the tag
+uint16_t NdefCache::lookup(const uint8_t *uid, uint8_t uidLength, const uint8_t *indicator, uint8_t indicatorLength, uint8_t *message, uint16_t size) {
+  Entry *entry = (uidLength != 0) ? find(uid, uidLength) : NULL;
+
+  if ((entry == NULL) || (entry->indicatorLength != indicatorLength) || memcmp(entry->indicator, indicator, indicatorLength) ||
+      (entry->messageLength > size)) {
+    misses++;
+    return 0;
+  }
+
+  memcpy(message, entry->message, entry->messageLength);
+  entry->lastUse = ++useCount;
+  hits++;
+  return entry->messageLength;
+}
+
+/// @return false if the message or the UID is too long or empty
+bool NdefCache::store(const uint8_t *uid, uint8_t uidLength, const uint8_t *indicator, uint8_t indicatorLength, const uint8_t *message, uint16_t messageLength) {
+  Entry *entry;
+
+  if ((uidLength == 0) || (uidLength > NDEF_CACHE_UID_SIZE) || (indicatorLength > NDEF_CACHE_INDICATOR_SIZE) ||
+      (messageLength == 0) || (messageLength > NDEF_CACHE_MESSAGE_SIZE)) {
+    remove(uid, uidLength);
+    return false;
+  }
+
+  entry = find(uid, uidLength);
+  if (entry == NULL) {
+    /* Unused entries have the lowest lastUse */
+    entry = &entries[0];
+    for (uint8_t i = 1; i < NDEF_CACHE_ENTRIES; i++) {
+      if (entries[i].lastUse < entry->lastUse)
+        entry = &entries[i];
+    }
+  }
+
+  memcpy(entry->uid, uid, uidLength);
+  entry->uidLength = uidLength;
+  memcpy(entry->indicator, indicator, indicatorLength);
+  entry->indicatorLength = indicatorLength;
+  memcpy(entry->message, message, messageLength);
+  entry->messageLength = messageLength;
+  entry->lastUse = ++useCount;
+  return true;
+}
+
+/// @brief Forget the tag, to be called when its message is written
+void NdefCache::remove(const uint8_t *uid, uint8_t uidLength) {
+  Entry *entry = (uidLength != 0) ? find(uid, uidLength) : NULL;
+
+  if (entry != NULL) {
+    entry->uidLength = 0;
+    entry->lastUse = 0;
+  }
+}
+
+void NdefCache::clear() {
+  for (uint8_t i = 0; i < NDEF_CACHE_ENTRIES; i++) {
+    entries[i].uidLength = 0;
+    entries[i].lastUse = 0;
+  }
+  this->useCount = 0;
+  this->hits = 0;
+  this->misses = 0;
+}
+
+uint32_t NdefCache::getHits() const {
+  return hits;
+}
+
+uint32_t NdefCache::getMisses() const {
+  return misses;
+}
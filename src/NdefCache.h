@@ -0,0 +1,71 @@
+/**
+ * Library to keep the last NDEF message read from each tag
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef NdefCache_H
+#define NdefCache_H
+
+#include <stdint.h>
+
+/*
+ * Number of tags kept, the least recently used one is replaced by a new tag
+ */
+#ifndef NDEF_CACHE_ENTRIES
+#define NDEF_CACHE_ENTRIES 4
+#endif
+
+/*
+ * Longest message kept, longer ones are read from the tag every time
+ */
+#ifndef NDEF_CACHE_MESSAGE_SIZE
+#define NDEF_CACHE_MESSAGE_SIZE 128
+#endif
+
+#define NDEF_CACHE_UID_SIZE 10
+#define NDEF_CACHE_INDICATOR_SIZE 16
+
+/*
+ * Maps the UID of a tag to its NDEF message and to a change indicator, the first bytes read
+ * from the tag: T2T capability container and first data blocks, T4T NDEF length, MIFARE
+ * block 4. The reader compares the indicator read with a single command to the cached one
+ * and reads the message only when they differ. A message rewritten elsewhere with the same
+ * first bytes, or the same length on a T4T, keeps the indicator and is not detected, the
+ * cache only fits tags that no other device writes.
+ */
+class NdefCache {
+ private:
+  struct Entry {
+    uint8_t uid[NDEF_CACHE_UID_SIZE];
+    uint8_t uidLength;  // 0 if unused
+    uint8_t indicator[NDEF_CACHE_INDICATOR_SIZE];
+    uint8_t indicatorLength;
+    uint8_t message[NDEF_CACHE_MESSAGE_SIZE];
+    uint16_t messageLength;
+    uint32_t lastUse;
+  };
+  Entry entries[NDEF_CACHE_ENTRIES];
+  uint32_t useCount;
+  uint32_t hits;
+  uint32_t misses;
+  Entry *find(const uint8_t *uid, uint8_t uidLength);
+
+ public:
+  NdefCache();
+  uint16_t lookup(const uint8_t *uid, uint8_t uidLength, const uint8_t *indicator, uint8_t indicatorLength, uint8_t *message, uint16_t size);
+  bool store(const uint8_t *uid, uint8_t uidLength, const uint8_t *indicator, uint8_t indicatorLength, const uint8_t *message, uint16_t messageLength);
+  void remove(const uint8_t *uid, uint8_t uidLength);
+  void clear();
+  uint32_t getHits() const;
+  uint32_t getMisses() const;
+};
+
+#endif
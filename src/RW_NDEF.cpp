@@ -27,6 +27,11 @@ typedef void RW_NDEF_Fct_t(unsigned char *pCmd, unsigned short Cmd_size, unsigne
 
 unsigned char *pRW_NdefMessage;
 unsigned short RW_NdefMessage_size;
+bool RW_NdefDifferential = false;
+unsigned short RW_NdefApduSize = RW_NDEF_SHORT_APDU_SIZE;
+unsigned char *pRW_NdefBuffer = NdefBuffer;
+unsigned short RW_NdefBuffer_size = RW_MAX_NDEF_FILE_SIZE;
+bool RW_NdefReActivate = false;
 
 RW_NDEF_Callback_t *pRW_NDEF_PullCb;
 RW_NDEF_Callback_t *pRW_NDEF_PushCb;
@@ -36,8 +41,15 @@ CustomCallback_t *ndefReceivedCallback;
 static RW_NDEF_Fct_t *pReadFct = NULL;
 static RW_NDEF_Fct_t *pWriteFct = NULL;
 
+/* Cache of the tag being read, and the change indicator read from it */
+static NdefCache *pRW_NDEF_Cache = NULL;
+static unsigned char RW_NDEF_CacheUid[NDEF_CACHE_UID_SIZE];
+static unsigned char RW_NDEF_CacheUid_size = 0;
+static unsigned char RW_NDEF_CacheIndicator[NDEF_CACHE_INDICATOR_SIZE];
+static unsigned char RW_NDEF_CacheIndicator_size = 0;
+
 bool RW_NDEF_SetMessage(unsigned char *pMessage, unsigned short Message_size, void *pCb) {
-  if (Message_size <= RW_MAX_NDEF_FILE_SIZE) {
+  if (Message_size <= RW_NdefBuffer_size) {
     pRW_NdefMessage = pMessage;
     RW_NdefMessage_size = Message_size;
     pRW_NDEF_PushCb = (RW_NDEF_Callback_t *)pCb;
@@ -49,6 +61,27 @@ bool RW_NDEF_SetMessage(unsigned char *pMessage, unsigned short Message_size, vo
   }
 }
 
+/* Only write what differs from the message on the tag (T2T pages, T4T byte ranges) */
+void RW_NDEF_SetDifferential(bool Enable) {
+  RW_NdefDifferential = Enable;
+}
+
+/* Largest command or answer of a T4T exchange, buffers of the caller */
+void RW_NDEF_SetApduSize(unsigned short Size) {
+  RW_NdefApduSize = Size;
+}
+
+/* Buffer the messages are read into, from the next read on. NULL goes back to NdefBuffer */
+void RW_NDEF_SetBuffer(unsigned char *pBuffer, unsigned short Buffer_size) {
+  if ((pBuffer != NULL) && (Buffer_size != 0)) {
+    pRW_NdefBuffer = pBuffer;
+    RW_NdefBuffer_size = Buffer_size;
+  } else {
+    pRW_NdefBuffer = NdefBuffer;
+    RW_NdefBuffer_size = RW_MAX_NDEF_FILE_SIZE;
+  }
+}
+
 void RW_NDEF_RegisterPullCallback(void *pCb) {
   pRW_NDEF_PullCb = (RW_NDEF_Callback_t *)pCb;
 }
@@ -61,9 +94,34 @@ void registerNdefReceivedCallback(CustomCallback_t function) {
   ndefReceivedCallback = function;
 }
 
+void RW_NDEF_SetCache(NdefCache *pCache, const unsigned char *pUid, unsigned char Uid_size) {
+  pRW_NDEF_Cache = (Uid_size <= NDEF_CACHE_UID_SIZE) ? pCache : NULL;
+  RW_NDEF_CacheUid_size = (pRW_NDEF_Cache != NULL) ? Uid_size : 0;
+  if (RW_NDEF_CacheUid_size != 0)  // pUid may be NULL when the cache is disabled
+    memcpy(RW_NDEF_CacheUid, pUid, RW_NDEF_CacheUid_size);
+  RW_NDEF_CacheIndicator_size = 0;
+}
+
+/* Cached message of the tag if the indicator did not change, 0 if it must be read */
+unsigned short RW_NDEF_CacheProbe(const unsigned char *pIndicator, unsigned char Indicator_size, unsigned char *pMessage) {
+  if ((pRW_NDEF_Cache == NULL) || (Indicator_size > NDEF_CACHE_INDICATOR_SIZE))
+    return 0;
+
+  memcpy(RW_NDEF_CacheIndicator, pIndicator, Indicator_size);
+  RW_NDEF_CacheIndicator_size = Indicator_size;
+  return pRW_NDEF_Cache->lookup(RW_NDEF_CacheUid, RW_NDEF_CacheUid_size, pIndicator, Indicator_size, pMessage, RW_NdefBuffer_size);
+}
+
+/* Message read in full, kept with the indicator of the probe */
+void RW_NDEF_CacheStore(const unsigned char *pMessage, unsigned short Message_size) {
+  if ((pRW_NDEF_Cache != NULL) && (RW_NDEF_CacheIndicator_size != 0))
+    pRW_NDEF_Cache->store(RW_NDEF_CacheUid, RW_NDEF_CacheUid_size, RW_NDEF_CacheIndicator, RW_NDEF_CacheIndicator_size, pMessage, Message_size);
+}
+
 void RW_NDEF_Reset(unsigned char type) {
   pReadFct = NULL;
   pWriteFct = NULL;
+  RW_NdefReActivate = false;
 
   switch (type) {
     case RW_NDEF_TYPE_T1T:
@@ -94,6 +152,11 @@ void RW_NDEF_Reset(unsigned char type) {
   }
 }
 
+/* A tag was activated, what was learnt from the previous one is forgotten */
+void RW_NDEF_Activated(void) {
+  RW_NDEF_T2T_Activated();
+}
+
 void RW_NDEF_Read_Next(unsigned char *pCmd, unsigned short Cmd_size, unsigned char *Rsp, unsigned short *pRsp_size) {
   if (pReadFct != NULL)
     pReadFct(pCmd, Cmd_size, Rsp, pRsp_size);
@@ -13,10 +13,19 @@
  */
 #include <Arduino.h>
 
+#include "NdefCache.h"
+
+/* Largest NDEF message read into NdefBuffer, a Type 2 Tag of 2 KB needs 2048. The Arduino IDE does not pass
+ * defines to the library, its sketches give a larger buffer with RW_NDEF_SetBuffer() instead */
+#ifndef RW_MAX_NDEF_FILE_SIZE
 #define RW_MAX_NDEF_FILE_SIZE 500
+#endif
 
 extern unsigned char NdefBuffer[RW_MAX_NDEF_FILE_SIZE];
 
+/* Largest short APDU: header, Lc = 255, data and Le. With larger buffers a T4T may be sent extended APDUs */
+#define RW_NDEF_SHORT_APDU_SIZE 261
+
 typedef void RW_NDEF_Callback_t(unsigned char *, unsigned short);
 typedef void CustomCallback_t(void);
 
@@ -28,6 +37,11 @@ typedef void CustomCallback_t(void);
 
 extern unsigned char *pRW_NdefMessage;
 extern unsigned short RW_NdefMessage_size;
+extern bool RW_NdefDifferential;
+extern unsigned short RW_NdefApduSize;
+extern unsigned char *pRW_NdefBuffer;
+extern unsigned short RW_NdefBuffer_size;
+extern bool RW_NdefReActivate;  // set by a reader when the tag must be activated again before its next command
 
 extern RW_NDEF_Callback_t *pRW_NDEF_PullCb;
 extern RW_NDEF_Callback_t *pRW_NDEF_PushCb;
@@ -35,9 +49,16 @@ extern RW_NDEF_Callback_t *updateNdefMessageCallback;
 extern CustomCallback_t *ndefReceivedCallback;
 
 void RW_NDEF_Reset(unsigned char type);
+void RW_NDEF_Activated(void);
 void RW_NDEF_Read_Next(unsigned char *pCmd, unsigned short Cmd_size, unsigned char *Rsp, unsigned short *pRsp_size);
 void RW_NDEF_Write_Next(unsigned char *pCmd, unsigned short Cmd_size, unsigned char *Rsp, unsigned short *pRsp_size);
 bool RW_NDEF_SetMessage(unsigned char *pMessage, unsigned short Message_size, void *pCb);
+void RW_NDEF_SetDifferential(bool Enable);
+void RW_NDEF_SetApduSize(unsigned short Size);
+void RW_NDEF_SetBuffer(unsigned char *pBuffer, unsigned short Buffer_size);
 void RW_NDEF_RegisterPullCallback(void *pCb);
 void registerUpdateNdefMessageCallback(RW_NDEF_Callback_t function);
 void registerNdefReceivedCallback(CustomCallback_t function);
+void RW_NDEF_SetCache(NdefCache *pCache, const unsigned char *pUid, unsigned char Uid_size);
+unsigned short RW_NDEF_CacheProbe(const unsigned char *pIndicator, unsigned char Indicator_size, unsigned char *pMessage);
+void RW_NDEF_CacheStore(const unsigned char *pMessage, unsigned short Message_size);
@@ -52,7 +52,7 @@ static RW_NDEF_MIFARE_Ndef_t RW_NDEF_MIFARE_Ndef;
 
 void RW_NDEF_MIFARE_Reset(void) {
   eRW_NDEF_MIFARE_State = Initial;
-  RW_NDEF_MIFARE_Ndef.pMessage = NdefBuffer;
+  RW_NDEF_MIFARE_Ndef.pMessage = pRW_NdefBuffer;
 }
 
 void RW_NDEF_MIFARE_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigned char *pCmd, unsigned short *pCmd_size) {
@@ -116,6 +116,25 @@ void RW_NDEF_MIFARE_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsi
     case Reading_FirstBlk:
       if ((Rsp_size == 18) && (pRsp[Rsp_size - 1] == 0x00)) {
         unsigned char Tmp = 1;
+
+        /* Is the first block the same as the last time ? */
+        RW_NDEF_MIFARE_Ndef.MessageSize = RW_NDEF_CacheProbe(pRsp + 1, 16, RW_NDEF_MIFARE_Ndef.pMessage);
+        if (RW_NDEF_MIFARE_Ndef.MessageSize != 0) {
+          if (pRW_NDEF_PullCb != NULL) {
+            pRW_NDEF_PullCb(RW_NDEF_MIFARE_Ndef.pMessage, RW_NDEF_MIFARE_Ndef.MessageSize);
+          }
+
+          // Run custom callbacks
+          if (updateNdefMessageCallback != NULL) {
+            updateNdefMessageCallback(RW_NDEF_MIFARE_Ndef.pMessage, RW_NDEF_MIFARE_Ndef.MessageSize);
+          }
+
+          if (ndefReceivedCallback != NULL) {
+            ndefReceivedCallback();
+          }
+          break;
+        }
+
         /* If not NDEF Type skip TLV */
         while (pRsp[Tmp] != MIFARE_NDEF_TLV) {
           Tmp += 2 + pRsp[Tmp + 1];
@@ -130,7 +149,7 @@ void RW_NDEF_MIFARE_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsi
           RW_NDEF_MIFARE_Ndef.MessageSize = pRsp[Tmp + 1];
 
         /* If provisioned buffer is not large enough or message is empty, notify the application and stop reading */
-        if ((RW_NDEF_MIFARE_Ndef.MessageSize > RW_MAX_NDEF_FILE_SIZE) || (RW_NDEF_MIFARE_Ndef.MessageSize == 0)) {
+        if ((RW_NDEF_MIFARE_Ndef.MessageSize > RW_NdefBuffer_size) || (RW_NDEF_MIFARE_Ndef.MessageSize == 0)) {
           if (pRW_NDEF_PullCb != NULL)
             pRW_NDEF_PullCb(NULL, 0);
 
@@ -149,6 +168,7 @@ void RW_NDEF_MIFARE_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsi
         /* Is NDEF read already completed ? */
         if (RW_NDEF_MIFARE_Ndef.MessageSize <= ((Rsp_size - 1) - Tmp - 2)) {
           memcpy(RW_NDEF_MIFARE_Ndef.pMessage, &pRsp[Tmp + 2], RW_NDEF_MIFARE_Ndef.MessageSize);
+          RW_NDEF_CacheStore(RW_NDEF_MIFARE_Ndef.pMessage, RW_NDEF_MIFARE_Ndef.MessageSize);
 
           /* Notify application of the NDEF reception */
           if (pRW_NDEF_PullCb != NULL) {
@@ -183,6 +203,7 @@ void RW_NDEF_MIFARE_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsi
         /* Is NDEF read already completed ? */
         if ((RW_NDEF_MIFARE_Ndef.MessageSize - RW_NDEF_MIFARE_Ndef.MessagePtr) < 16) {
           memcpy(&RW_NDEF_MIFARE_Ndef.pMessage[RW_NDEF_MIFARE_Ndef.MessagePtr], pRsp + 1, RW_NDEF_MIFARE_Ndef.MessageSize - RW_NDEF_MIFARE_Ndef.MessagePtr);
+          RW_NDEF_CacheStore(RW_NDEF_MIFARE_Ndef.pMessage, RW_NDEF_MIFARE_Ndef.MessageSize);
 
           /* Notify application of the NDEF reception */
           if (pRW_NDEF_PullCb != NULL) {
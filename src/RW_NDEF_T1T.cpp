@@ -47,7 +47,7 @@ static RW_NDEF_T1T_Ndef_t RW_NDEF_T1T_Ndef;
 
 void RW_NDEF_T1T_Reset(void) {
   eRW_NDEF_T1T_State = Initial;
-  RW_NDEF_T1T_Ndef.pMessage = NdefBuffer;
+  RW_NDEF_T1T_Ndef.pMessage = pRW_NdefBuffer;
 }
 
 void RW_NDEF_T1T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigned char *pCmd, unsigned short *pCmd_size) {
@@ -97,7 +97,7 @@ void RW_NDEF_T1T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
           data_size = (Rsp_size - 1) - 16 - Tmp - 2;
 
           /* If provisioned buffer is not large enough, notify the application and stop reading */
-          if (RW_NDEF_T1T_Ndef.MessageSize > RW_MAX_NDEF_FILE_SIZE) {
+          if (RW_NDEF_T1T_Ndef.MessageSize > RW_NdefBuffer_size) {
             if (pRW_NDEF_PullCb != NULL)
               pRW_NDEF_PullCb(NULL, 0);
             break;
@@ -17,33 +17,295 @@
 #include "RW_NDEF.h"
 #include "tool.h"
 
-/* TODO: No support for tag larger than 1024 bytes (requiring SECTOR_SELECT command use) */
+/* Tags larger than 1024 bytes are split in sectors of 256 pages, selected with SECTOR_SELECT.
+ * The data area is addressed as if the sectors followed each other. */
 
 #define T2T_MAGIC_NUMBER 0xE1
 #define T2T_NDEF_TLV 0x03
+#define T2T_ACK 0x0A
+#define T2T_RF_TIMEOUT 0xB2  // CORE_INTERFACE_ERROR_NTF status, the passive ACK of SECTOR_SELECT
+
+/* Pages read by one FAST_READ, the answer and its status fit in a NCI data packet. 0 to only use READ */
+#ifndef RW_NDEF_T2T_FAST_READ_PAGES
+#define RW_NDEF_T2T_FAST_READ_PAGES 60
+#endif
+
+/* Data area above which the tag is asked for its version: the smaller Ultralight C does not have GET_VERSION */
+#define T2T_FAST_READ_MIN_DATA_SIZE 144
+#define T2T_VENDOR_NXP 0x04
+#define T2T_TYPE_ULTRALIGHT 0x03  // Ultralight EV1
+#define T2T_TYPE_NTAG 0x04
 
 typedef enum {
   Initial,
   Reading_CC,
   Reading_Data,
+  Reading_Version,
   Reading_NDEF,
-  Writing_Data
+  Fast_Reading_NDEF,
+  Writing_Data,
+  Diff_Reading,      // pages read to be compared with the message
+  Diff_Writing,      // a page which differs is written
+  Clearing_Header,   // the page of the NDEF TLV with L = 0, before the first page which differs
+  Writing_Header,    // the page of the NDEF TLV, written last
+  Selecting_Sector,  // first command of SECTOR_SELECT sent
+  Sector_Selected    // second command sent, the tag answers by staying silent
 } RW_NDEF_T2T_state_t;
 
 typedef struct
 {
-  unsigned char BlkNb;
+  unsigned short BlkNb;        // page, sector included
+  unsigned char BlkCount;     // pages asked by the last FAST_READ
+  unsigned char Sector;       // selected on the tag
+  RW_NDEF_T2T_state_t Resume;  // once the sector is selected, Initial when done
+  unsigned short OldBlkNb;     // first of the 4 pages in Old
+  unsigned char Old[16];       // pages read from the tag by a differential write
+  unsigned char Header[4];     // page of the NDEF TLV of the message
+  bool HeaderChanged;          // it differs from the tag
+  bool Cleared;                // L = 0 is on the tag, the header must be written last
+  unsigned short DataSize;    // from the CC
   unsigned short MessagePtr;
   unsigned short MessageSize;
   unsigned char *pMessage;
 } RW_NDEF_T2T_Ndef_t;
 
+/* Answer to GET_VERSION of the activated tag, asked once per activation */
+typedef enum {
+  Version_Unknown,
+  Version_Fast_Read,  // NTAG or Ultralight EV1
+  Version_Read_Only   // other tag, or no GET_VERSION
+} RW_NDEF_T2T_version_t;
+
 static RW_NDEF_T2T_state_t eRW_NDEF_T2T_State = Initial;
 static RW_NDEF_T2T_Ndef_t RW_NDEF_T2T_Ndef;
+static RW_NDEF_T2T_version_t eRW_NDEF_T2T_Version = Version_Unknown;
+
+void RW_NDEF_T2T_Activated(void) {
+  eRW_NDEF_T2T_Version = Version_Unknown;
+}
 
 void RW_NDEF_T2T_Reset(void) {
   eRW_NDEF_T2T_State = Initial;
-  RW_NDEF_T2T_Ndef.pMessage = NdefBuffer;
+  RW_NDEF_T2T_Ndef.pMessage = pRW_NdefBuffer;
+  RW_NDEF_T2T_Ndef.Sector = 0;  // after the activation
+}
+
+/* First command of SECTOR_SELECT if the sector is not the selected one, then the state machine goes on with Resume */
+static bool RW_NDEF_T2T_Select_Sector(unsigned char Sector, RW_NDEF_T2T_state_t Resume, unsigned char *pCmd, unsigned short *pCmd_size) {
+  if (Sector == RW_NDEF_T2T_Ndef.Sector)
+    return false;
+
+  RW_NDEF_T2T_Ndef.Sector = Sector;
+  RW_NDEF_T2T_Ndef.Resume = Resume;
+  pCmd[0] = 0xC2;
+  pCmd[1] = 0xFF;
+  *pCmd_size = 2;
+  eRW_NDEF_T2T_State = Selecting_Sector;
+  return true;
+}
+
+/* READ of the next 4 pages, or FAST_READ of the pages left up to RW_NDEF_T2T_FAST_READ_PAGES */
+static void RW_NDEF_T2T_Read_Blocks(bool Fast, unsigned char *pCmd, unsigned short *pCmd_size) {
+  unsigned short Left = RW_NDEF_T2T_Ndef.MessageSize - RW_NDEF_T2T_Ndef.MessagePtr;
+  unsigned short Pages = (Left + 3) / 4;
+
+  if (RW_NDEF_T2T_Select_Sector(RW_NDEF_T2T_Ndef.BlkNb >> 8, Fast ? Fast_Reading_NDEF : Reading_NDEF, pCmd, pCmd_size))
+    return;
+
+  if (Fast) {
+    /* A range does not cross the end of the sector */
+    if (Pages > RW_NDEF_T2T_FAST_READ_PAGES)
+      Pages = RW_NDEF_T2T_FAST_READ_PAGES;
+    if (Pages > 256 - (RW_NDEF_T2T_Ndef.BlkNb & 0xFF))
+      Pages = 256 - (RW_NDEF_T2T_Ndef.BlkNb & 0xFF);
+    RW_NDEF_T2T_Ndef.BlkCount = Pages;
+    pCmd[0] = 0x3A;
+    pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb & 0xFF;
+    pCmd[2] = (RW_NDEF_T2T_Ndef.BlkNb + RW_NDEF_T2T_Ndef.BlkCount - 1) & 0xFF;
+    *pCmd_size = 3;
+    eRW_NDEF_T2T_State = Fast_Reading_NDEF;
+  } else {
+    pCmd[0] = 0x30;
+    pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb & 0xFF;
+    *pCmd_size = 2;
+    eRW_NDEF_T2T_State = Reading_NDEF;
+  }
+}
+
+/* WRITE of the next page of the message */
+static void RW_NDEF_T2T_Write_Block(unsigned char *pCmd, unsigned short *pCmd_size) {
+  if (RW_NDEF_T2T_Select_Sector(RW_NDEF_T2T_Ndef.BlkNb >> 8, Writing_Data, pCmd, pCmd_size))
+    return;
+
+  pCmd[0] = 0xA2;
+  pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb & 0xFF;
+  memcpy(&pCmd[2], pRW_NdefMessage + RW_NDEF_T2T_Ndef.MessagePtr, 4);
+  *pCmd_size = 6;
+  eRW_NDEF_T2T_State = Writing_Data;
+
+  RW_NDEF_T2T_Ndef.MessagePtr += 4;
+  RW_NDEF_T2T_Ndef.BlkNb++;
+}
+
+/* Once the message is read or written, the sector of the CC is selected again for the next operation */
+static void RW_NDEF_T2T_Leave_Sector(unsigned char *pCmd, unsigned short *pCmd_size) {
+  (void)RW_NDEF_T2T_Select_Sector(0, Initial, pCmd, pCmd_size);
+}
+
+/* Byte of the data area as written: NDEF TLV from page 4 then the message */
+static unsigned char RW_NDEF_T2T_Area(unsigned short Offset) {
+  unsigned char HeaderSize = (RW_NdefMessage_size >= 0xFF) ? 4 : 2;
+
+  if (Offset == 0)
+    return T2T_NDEF_TLV;
+  if (HeaderSize == 2)
+    return (Offset == 1) ? (unsigned char)RW_NdefMessage_size : pRW_NdefMessage[Offset - 2];
+  if (Offset == 1)
+    return 0xFF;
+  if (Offset == 2)
+    return RW_NdefMessage_size >> 8;
+  if (Offset == 3)
+    return RW_NdefMessage_size & 0xFF;
+  return pRW_NdefMessage[Offset - 4];
+}
+
+/* READ of the 4 pages from OldBlkNb */
+static void RW_NDEF_T2T_Diff_Read(unsigned char *pCmd, unsigned short *pCmd_size) {
+  if (RW_NDEF_T2T_Select_Sector(RW_NDEF_T2T_Ndef.OldBlkNb >> 8, Diff_Reading, pCmd, pCmd_size))
+    return;
+
+  pCmd[0] = 0x30;
+  pCmd[1] = RW_NDEF_T2T_Ndef.OldBlkNb & 0xFF;
+  *pCmd_size = 2;
+  eRW_NDEF_T2T_State = Diff_Reading;
+}
+
+/* WRITE of the NDEF TLV page with L = 0, a write torn after it leaves an empty message rather than a mixed one */
+static void RW_NDEF_T2T_Clear_Header(unsigned char *pCmd, unsigned short *pCmd_size) {
+  if (RW_NDEF_T2T_Select_Sector(0, Clearing_Header, pCmd, pCmd_size))
+    return;
+
+  pCmd[0] = 0xA2;
+  pCmd[1] = 0x04;
+  memcpy(&pCmd[2], RW_NDEF_T2T_Ndef.Header, 4);
+  pCmd[3] = 0x00;
+  *pCmd_size = 6;
+  RW_NDEF_T2T_Ndef.Cleared = true;
+  eRW_NDEF_T2T_State = Clearing_Header;
+}
+
+/* WRITE of the NDEF TLV page, once the rest of the message is on the tag */
+static void RW_NDEF_T2T_Write_Header(unsigned char *pCmd, unsigned short *pCmd_size) {
+  if (RW_NDEF_T2T_Select_Sector(0, Writing_Header, pCmd, pCmd_size))
+    return;
+
+  pCmd[0] = 0xA2;
+  pCmd[1] = 0x04;
+  memcpy(&pCmd[2], RW_NDEF_T2T_Ndef.Header, 4);
+  *pCmd_size = 6;
+  eRW_NDEF_T2T_State = Writing_Header;
+}
+
+/* Next page of the message which differs from the tag, the pages are read 4 at a time to be compared.
+ * The bytes of the last page after the message keep what the tag holds */
+static void RW_NDEF_T2T_Diff_Next(unsigned char *pCmd, unsigned short *pCmd_size) {
+  unsigned short AreaSize = RW_NdefMessage_size + ((RW_NdefMessage_size >= 0xFF) ? 4 : 2);
+  unsigned char Page[4];
+  unsigned char *pOld;
+  unsigned char i;
+
+  while (RW_NDEF_T2T_Ndef.BlkNb < 4 + (AreaSize + 3) / 4) {
+    if (RW_NDEF_T2T_Ndef.BlkNb >= RW_NDEF_T2T_Ndef.OldBlkNb + 4) {
+      RW_NDEF_T2T_Ndef.OldBlkNb = RW_NDEF_T2T_Ndef.BlkNb;
+      RW_NDEF_T2T_Diff_Read(pCmd, pCmd_size);
+      return;
+    }
+
+    pOld = &RW_NDEF_T2T_Ndef.Old[(RW_NDEF_T2T_Ndef.BlkNb - RW_NDEF_T2T_Ndef.OldBlkNb) * 4];
+    for (i = 0; i < 4; i++) {
+      unsigned short Offset = (RW_NDEF_T2T_Ndef.BlkNb - 4) * 4 + i;
+      Page[i] = (Offset < AreaSize) ? RW_NDEF_T2T_Area(Offset) : pOld[i];
+    }
+
+    if (RW_NDEF_T2T_Ndef.BlkNb == 4) {
+      memcpy(RW_NDEF_T2T_Ndef.Header, Page, 4);
+      RW_NDEF_T2T_Ndef.HeaderChanged = (memcmp(Page, pOld, 4) != 0);
+    } else if (memcmp(Page, pOld, 4)) {
+      if (!RW_NDEF_T2T_Ndef.Cleared) {
+        RW_NDEF_T2T_Clear_Header(pCmd, pCmd_size);
+        return;
+      }
+      if (RW_NDEF_T2T_Select_Sector(RW_NDEF_T2T_Ndef.BlkNb >> 8, Diff_Writing, pCmd, pCmd_size))
+        return;
+      pCmd[0] = 0xA2;
+      pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb & 0xFF;
+      memcpy(&pCmd[2], Page, 4);
+      *pCmd_size = 6;
+      eRW_NDEF_T2T_State = Diff_Writing;
+      RW_NDEF_T2T_Ndef.BlkNb++;
+      return;
+    }
+    RW_NDEF_T2T_Ndef.BlkNb++;
+  }
+
+  /* The NDEF TLV is the page a reader checks first, the message behind it is complete */
+  if (RW_NDEF_T2T_Ndef.HeaderChanged || RW_NDEF_T2T_Ndef.Cleared) {
+    RW_NDEF_T2T_Write_Header(pCmd, pCmd_size);
+    return;
+  }
+
+  /* Notify application of the NDEF send completion */
+  if (pRW_NDEF_PushCb != NULL)
+    pRW_NDEF_PushCb(pRW_NdefMessage, RW_NdefMessage_size);
+  RW_NDEF_T2T_Leave_Sector(pCmd, pCmd_size);
+}
+
+/* Second command of SECTOR_SELECT, then the command which needed the sector */
+static void RW_NDEF_T2T_Sector_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigned char *pCmd, unsigned short *pCmd_size) {
+  switch (eRW_NDEF_T2T_State) {
+    case Selecting_Sector:
+      if ((Rsp_size == 2) && (pRsp[0] == T2T_ACK) && (pRsp[1] == 0x00)) {
+        pCmd[0] = RW_NDEF_T2T_Ndef.Sector;
+        pCmd[1] = 0x00;
+        pCmd[2] = 0x00;
+        pCmd[3] = 0x00;
+        *pCmd_size = 4;
+        eRW_NDEF_T2T_State = Sector_Selected;
+      }
+      break;
+
+    case Sector_Selected:
+      /* A NAK would be answered */
+      if ((Rsp_size == 2) && (pRsp[0] == T2T_RF_TIMEOUT)) {
+        switch (RW_NDEF_T2T_Ndef.Resume) {
+          case Reading_NDEF:
+          case Fast_Reading_NDEF:
+            RW_NDEF_T2T_Read_Blocks(RW_NDEF_T2T_Ndef.Resume == Fast_Reading_NDEF, pCmd, pCmd_size);
+            break;
+          case Writing_Data:
+            RW_NDEF_T2T_Write_Block(pCmd, pCmd_size);
+            break;
+          case Diff_Reading:
+            RW_NDEF_T2T_Diff_Read(pCmd, pCmd_size);
+            break;
+          case Diff_Writing:
+            RW_NDEF_T2T_Diff_Next(pCmd, pCmd_size);
+            break;
+          case Clearing_Header:
+            RW_NDEF_T2T_Clear_Header(pCmd, pCmd_size);
+            break;
+          case Writing_Header:
+            RW_NDEF_T2T_Write_Header(pCmd, pCmd_size);
+            break;
+          default:
+            break;
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
 }
 
 void RW_NDEF_T2T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigned char *pCmd, unsigned short *pCmd_size) {
@@ -62,6 +324,16 @@ void RW_NDEF_T2T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
     case Reading_CC:
       /* Is CC Read and Is Ndef ?*/
       if ((Rsp_size == 17) && (pRsp[Rsp_size - 1] == 0x00) && (pRsp[0] == T2T_MAGIC_NUMBER)) {
+        RW_NDEF_T2T_Ndef.DataSize = pRsp[2] * 8;
+
+        /* Are CC and first data the same as the last time ? */
+        RW_NDEF_T2T_Ndef.MessageSize = RW_NDEF_CacheProbe(pRsp, 16, RW_NDEF_T2T_Ndef.pMessage);
+        if (RW_NDEF_T2T_Ndef.MessageSize != 0) {
+          if (pRW_NDEF_PullCb != NULL)
+            pRW_NDEF_PullCb(RW_NDEF_T2T_Ndef.pMessage, RW_NDEF_T2T_Ndef.MessageSize);
+          break;
+        }
+
         /* Read First data */
         pCmd[0] = 0x30;
         pCmd[1] = 0x04;
@@ -89,7 +361,7 @@ void RW_NDEF_T2T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
           RW_NDEF_T2T_Ndef.MessageSize = pRsp[Tmp + 1];
 
         /* If provisioned buffer is not large enough or message is empty, notify the application and stop reading */
-        if ((RW_NDEF_T2T_Ndef.MessageSize > RW_MAX_NDEF_FILE_SIZE) || (RW_NDEF_T2T_Ndef.MessageSize == 0)) {
+        if ((RW_NDEF_T2T_Ndef.MessageSize > RW_NdefBuffer_size) || (RW_NDEF_T2T_Ndef.MessageSize == 0)) {
           if (pRW_NDEF_PullCb != NULL)
             pRW_NDEF_PullCb(NULL, 0);
           break;
@@ -98,6 +370,7 @@ void RW_NDEF_T2T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
         /* Is NDEF read already completed ? */
         if (RW_NDEF_T2T_Ndef.MessageSize <= ((Rsp_size - 1) - Tmp - 2)) {
           memcpy(RW_NDEF_T2T_Ndef.pMessage, &pRsp[Tmp + 2], RW_NDEF_T2T_Ndef.MessageSize);
+          RW_NDEF_CacheStore(RW_NDEF_T2T_Ndef.pMessage, RW_NDEF_T2T_Ndef.MessageSize);
 
           /* Notify application of the NDEF reception */
           if (pRW_NDEF_PullCb != NULL)
@@ -107,38 +380,88 @@ void RW_NDEF_T2T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
           memcpy(RW_NDEF_T2T_Ndef.pMessage, &pRsp[Tmp + 2], RW_NDEF_T2T_Ndef.MessagePtr);
           RW_NDEF_T2T_Ndef.BlkNb = 8;
 
-          /* Read NDEF content */
-          pCmd[0] = 0x30;
-          pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb;
-          *pCmd_size = 2;
-          eRW_NDEF_T2T_State = Reading_NDEF;
+          /* Several READ left, is FAST_READ supported ? */
+          if ((RW_NDEF_T2T_FAST_READ_PAGES > 4) && (RW_NDEF_T2T_Ndef.DataSize > T2T_FAST_READ_MIN_DATA_SIZE) &&
+              (RW_NDEF_T2T_Ndef.MessageSize - RW_NDEF_T2T_Ndef.MessagePtr > 16) && (eRW_NDEF_T2T_Version == Version_Unknown)) {
+            pCmd[0] = 0x60;
+            *pCmd_size = 1;
+            eRW_NDEF_T2T_State = Reading_Version;
+          } else {
+            /* Read NDEF content */
+            RW_NDEF_T2T_Read_Blocks(eRW_NDEF_T2T_Version == Version_Fast_Read, pCmd, pCmd_size);
+          }
         }
       }
       break;
 
+    case Reading_Version:
+      /* NTAG and Ultralight EV1 have FAST_READ, the others are read block by block */
+      if ((Rsp_size == 9) && (pRsp[Rsp_size - 1] == 0x00)) {
+        if ((pRsp[1] == T2T_VENDOR_NXP) && ((pRsp[2] == T2T_TYPE_NTAG) || (pRsp[2] == T2T_TYPE_ULTRALIGHT)))
+          eRW_NDEF_T2T_Version = Version_Fast_Read;
+        else
+          eRW_NDEF_T2T_Version = Version_Read_Only;
+      } else {
+        /* The tag went back to IDLE on the unknown command, it must be activated again before the next READ */
+        eRW_NDEF_T2T_Version = Version_Read_Only;
+        RW_NdefReActivate = true;
+      }
+      RW_NDEF_T2T_Read_Blocks(eRW_NDEF_T2T_Version == Version_Fast_Read, pCmd, pCmd_size);
+      break;
+
     case Reading_NDEF:
       /* Is Read success ?*/
       if ((Rsp_size == 17) && (pRsp[Rsp_size - 1] == 0x00)) {
         /* Is NDEF read already completed ? */
         if ((RW_NDEF_T2T_Ndef.MessageSize - RW_NDEF_T2T_Ndef.MessagePtr) < 16) {
           memcpy(&RW_NDEF_T2T_Ndef.pMessage[RW_NDEF_T2T_Ndef.MessagePtr], pRsp, RW_NDEF_T2T_Ndef.MessageSize - RW_NDEF_T2T_Ndef.MessagePtr);
+          RW_NDEF_CacheStore(RW_NDEF_T2T_Ndef.pMessage, RW_NDEF_T2T_Ndef.MessageSize);
 
           /* Notify application of the NDEF reception */
           if (pRW_NDEF_PullCb != NULL)
             pRW_NDEF_PullCb(RW_NDEF_T2T_Ndef.pMessage, RW_NDEF_T2T_Ndef.MessageSize);
+          RW_NDEF_T2T_Leave_Sector(pCmd, pCmd_size);
         } else {
           memcpy(&RW_NDEF_T2T_Ndef.pMessage[RW_NDEF_T2T_Ndef.MessagePtr], pRsp, 16);
           RW_NDEF_T2T_Ndef.MessagePtr += 16;
           RW_NDEF_T2T_Ndef.BlkNb += 4;
 
           /* Read NDEF content */
-          pCmd[0] = 0x30;
-          pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb;
-          *pCmd_size = 2;
+          RW_NDEF_T2T_Read_Blocks(false, pCmd, pCmd_size);
+        }
+      }
+      break;
+
+    case Fast_Reading_NDEF:
+      /* Is Read success ?*/
+      if ((Rsp_size == RW_NDEF_T2T_Ndef.BlkCount * 4 + 1) && (pRsp[Rsp_size - 1] == 0x00)) {
+        unsigned short Left = RW_NDEF_T2T_Ndef.MessageSize - RW_NDEF_T2T_Ndef.MessagePtr;
+
+        /* Is NDEF read already completed ? */
+        if (Left <= RW_NDEF_T2T_Ndef.BlkCount * 4) {
+          memcpy(&RW_NDEF_T2T_Ndef.pMessage[RW_NDEF_T2T_Ndef.MessagePtr], pRsp, Left);
+          RW_NDEF_CacheStore(RW_NDEF_T2T_Ndef.pMessage, RW_NDEF_T2T_Ndef.MessageSize);
+
+          /* Notify application of the NDEF reception */
+          if (pRW_NDEF_PullCb != NULL)
+            pRW_NDEF_PullCb(RW_NDEF_T2T_Ndef.pMessage, RW_NDEF_T2T_Ndef.MessageSize);
+          RW_NDEF_T2T_Leave_Sector(pCmd, pCmd_size);
+        } else {
+          memcpy(&RW_NDEF_T2T_Ndef.pMessage[RW_NDEF_T2T_Ndef.MessagePtr], pRsp, RW_NDEF_T2T_Ndef.BlkCount * 4);
+          RW_NDEF_T2T_Ndef.MessagePtr += RW_NDEF_T2T_Ndef.BlkCount * 4;
+          RW_NDEF_T2T_Ndef.BlkNb += RW_NDEF_T2T_Ndef.BlkCount;
+
+          /* Read NDEF content */
+          RW_NDEF_T2T_Read_Blocks(true, pCmd, pCmd_size);
         }
       }
       break;
 
+    case Selecting_Sector:
+    case Sector_Selected:
+      RW_NDEF_T2T_Sector_Next(pRsp, Rsp_size, pCmd, pCmd_size);
+      break;
+
     default:
       break;
   }
@@ -161,12 +484,19 @@ void RW_NDEF_T2T_Write_Next(unsigned char *pRsp, unsigned short Rsp_size, unsign
       /* Is CC Read, Is Ndef and is R/W ?*/
       if ((Rsp_size == 17) && (pRsp[Rsp_size - 1] == 0x00) && (pRsp[0] == T2T_MAGIC_NUMBER) && (pRsp[3] == 0x00)) {
         /* Is size enough ? */
-        if (pRsp[2] * 8 >= RW_NdefMessage_size) {
+        if ((pRsp[2] * 8 >= RW_NdefMessage_size) && RW_NdefDifferential) {
+          /* Compare the message with the tag, page 4 first */
+          RW_NDEF_T2T_Ndef.BlkNb = 4;
+          RW_NDEF_T2T_Ndef.OldBlkNb = 0;
+          RW_NDEF_T2T_Ndef.HeaderChanged = false;
+          RW_NDEF_T2T_Ndef.Cleared = false;
+          RW_NDEF_T2T_Diff_Next(pCmd, pCmd_size);
+        } else if (pRsp[2] * 8 >= RW_NdefMessage_size) {
           /* Write First data */
           pCmd[0] = 0xA2;
           pCmd[1] = 0x04;
           pCmd[2] = 0x03;
-          if (RW_NdefMessage_size > 0xFF) {
+          if (RW_NdefMessage_size >= 0xFF) {
             pCmd[3] = 0xFF;
             pCmd[4] = (RW_NdefMessage_size & 0xFF00) >> 8;
             pCmd[5] = RW_NdefMessage_size & 0xFF;
@@ -191,19 +521,44 @@ void RW_NDEF_T2T_Write_Next(unsigned char *pRsp, unsigned short Rsp_size, unsign
           /* Notify application of the NDEF send completion */
           if (pRW_NDEF_PushCb != NULL)
             pRW_NDEF_PushCb(pRW_NdefMessage, RW_NdefMessage_size);
+          RW_NDEF_T2T_Leave_Sector(pCmd, pCmd_size);
         } else {
           /* Write NDEF content */
-          pCmd[0] = 0xA2;
-          pCmd[1] = RW_NDEF_T2T_Ndef.BlkNb;
-          memcpy(&pCmd[2], pRW_NdefMessage + RW_NDEF_T2T_Ndef.MessagePtr, 4);
-          *pCmd_size = 6;
-
-          RW_NDEF_T2T_Ndef.MessagePtr += 4;
-          RW_NDEF_T2T_Ndef.BlkNb++;
+          RW_NDEF_T2T_Write_Block(pCmd, pCmd_size);
         }
       }
       break;
 
+    case Diff_Reading:
+      /* Is Read success ?*/
+      if ((Rsp_size == 17) && (pRsp[Rsp_size - 1] == 0x00)) {
+        memcpy(RW_NDEF_T2T_Ndef.Old, pRsp, 16);
+        RW_NDEF_T2T_Diff_Next(pCmd, pCmd_size);
+      }
+      break;
+
+    case Diff_Writing:
+    case Clearing_Header:
+      /* Is Write success ?*/
+      if ((Rsp_size == 2) && (pRsp[Rsp_size - 1] == 0x00))
+        RW_NDEF_T2T_Diff_Next(pCmd, pCmd_size);
+      break;
+
+    case Writing_Header:
+      /* Is Write success ?*/
+      if ((Rsp_size == 2) && (pRsp[Rsp_size - 1] == 0x00)) {
+        /* Notify application of the NDEF send completion */
+        if (pRW_NDEF_PushCb != NULL)
+          pRW_NDEF_PushCb(pRW_NdefMessage, RW_NdefMessage_size);
+        RW_NDEF_T2T_Leave_Sector(pCmd, pCmd_size);
+      }
+      break;
+
+    case Selecting_Sector:
+    case Sector_Selected:
+      RW_NDEF_T2T_Sector_Next(pRsp, Rsp_size, pCmd, pCmd_size);
+      break;
+
     default:
       break;
   }
@@ -41,7 +41,7 @@ static RW_NDEF_T3T_Ndef_t RW_NDEF_T3T_Ndef;
 
 void RW_NDEF_T3T_Reset(void) {
   eRW_NDEF_T3T_State = Initial;
-  RW_NDEF_T3T_Ndef.p = NdefBuffer;
+  RW_NDEF_T3T_Ndef.p = pRW_NdefBuffer;
 }
 
 void RW_NDEF_T3T_SetIDm(unsigned char *pIDm) {
@@ -65,10 +65,10 @@ void RW_NDEF_T3T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
       /* Is Check success ?*/
       if ((pRsp[Rsp_size - 1] == 0x00) && (pRsp[1] == 0x07) && (pRsp[10] == 0x00) && (pRsp[11] == 0x00)) {
         /* Fill File structure */
-        RW_NDEF_T3T_Ndef.Size = (pRsp[24] << 16) + (pRsp[25] << 16) + pRsp[26];
+        RW_NDEF_T3T_Ndef.Size = (pRsp[24] << 16) + (pRsp[25] << 8) + pRsp[26];
 
         /* If provisioned buffer is not large enough or size is null, notify the application and stop reading */
-        if ((RW_NDEF_T3T_Ndef.Size > RW_MAX_NDEF_FILE_SIZE) || (RW_NDEF_T3T_Ndef.Size == 0)) {
+        if ((RW_NDEF_T3T_Ndef.Size > RW_NdefBuffer_size) || (RW_NDEF_T3T_Ndef.Size == 0)) {
           if (pRW_NDEF_PullCb != NULL)
             pRW_NDEF_PullCb(NULL, 0);
           break;
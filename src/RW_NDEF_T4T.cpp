@@ -26,7 +26,8 @@ const unsigned char RW_NDEF_T4T_Write[] = {0x00, 0xD6, 0x00, 0x00, 0x00};
 
 const unsigned char RW_NDEF_T4T_OK[] = {0x90, 0x00};
 
-#define WRITE_SZ 54
+#define T4T_SHORT_APDU_MAX 255  // Lc and Le of a short APDU, larger ones use the extended field coding
+#define T4T_MIN_MLE 0x0F
 
 typedef enum {
   Initial,
@@ -39,7 +40,11 @@ typedef enum {
   Reading_NDEF,
   Writing_NDEF,
   Writing_NDEFsize,
-  Write_NDEFcomplete
+  Write_NDEFcomplete,
+  Diff_Reading_Size,  // length of the message on the tag
+  Diff_Reading,       // part of the file to be compared with the message
+  Diff_Clearing,      // NDEF length set to 0 before the first write
+  Diff_Writing        // range which differs
 } RW_NDEF_T4T_state_t;
 
 typedef struct
@@ -54,6 +59,10 @@ typedef struct
   unsigned short MessagePtr;
   unsigned short MessageSize;
   unsigned char *pMessage;
+  unsigned short OldSize;   // NDEF length found on the tag by a differential write
+  bool Cleared;             // NDEF length set to 0, it is written again at the end
+  unsigned short DiffPtr;   // range of the message to be written
+  unsigned short DiffSize;
 } RW_NDEF_T4T_Ndef_t;
 
 static RW_NDEF_T4T_state_t eRW_NDEF_T4T_State = Initial;
@@ -61,7 +70,100 @@ static RW_NDEF_T4T_Ndef_t RW_NDEF_T4T_Ndef;
 
 void RW_NDEF_T4T_Reset(void) {
   eRW_NDEF_T4T_State = Initial;
-  RW_NDEF_T4T_Ndef.pMessage = NdefBuffer;
+  RW_NDEF_T4T_Ndef.pMessage = pRW_NdefBuffer;
+}
+
+/* Le of a READ BINARY: MLe of the CC, the tags taking more than a short APDU announce it there.
+ * The answer and its status word fit in RW_NdefApduSize, extended only if it is above a short APDU */
+static unsigned short RW_NDEF_T4T_Read_Size(unsigned short Left) {
+  unsigned short Size = RW_NDEF_T4T_Ndef.MLe;
+
+  if (Size > RW_NdefApduSize - 2)
+    Size = RW_NdefApduSize - 2;
+  if ((Size > T4T_SHORT_APDU_MAX) && (RW_NdefApduSize <= RW_NDEF_SHORT_APDU_SIZE))
+    Size = T4T_SHORT_APDU_MAX;
+  return (Left < Size) ? Left : Size;
+}
+
+/* Lc of an UPDATE BINARY: MLc of the CC, the command fits in RW_NdefApduSize as for READ BINARY */
+static unsigned short RW_NDEF_T4T_Write_Size(unsigned short Left) {
+  unsigned short Size = RW_NDEF_T4T_Ndef.MLc;
+
+  if (Size > RW_NdefApduSize - 5)
+    Size = RW_NdefApduSize - 5;
+  if ((Size > T4T_SHORT_APDU_MAX) && (RW_NdefApduSize <= RW_NDEF_SHORT_APDU_SIZE))
+    Size = T4T_SHORT_APDU_MAX;
+  if ((Size > T4T_SHORT_APDU_MAX) && (Size > RW_NdefApduSize - 7))
+    Size = RW_NdefApduSize - 7;  // Extended Lc takes 2 more bytes
+  return (Left < Size) ? Left : Size;
+}
+
+/* READ BINARY of the NDEF file from Offset */
+static void RW_NDEF_T4T_Read_Cmd(unsigned short Offset, unsigned short Size, unsigned char *pCmd, unsigned short *pCmd_size) {
+  memcpy(pCmd, RW_NDEF_T4T_Read, sizeof(RW_NDEF_T4T_Read));
+  pCmd[2] = Offset >> 8;
+  pCmd[3] = Offset & 0xFF;
+  if (Size > T4T_SHORT_APDU_MAX) {
+    pCmd[4] = 0x00;
+    pCmd[5] = Size >> 8;
+    pCmd[6] = Size & 0xFF;
+    *pCmd_size = sizeof(RW_NDEF_T4T_Read) + 2;
+  } else {
+    pCmd[4] = (unsigned char)Size;
+    *pCmd_size = sizeof(RW_NDEF_T4T_Read);
+  }
+}
+
+/* UPDATE BINARY of the NDEF file at Offset */
+static void RW_NDEF_T4T_Write_Cmd(unsigned short Offset, const unsigned char *pData, unsigned short Size, unsigned char *pCmd, unsigned short *pCmd_size) {
+  unsigned char Header = sizeof(RW_NDEF_T4T_Write);
+
+  memcpy(pCmd, RW_NDEF_T4T_Write, sizeof(RW_NDEF_T4T_Write));
+  pCmd[2] = Offset >> 8;
+  pCmd[3] = Offset & 0xFF;
+  if (Size > T4T_SHORT_APDU_MAX) {
+    pCmd[4] = 0x00;
+    pCmd[5] = Size >> 8;
+    pCmd[6] = Size & 0xFF;
+    Header += 2;
+  } else {
+    pCmd[4] = (unsigned char)Size;
+  }
+  memcpy(&pCmd[Header], pData, Size);
+  *pCmd_size = Header + Size;
+}
+
+/* Next part of the file read to be compared with the message, then the NDEF length if it changed */
+static void RW_NDEF_T4T_Diff_Next(unsigned char *pCmd, unsigned short *pCmd_size) {
+  unsigned short Left = RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr;
+
+  if (Left != 0) {
+    /* A range which differs fits in one UPDATE BINARY */
+    RW_NDEF_T4T_Read_Cmd(RW_NDEF_T4T_Ndef.MessagePtr + 2, RW_NDEF_T4T_Read_Size(RW_NDEF_T4T_Write_Size(Left)), pCmd, pCmd_size);
+    eRW_NDEF_T4T_State = Diff_Reading;
+    return;
+  }
+
+  /* The NDEF length is written last, a reader does not see a partial message */
+  if (RW_NDEF_T4T_Ndef.Cleared || (RW_NDEF_T4T_Ndef.OldSize != RW_NdefMessage_size)) {
+    memcpy(pCmd, RW_NDEF_T4T_Write, sizeof(RW_NDEF_T4T_Write));
+    pCmd[4] = 2;
+    pCmd[5] = RW_NdefMessage_size >> 8;
+    pCmd[6] = RW_NdefMessage_size & 0xFF;
+    *pCmd_size = sizeof(RW_NDEF_T4T_Write) + 2;
+    eRW_NDEF_T4T_State = Write_NDEFcomplete;
+    return;
+  }
+
+  /* Notify application of the NDEF send completion */
+  if (pRW_NDEF_PushCb != NULL)
+    pRW_NDEF_PushCb(pRW_NdefMessage, RW_NdefMessage_size);
+}
+
+/* UPDATE BINARY of the range which differs */
+static void RW_NDEF_T4T_Diff_Write(unsigned char *pCmd, unsigned short *pCmd_size) {
+  RW_NDEF_T4T_Write_Cmd(RW_NDEF_T4T_Ndef.DiffPtr + 2, pRW_NdefMessage + RW_NDEF_T4T_Ndef.DiffPtr, RW_NDEF_T4T_Ndef.DiffSize, pCmd, pCmd_size);
+  eRW_NDEF_T4T_State = Diff_Writing;
 }
 
 void RW_NDEF_T4T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigned char *pCmd, unsigned short *pCmd_size) {
@@ -114,7 +216,8 @@ void RW_NDEF_T4T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
 
     case Reading_CC:
       /* Is CC Read ?*/
-      if ((!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) && (Rsp_size == 15 + 2)) {
+      if ((!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) && (Rsp_size == 15 + 2) &&
+          (((pRsp[3] << 8) + pRsp[4]) >= T4T_MIN_MLE) && (((pRsp[5] << 8) + pRsp[6]) != 0)) {
         /* Fill CC structure */
         RW_NDEF_T4T_Ndef.MappingVersion = pRsp[2];
         RW_NDEF_T4T_Ndef.MLe = (pRsp[3] << 8) + pRsp[4];
@@ -152,41 +255,45 @@ void RW_NDEF_T4T_Read_Next(unsigned char *pRsp, unsigned short Rsp_size, unsigne
       if (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) {
         RW_NDEF_T4T_Ndef.MessageSize = (pRsp[0] << 8) + pRsp[1];
 
-        /* If provisioned buffer is not large enough, notify the application and stop reading */
-        if (RW_NDEF_T4T_Ndef.MessageSize > RW_MAX_NDEF_FILE_SIZE) {
+        /* If provisioned buffer is not large enough or the length is not valid, notify the application and stop reading */
+        if ((RW_NDEF_T4T_Ndef.MessageSize > RW_NdefBuffer_size) || (RW_NDEF_T4T_Ndef.MessageSize + 2 > RW_NDEF_T4T_Ndef.MaxNdefFileSize)) {
           if (pRW_NDEF_PullCb != NULL)
             pRW_NDEF_PullCb(NULL, 0);
           break;
         }
 
+        /* Is the length the same as the last time ? */
+        if (RW_NDEF_CacheProbe(pRsp, 2, RW_NDEF_T4T_Ndef.pMessage) != 0) {
+          if (pRW_NDEF_PullCb != NULL)
+            pRW_NDEF_PullCb(RW_NDEF_T4T_Ndef.pMessage, RW_NDEF_T4T_Ndef.MessageSize);
+          break;
+        }
+
         RW_NDEF_T4T_Ndef.MessagePtr = 0;
 
         /* Read NDEF data */
-        memcpy(pCmd, RW_NDEF_T4T_Read, sizeof(RW_NDEF_T4T_Read));
-        pCmd[3] = 2;
-        pCmd[4] = (RW_NDEF_T4T_Ndef.MessageSize > RW_NDEF_T4T_Ndef.MLe - 1) ? RW_NDEF_T4T_Ndef.MLe - 1 : (unsigned char)RW_NDEF_T4T_Ndef.MessageSize;
-        *pCmd_size = sizeof(RW_NDEF_T4T_Read);
+        RW_NDEF_T4T_Read_Cmd(2, RW_NDEF_T4T_Read_Size(RW_NDEF_T4T_Ndef.MessageSize), pCmd, pCmd_size);
         eRW_NDEF_T4T_State = Reading_NDEF;
       }
       break;
 
     case Reading_NDEF:
-      /* Is Read Success ?*/
-      if (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) {
+      /* Is Read Success, and no longer than the rest of the message ?*/
+      if ((Rsp_size > 2) && (Rsp_size - 2 <= RW_NDEF_T4T_Ndef.MessageSize - RW_NDEF_T4T_Ndef.MessagePtr) &&
+          (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK)))) {
         memcpy(&RW_NDEF_T4T_Ndef.pMessage[RW_NDEF_T4T_Ndef.MessagePtr], pRsp, Rsp_size - 2);
         RW_NDEF_T4T_Ndef.MessagePtr += Rsp_size - 2;
 
         /* Is NDEF message read completed ?*/
         if (RW_NDEF_T4T_Ndef.MessagePtr == RW_NDEF_T4T_Ndef.MessageSize) {
+          RW_NDEF_CacheStore(RW_NDEF_T4T_Ndef.pMessage, RW_NDEF_T4T_Ndef.MessageSize);
+
           /* Notify application of the NDEF reception */
           if (pRW_NDEF_PullCb != NULL)
             pRW_NDEF_PullCb(RW_NDEF_T4T_Ndef.pMessage, RW_NDEF_T4T_Ndef.MessageSize);
         } else {
           /* Read NDEF data */
-          memcpy(pCmd, RW_NDEF_T4T_Read, sizeof(RW_NDEF_T4T_Read));
-          pCmd[3] = RW_NDEF_T4T_Ndef.MessagePtr + 2;
-          pCmd[4] = ((RW_NDEF_T4T_Ndef.MessageSize - RW_NDEF_T4T_Ndef.MessagePtr) > RW_NDEF_T4T_Ndef.MLe - 1) ? RW_NDEF_T4T_Ndef.MLe - 1 : (unsigned char)(RW_NDEF_T4T_Ndef.MessageSize - RW_NDEF_T4T_Ndef.MessagePtr);
-          *pCmd_size = sizeof(RW_NDEF_T4T_Read);
+          RW_NDEF_T4T_Read_Cmd(RW_NDEF_T4T_Ndef.MessagePtr + 2, RW_NDEF_T4T_Read_Size(RW_NDEF_T4T_Ndef.MessageSize - RW_NDEF_T4T_Ndef.MessagePtr), pCmd, pCmd_size);
         }
       }
       break;
@@ -246,7 +353,8 @@ void RW_NDEF_T4T_Write_Next(unsigned char *pRsp, unsigned short Rsp_size, unsign
 
     case Reading_CC:
       /* Is CC Read ?*/
-      if ((!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) && (Rsp_size == 15 + 2)) {
+      if ((!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) && (Rsp_size == 15 + 2) &&
+          (((pRsp[3] << 8) + pRsp[4]) >= T4T_MIN_MLE) && (((pRsp[5] << 8) + pRsp[6]) != 0)) {
         /* Fill CC structure */
         RW_NDEF_T4T_Ndef.MappingVersion = pRsp[2];
         RW_NDEF_T4T_Ndef.MLe = (pRsp[3] << 8) + pRsp[4];
@@ -269,16 +377,24 @@ void RW_NDEF_T4T_Write_Next(unsigned char *pRsp, unsigned short Rsp_size, unsign
       break;
 
     case Selecting_NDEF:
-      /* Is NDEF Selected ?*/
-      if (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) {
-        /* Clearing NDEF message size*/
-        memcpy(pCmd, RW_NDEF_T4T_Write, sizeof(RW_NDEF_T4T_Write));
-        pCmd[4] = 2;
-        pCmd[5] = 0;
-        pCmd[6] = 0;
-        *pCmd_size = sizeof(RW_NDEF_T4T_Write) + 2;
-        RW_NDEF_T4T_Ndef.MessagePtr = 0;
-        eRW_NDEF_T4T_State = Writing_NDEF;
+      /* Is NDEF Selected and is size enough ?*/
+      if ((!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) && (RW_NdefMessage_size + 2 <= RW_NDEF_T4T_Ndef.MaxNdefFileSize)) {
+        if (RW_NdefDifferential) {
+          /* Get NDEF file size */
+          memcpy(pCmd, RW_NDEF_T4T_Read, sizeof(RW_NDEF_T4T_Read));
+          *pCmd_size = sizeof(RW_NDEF_T4T_Read);
+          pCmd[4] = 2;
+          eRW_NDEF_T4T_State = Diff_Reading_Size;
+        } else {
+          /* Clearing NDEF message size*/
+          memcpy(pCmd, RW_NDEF_T4T_Write, sizeof(RW_NDEF_T4T_Write));
+          pCmd[4] = 2;
+          pCmd[5] = 0;
+          pCmd[6] = 0;
+          *pCmd_size = sizeof(RW_NDEF_T4T_Write) + 2;
+          RW_NDEF_T4T_Ndef.MessagePtr = 0;
+          eRW_NDEF_T4T_State = Writing_NDEF;
+        }
       }
       break;
 
@@ -286,21 +402,12 @@ void RW_NDEF_T4T_Write_Next(unsigned char *pRsp, unsigned short Rsp_size, unsign
       /* Is Write Success ?*/
       if (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) {
         /* Writing NDEF message */
-        memcpy(pCmd, RW_NDEF_T4T_Write, sizeof(RW_NDEF_T4T_Write));
-        pCmd[2] = (RW_NDEF_T4T_Ndef.MessagePtr + 2) >> 8;
-        pCmd[3] = (RW_NDEF_T4T_Ndef.MessagePtr + 2) & 0xFF;
-        if ((RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr) < WRITE_SZ) {
-          pCmd[4] = (RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr);
-          memcpy(&pCmd[5], pRW_NdefMessage + RW_NDEF_T4T_Ndef.MessagePtr, (RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr));
-          *pCmd_size = sizeof(RW_NDEF_T4T_Write) + (RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr);
+        unsigned short Size = RW_NDEF_T4T_Write_Size(RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr);
+
+        RW_NDEF_T4T_Write_Cmd(RW_NDEF_T4T_Ndef.MessagePtr + 2, pRW_NdefMessage + RW_NDEF_T4T_Ndef.MessagePtr, Size, pCmd, pCmd_size);
+        RW_NDEF_T4T_Ndef.MessagePtr += Size;
+        if (RW_NDEF_T4T_Ndef.MessagePtr == RW_NdefMessage_size)
           eRW_NDEF_T4T_State = Writing_NDEFsize;
-        } else {
-          pCmd[4] = WRITE_SZ;
-          memcpy(&pCmd[5], pRW_NdefMessage + RW_NDEF_T4T_Ndef.MessagePtr, WRITE_SZ);
-          *pCmd_size = sizeof(RW_NDEF_T4T_Write) + WRITE_SZ;
-          RW_NDEF_T4T_Ndef.MessagePtr += WRITE_SZ;
-          eRW_NDEF_T4T_State = Writing_NDEF;
-        }
       }
       break;
 
@@ -325,6 +432,62 @@ void RW_NDEF_T4T_Write_Next(unsigned char *pRsp, unsigned short Rsp_size, unsign
       }
       break;
 
+    case Diff_Reading_Size:
+      /* Is Read Success ?*/
+      if ((!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK))) && (Rsp_size == 2 + 2)) {
+        RW_NDEF_T4T_Ndef.OldSize = (pRsp[0] << 8) + pRsp[1];
+        RW_NDEF_T4T_Ndef.Cleared = false;
+        RW_NDEF_T4T_Ndef.MessagePtr = 0;
+        RW_NDEF_T4T_Diff_Next(pCmd, pCmd_size);
+      }
+      break;
+
+    case Diff_Reading:
+      /* Is Read Success ?*/
+      if ((Rsp_size > 2) && (Rsp_size - 2 <= RW_NdefMessage_size - RW_NDEF_T4T_Ndef.MessagePtr) &&
+          (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK)))) {
+        unsigned char *pNew = pRW_NdefMessage + RW_NDEF_T4T_Ndef.MessagePtr;
+        unsigned short First = 0;
+        unsigned short Last = Rsp_size - 2;
+
+        /* One range from the first to the last byte which differ */
+        while ((First < Last) && (pRsp[First] == pNew[First]))
+          First++;
+        while ((Last > First) && (pRsp[Last - 1] == pNew[Last - 1]))
+          Last--;
+        RW_NDEF_T4T_Ndef.DiffPtr = RW_NDEF_T4T_Ndef.MessagePtr + First;
+        RW_NDEF_T4T_Ndef.DiffSize = Last - First;
+        RW_NDEF_T4T_Ndef.MessagePtr += Rsp_size - 2;
+
+        if (RW_NDEF_T4T_Ndef.DiffSize == 0) {
+          RW_NDEF_T4T_Diff_Next(pCmd, pCmd_size);
+        } else if (!RW_NDEF_T4T_Ndef.Cleared) {
+          /* Clearing NDEF message size*/
+          memcpy(pCmd, RW_NDEF_T4T_Write, sizeof(RW_NDEF_T4T_Write));
+          pCmd[4] = 2;
+          pCmd[5] = 0;
+          pCmd[6] = 0;
+          *pCmd_size = sizeof(RW_NDEF_T4T_Write) + 2;
+          RW_NDEF_T4T_Ndef.Cleared = true;
+          eRW_NDEF_T4T_State = Diff_Clearing;
+        } else {
+          RW_NDEF_T4T_Diff_Write(pCmd, pCmd_size);
+        }
+      }
+      break;
+
+    case Diff_Clearing:
+      /* Is Write Success ?*/
+      if (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK)))
+        RW_NDEF_T4T_Diff_Write(pCmd, pCmd_size);
+      break;
+
+    case Diff_Writing:
+      /* Is Write Success ?*/
+      if (!memcmp(&pRsp[Rsp_size - 2], RW_NDEF_T4T_OK, sizeof(RW_NDEF_T4T_OK)))
+        RW_NDEF_T4T_Diff_Next(pCmd, pCmd_size);
+      break;
+
     default:
       break;
   }
@@ -0,0 +1,225 @@
+/**
+ * NCI transport over the Arduino Wire library and the IRQ/VEN pins
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#include "TwoWireTransport.h"
+
+#define MsgHeaderSize 3
+
+TwoWireTransport *TwoWireTransport::_interruptInstance = NULL;
+
+TwoWireTransport::TwoWireTransport() : _IRQpin(NO_PN7150_RESET_PIN), _VENpin(NO_PN7150_RESET_PIN), _I2Caddress(0), _wire(NULL) {
+  this->_readStrategy = READ_SPLIT;
+  this->_singleReadSize = PN7150_DEFAULT_READ_SIZE;
+  this->_irqHandler = NULL;
+  this->_irqContext = NULL;
+  this->_irqSeen = false;
+}
+
+TwoWireTransport::TwoWireTransport(uint8_t IRQpin, uint8_t VENpin, uint8_t I2Caddress, TwoWire *wire) : _IRQpin(IRQpin), _VENpin(VENpin), _I2Caddress(I2Caddress), _wire(wire) {
+  pinMode(_IRQpin, INPUT);
+  if (_VENpin != NO_PN7150_RESET_PIN)
+    pinMode(_VENpin, OUTPUT);
+
+  this->_readStrategy = READ_SPLIT;
+  this->_singleReadSize = PN7150_DEFAULT_READ_SIZE;
+  this->_irqHandler = NULL;
+  this->_irqContext = NULL;
+  this->_irqSeen = false;
+}
+
+bool TwoWireTransport::begin() {
+  if (_wire == NULL)
+    return false;
+
+  _wire->begin();
+  return true;
+}
+
+uint8_t TwoWireTransport::writeFrame(const uint8_t *frame, uint16_t length) {
+  uint32_t nmbrBytesWritten = 0;
+  _wire->beginTransmission((uint8_t)_I2Caddress);           // configura transmision
+  nmbrBytesWritten = _wire->write(frame, (size_t)(length));  // carga en buffer
+#ifdef DEBUG2
+  Serial.println("[DEBUG] written bytes = 0x" + String(nmbrBytesWritten, HEX));
+#endif
+  if (nmbrBytesWritten == length) {
+    byte resultCode;
+    resultCode = _wire->endTransmission();  // envio de datos segun yo
+#ifdef DEBUG2
+    Serial.println("[DEBUG] write data code = 0x" + String(resultCode, HEX));
+#endif
+    return resultCode;
+  } else {
+    return 4;  // Could not properly copy data to I2C buffer, so treat as other error, see i2c_t3
+  }
+}
+
+uint16_t TwoWireTransport::readFrame(uint8_t *frame) {
+  if (_readStrategy == READ_SINGLE_TRANSACTION)
+    return readFrameSingle(frame);
+  return readFrameSplit(frame);
+}
+
+uint16_t TwoWireTransport::readFrameSplit(uint8_t *rxBuffer) {
+  uint16_t bytesReceived;                                         // keeps track of how many bytes we actually received
+  if (isIrqActive()) {                                            // only try to read something if the PN7150 indicates it has something
+    bytesReceived = _wire->requestFrom(_I2Caddress, (uint8_t)3);  // first reading the header, as this contains how long the payload will be
+#ifdef DEBUG2
+    Serial.println("[DEBUG] bytesReceived = 0x" + String(bytesReceived, HEX));
+#endif
+    rxBuffer[0] = _wire->read();
+    rxBuffer[1] = _wire->read();
+    rxBuffer[2] = _wire->read();
+#ifdef DEBUG2
+    for (int i = 0; i < 3; i++) {
+      Serial.println("[DEBUG] Byte[" + String(i) + "] = 0x" + String(rxBuffer[i], HEX));
+    }
+#endif
+    uint8_t payloadLength = rxBuffer[2];
+    if (payloadLength > 0) {
+      bytesReceived += _wire->requestFrom(_I2Caddress, (uint8_t)payloadLength);  // then reading the payload, if any
+#ifdef DEBUG2
+      Serial.println("[DEBUG] payload bytes = 0x" + String(bytesReceived - 3, HEX));
+#endif
+      uint16_t index = 3;
+      while (index < bytesReceived) {
+        rxBuffer[index] = _wire->read();
+#ifdef DEBUG2
+        Serial.println("[DEBUG] payload[" + String(index) + "] = 0x" + String(rxBuffer[index], HEX));
+#endif
+        index++;
+      }
+    }
+  } else {
+    bytesReceived = 0;
+  }
+  return bytesReceived;
+}
+
+uint16_t TwoWireTransport::readFrameSingle(uint8_t *rxBuffer) {
+  uint16_t bytesReceived;
+  uint16_t frameLength;
+
+  if (!isIrqActive())
+    return 0;
+
+  /* Read header and payload at once, bytes past the end of the frame are padding */
+  bytesReceived = _wire->requestFrom(_I2Caddress, _singleReadSize);
+  if (bytesReceived == 0)
+    return readFrameSplit(rxBuffer);  // the bus refused the long read, nothing was taken from the PN7150
+  if (bytesReceived < MsgHeaderSize)
+    return 0;  // part of the header is consumed, a split read now would take the payload for a header
+
+  rxBuffer[0] = _wire->read();
+  rxBuffer[1] = _wire->read();
+  rxBuffer[2] = _wire->read();
+  frameLength = MsgHeaderSize + rxBuffer[2];
+  if (bytesReceived > frameLength)
+    bytesReceived = frameLength;
+  bytesReceived = MsgHeaderSize + _wire->readBytes(&rxBuffer[MsgHeaderSize], bytesReceived - MsgHeaderSize);
+  while (_wire->available() > 0)
+    _wire->read();  // padding, not left in the Wire buffer for the next read
+
+  /* Frame longer than the read size, get the rest as in split mode */
+  if (bytesReceived < frameLength) {
+    uint8_t remaining = frameLength - bytesReceived;
+    if (_wire->requestFrom(_I2Caddress, remaining) == remaining)
+      bytesReceived += _wire->readBytes(&rxBuffer[bytesReceived], remaining);
+  }
+#ifdef DEBUG2
+  Serial.println("[DEBUG] single read bytes = 0x" + String(bytesReceived, HEX));
+#endif
+  return bytesReceived;
+}
+
+bool TwoWireTransport::isIrqActive() {
+  return (HIGH == digitalRead(_IRQpin));  // PN7150 indicates it has data by driving IRQ signal HIGH
+}
+
+bool TwoWireTransport::waitForIrq(unsigned long timeout) {
+  unsigned long start = millis();
+
+  while (!isIrqActive()) {
+    if ((millis() - start) >= timeout)
+      return false;
+    yield();
+  }
+  return true;
+}
+
+bool TwoWireTransport::hasVen() const {
+  return _VENpin != NO_PN7150_RESET_PIN;
+}
+
+void TwoWireTransport::setVen(bool level) {
+  if (_VENpin != NO_PN7150_RESET_PIN)
+    digitalWrite(_VENpin, level ? HIGH : LOW);
+}
+
+/// @brief Only one TwoWireTransport can have an IRQ handler at a time, the handler runs in interrupt context
+bool TwoWireTransport::attachIrqHandler(NciTransportIrqHandler_t *handler, void *context) {
+  int interruptNumber = digitalPinToInterrupt(_IRQpin);
+
+#ifdef NOT_AN_INTERRUPT
+  if (interruptNumber == NOT_AN_INTERRUPT)
+    return false;
+#endif
+
+  if ((_interruptInstance != NULL) && (_interruptInstance != this))
+    return false;
+
+  this->_irqHandler = handler;
+  this->_irqContext = context;
+  _interruptInstance = this;
+  attachInterrupt(interruptNumber, TwoWireTransport::interruptHandler, RISING);
+  return true;
+}
+
+void TwoWireTransport::detachIrqHandler() {
+  if (_interruptInstance != this)
+    return;
+
+  detachInterrupt(digitalPinToInterrupt(_IRQpin));
+  this->_irqHandler = NULL;
+  _interruptInstance = NULL;
+}
+
+void PN7150_ISR_ATTR TwoWireTransport::interruptHandler() {
+  if ((_interruptInstance != NULL) && (_interruptInstance->_irqHandler != NULL)) {
+    _interruptInstance->_irqSeen = true;
+    _interruptInstance->_irqHandler(_interruptInstance->_irqContext);
+  }
+}
+
+void TwoWireTransport::idle(unsigned long timeout) {
+  unsigned long start = millis();
+
+  /* Neither the bus nor the IRQ pin are touched, delay() lets the core sleep or run other tasks */
+  while (!this->_irqSeen && ((millis() - start) < timeout))
+    delay(1);
+  this->_irqSeen = false;
+}
+
+void TwoWireTransport::setReadStrategy(NxpNci_ReadStrategy_t strategy, uint8_t readSize) {
+  if (readSize > PN7150_SINGLE_READ_SIZE)
+    readSize = PN7150_SINGLE_READ_SIZE;
+  if (readSize < MsgHeaderSize)
+    strategy = READ_SPLIT;
+
+  this->_readStrategy = strategy;
+  this->_singleReadSize = readSize;
+}
+
+NxpNci_ReadStrategy_t TwoWireTransport::getReadStrategy() const {
+  return this->_readStrategy;
+}
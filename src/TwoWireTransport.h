@@ -0,0 +1,112 @@
+/**
+ * NCI transport over the Arduino Wire library and the IRQ/VEN pins
+ * Authors:
+ *        Electronic Cats - electroniccats.com
+ *
+ *  October 2026
+ *
+ * This code is beerware; if you see me (or any other collaborator
+ * member) at the local, and you've found our code helpful,
+ * please buy us a round!
+ * Distributed as-is; no warranty is given.
+ */
+
+#ifndef TwoWireTransport_H
+#define TwoWireTransport_H
+
+#include <Arduino.h>
+
+#include "NciTransport.h"
+
+#if defined(TEENSYDUINO) && defined(KINETISK)  // Teensy 3.0, 3.1, 3.2, 3.5, 3.6 :  Special, more optimized I2C library for Teensy boards
+#include <i2c_t3.h>                            // Credits Brian "nox771" : see https://forum.pjrc.com/threads/21680-New-I2C-library-for-Teensy3
+#else
+#include <Wire.h>
+#endif
+
+#define NO_PN7150_RESET_PIN 255
+
+/* IRQ handlers must live in RAM on Espressif cores */
+#if defined(ESP32) || defined(ESP8266)
+#define PN7150_ISR_ATTR IRAM_ATTR
+#else
+#define PN7150_ISR_ATTR
+#endif
+
+/*
+ * Largest read the Wire library can do in one transaction, frames longer than this are
+ * completed with a second transaction when using READ_SINGLE_TRANSACTION
+ */
+#ifndef PN7150_I2C_READ_SIZE
+#if defined(I2C_RX_BUFFER_LENGTH)  // Teensy i2c_t3
+#define PN7150_I2C_READ_SIZE I2C_RX_BUFFER_LENGTH
+#elif defined(I2C_BUFFER_LENGTH)  // ESP32
+#define PN7150_I2C_READ_SIZE I2C_BUFFER_LENGTH
+#elif defined(WIRE_BUFFER_SIZE)  // RP2040
+#define PN7150_I2C_READ_SIZE WIRE_BUFFER_SIZE
+#elif defined(BUFFER_LENGTH)  // AVR, ESP8266
+#define PN7150_I2C_READ_SIZE BUFFER_LENGTH
+#else
+#define PN7150_I2C_READ_SIZE 32
+#endif
+#endif
+
+/* requestFrom() takes an 8-bit length */
+#if (PN7150_I2C_READ_SIZE > 255)
+#define PN7150_SINGLE_READ_SIZE 255
+#else
+#define PN7150_SINGLE_READ_SIZE PN7150_I2C_READ_SIZE
+#endif
+
+/*
+ * Bytes asked by READ_SINGLE_TRANSACTION when no size is given: header and the short frames
+ * (responses, T2T blocks), longer frames take a second transaction for the rest
+ */
+#ifndef PN7150_DEFAULT_READ_SIZE
+#if (PN7150_SINGLE_READ_SIZE > 35)
+#define PN7150_DEFAULT_READ_SIZE 35
+#else
+#define PN7150_DEFAULT_READ_SIZE PN7150_SINGLE_READ_SIZE
+#endif
+#endif
+
+/*
+ * Definition of the ways readFrame() can get a frame from the PN7150
+ */
+typedef enum {
+  READ_SPLIT,              // Header first, then payload: two I2C transactions per frame
+  READ_SINGLE_TRANSACTION  // Header and payload in one I2C transaction when the frame fits the read size
+} NxpNci_ReadStrategy_t;
+
+class TwoWireTransport : public NciTransport {
+ private:
+  uint8_t _IRQpin, _VENpin, _I2Caddress;
+  TwoWire *_wire;
+  NxpNci_ReadStrategy_t _readStrategy;
+  uint8_t _singleReadSize;
+  NciTransportIrqHandler_t *_irqHandler;
+  void *_irqContext;
+  volatile bool _irqSeen;  // an edge came since the last idle()
+  static TwoWireTransport *_interruptInstance;
+  static void interruptHandler();
+  uint16_t readFrameSplit(uint8_t *frame);
+  uint16_t readFrameSingle(uint8_t *frame);
+
+ public:
+  TwoWireTransport();
+  TwoWireTransport(uint8_t IRQpin, uint8_t VENpin, uint8_t I2Caddress, TwoWire *wire = &Wire);
+  bool begin();
+  uint8_t writeFrame(const uint8_t *frame, uint16_t length);
+  uint16_t readFrame(uint8_t *frame);
+  bool isIrqActive();
+  bool waitForIrq(unsigned long timeout);
+  bool hasVen() const;
+  void setVen(bool level);
+  bool attachIrqHandler(NciTransportIrqHandler_t *handler, void *context);
+  void detachIrqHandler();
+  void idle(unsigned long timeout);
+  void setReadStrategy(NxpNci_ReadStrategy_t strategy, uint8_t readSize = PN7150_DEFAULT_READ_SIZE);
+  NxpNci_ReadStrategy_t getReadStrategy() const;
+};
+
+#endif